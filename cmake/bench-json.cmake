@@ -0,0 +1,12 @@
+# Script mode helper for the bench-json target: tags the run with the
+# current commit, like `make json` in src/benchmark.
+set(COMMIT unknown)
+if(GIT)
+    execute_process(COMMAND ${GIT} rev-parse --short HEAD
+        WORKING_DIRECTORY ${SOURCE}
+        OUTPUT_VARIABLE COMMIT OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+endif()
+execute_process(COMMAND ${BENCH}
+    --benchmark_out=bench-${COMMIT}.json --benchmark_out_format=json
+    --benchmark_context=commit=${COMMIT}
+    COMMAND_ERROR_IS_FATAL ANY)
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 
 template <typename T>
 class ArrayIterator {
@@ -38,24 +42,35 @@ public:
     friend bool operator!=(const ArrayIterator& a, const ArrayIterator& b) { return a._ptr != b._ptr; }
 };
 
+// Grows and shrinks its storage with realloc(), which moves the elements
+// bytewise, so it only holds trivially copyable types.
 template <typename T>
 class MyArray {
+    static_assert(std::is_trivially_copyable_v<T>, "MyArray only holds trivially copyable types");
+
 private:
-    T* _arr;
     int _size;
     int _capacity;
+    T* _arr;
+    [[no_unique_address]] StatsRecorder _stats;
 
 public:
     MyArray()
         : _size(0)
         , _capacity(1)
-        , _arr(new T[_capacity])
+        , _arr((T*)std::malloc(sizeof(T) * _capacity))
     {
+        if (_arr == nullptr)
+            throw std::bad_alloc();
+        _stats.allocation();
     }
 
+    MyArray(const MyArray&) = delete;
+    MyArray& operator=(const MyArray&) = delete;
+
     ~MyArray()
     {
-        delete _arr;
+        std::free(_arr);
     }
 
     int size()
@@ -73,41 +88,50 @@ public:
         return _size == 0;
     }
 
-    T at(const int index)
+    T& at(const int index)
     {
-        if (index > _size)
+        if (index < 0 || index >= _size)
             throw std::invalid_argument("index out of bounds");
         return _arr[index];
     }
 
-    T operator[](const int index)
+    T& operator[](const int index)
     {
         return this->at(index);
     }
 
+    // Unchecked access to the elements, invalidated by anything that grows
+    // or shrinks the array.
+    T* data()
+    {
+        return _arr;
+    }
+
     ArrayIterator<T> begin() { return ArrayIterator<T>(&_arr[0]); }
 
     ArrayIterator<T> end() { return ArrayIterator<T>(&_arr[_size]); }
 
     void push(const T item)
     {
+        auto timer = _stats.time(Operation::Insert);
+        if (_size + 1 == _capacity)
+            this->resize(_capacity * 2);
         _arr[_size] = item;
         _size++;
-        if (_size == _capacity)
-            this->resize(_capacity * 2);
     }
 
     void insert(const int index, const T item)
     {
+        auto timer = _stats.time(Operation::Insert);
         if (index > _size)
             throw std::invalid_argument("index out of size");
-        for (int i = _size; i >= index; i--) {
-            _arr[i + 1] = _arr[i];
+        if (_size + 1 == _capacity)
+            this->resize(_capacity * 2);
+        for (int i = _size; i > index; i--) {
+            _arr[i] = _arr[i - 1];
         }
         _arr[index] = item;
         _size++;
-        if (_size == _capacity)
-            this->resize(_capacity * 2);
     }
 
     void prepend(const T item)
@@ -117,6 +141,7 @@ public:
 
     void pop()
     {
+        auto timer = _stats.time(Operation::Remove);
         _size--;
         if (_size < _capacity / 4)
             this->resize(_capacity / 2);
@@ -135,6 +160,7 @@ public:
     void remove(const T item)
     {
         for (int i = 0; i < _size; i++) {
+            _stats.comparison();
             if (_arr[i] == item) {
                 this->del(i);
                 i--;
@@ -144,7 +170,9 @@ public:
 
     int find(const T item)
     {
+        auto timer = _stats.time(Operation::Lookup);
         for (int i = 0; i < _size; i++) {
+            _stats.comparison();
             if (_arr[i] == item) {
                 return i;
             }
@@ -152,10 +180,39 @@ public:
         return -1;
     }
 
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const
+    {
+        return _stats.stats();
+    }
+
+    void reset_stats()
+    {
+        _stats.reset();
+    }
+
+    // Unused capacity counts as slack.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        usage.m_elements = _size;
+        usage.m_payload = uint64_t(_size) * sizeof(T);
+        usage.m_overhead = sizeof(*this);
+        usage.m_slack = uint64_t(_capacity - _size) * sizeof(T);
+        usage.allocations(uint64_t(_capacity) * sizeof(T));
+        return usage;
+    }
+
 private:
     void resize(const int new_capacity)
     {
-        _arr = (T*)std::realloc(_arr, sizeof(T) * new_capacity);
+        _stats.resize();
+        _stats.allocation();
+        _stats.deallocation();
+        T* arr = (T*)std::realloc(_arr, sizeof(T) * new_capacity);
+        if (arr == nullptr)
+            throw std::bad_alloc();
+        _arr = arr;
         _capacity = new_capacity;
     }
 };
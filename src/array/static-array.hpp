@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include <stdexcept>
+
+// MyArray with its capacity fixed at compile time. The elements are stored
+// inline, so it never touches the heap and can be put on the stack, in a
+// static or in a shared memory segment; with a trivially copyable T it is
+// trivially copyable too. Every operation is constexpr.
+//
+// All N slots are value initialized up front, so T has to be default
+// constructible. Pushing into a full array throws std::length_error.
+template <typename T, int N>
+class StaticArray {
+    static_assert(N > 0, "a static array needs at least one slot");
+
+private:
+    int m_size = 0;
+    T m_arr[N] {};
+
+public:
+    constexpr StaticArray() = default;
+
+    constexpr int size() const
+    {
+        return m_size;
+    }
+
+    static constexpr int capacity()
+    {
+        return N;
+    }
+
+    constexpr bool is_empty() const
+    {
+        return m_size == 0;
+    }
+
+    constexpr bool full() const
+    {
+        return m_size == N;
+    }
+
+    constexpr T& at(const int index)
+    {
+        if (index < 0 || index >= m_size)
+            throw std::invalid_argument("index out of bounds");
+        return m_arr[index];
+    }
+
+    constexpr const T& at(const int index) const
+    {
+        if (index < 0 || index >= m_size)
+            throw std::invalid_argument("index out of bounds");
+        return m_arr[index];
+    }
+
+    constexpr T& operator[](const int index)
+    {
+        return this->at(index);
+    }
+
+    constexpr const T& operator[](const int index) const
+    {
+        return this->at(index);
+    }
+
+    constexpr T* data() { return m_arr; }
+    constexpr const T* data() const { return m_arr; }
+
+    constexpr T* begin() { return m_arr; }
+    constexpr T* end() { return m_arr + m_size; }
+    constexpr const T* begin() const { return m_arr; }
+    constexpr const T* end() const { return m_arr + m_size; }
+
+    constexpr void push(const T item)
+    {
+        if (full())
+            throw std::length_error("static array is full");
+        m_arr[m_size] = item;
+        m_size++;
+    }
+
+    constexpr void insert(const int index, const T item)
+    {
+        if (index < 0 || index > m_size)
+            throw std::invalid_argument("index out of size");
+        if (full())
+            throw std::length_error("static array is full");
+        for (int i = m_size; i > index; i--) {
+            m_arr[i] = m_arr[i - 1];
+        }
+        m_arr[index] = item;
+        m_size++;
+    }
+
+    constexpr void prepend(const T item)
+    {
+        this->insert(0, item);
+    }
+
+    constexpr void pop()
+    {
+        m_size--;
+    }
+
+    constexpr void del(const int index)
+    {
+        for (int i = index; i < m_size - 1; i++) {
+            m_arr[i] = m_arr[i + 1];
+        }
+        this->pop();
+    }
+
+    constexpr void remove(const T item)
+    {
+        int kept = 0;
+        for (int i = 0; i < m_size; i++) {
+            if (!(m_arr[i] == item))
+                m_arr[kept++] = m_arr[i];
+        }
+        m_size = kept;
+    }
+
+    constexpr int find(const T item) const
+    {
+        for (int i = 0; i < m_size; i++) {
+            if (m_arr[i] == item)
+                return i;
+        }
+        return -1;
+    }
+
+    constexpr void clear()
+    {
+        m_size = 0;
+    }
+
+    // No heap blocks, the unused slots count as slack.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        usage.m_elements = m_size;
+        usage.m_payload = uint64_t(m_size) * sizeof(T);
+        usage.m_slack = uint64_t(N - m_size) * sizeof(T);
+        usage.m_overhead = sizeof(*this) - uint64_t(N) * sizeof(T);
+        return usage;
+    }
+};
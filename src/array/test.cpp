@@ -0,0 +1,74 @@
+#include "static-array.hpp"
+#include <gtest/gtest.h>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<StaticArray<int, 8>>);
+static_assert(sizeof(StaticArray<int, 8>) == sizeof(int) * 9);
+
+static constexpr StaticArray<int, 8> squares()
+{
+    StaticArray<int, 8> array;
+    for (int i = 0; i < 8; i++)
+        array.push(i * i);
+    array.del(0);
+    array.prepend(-1);
+    array.remove(4);
+    return array;
+}
+
+static_assert(squares().size() == 7);
+static_assert(squares()[0] == -1);
+static_assert(squares().find(9) == 2);
+static_assert(squares().find(4) == -1);
+
+TEST(StaticArray, PushPop)
+{
+    StaticArray<int, 4> array;
+    EXPECT_TRUE(array.is_empty());
+
+    for (int i = 0; i < 4; i++)
+        array.push(i);
+    EXPECT_TRUE(array.full());
+    EXPECT_THROW(array.push(4), std::length_error);
+    EXPECT_THROW(array.insert(0, 4), std::length_error);
+
+    array.pop();
+    EXPECT_EQ(array.size(), 3);
+    EXPECT_THROW(array.at(3), std::invalid_argument);
+
+    int sum = 0;
+    for (int value : array)
+        sum += value;
+    EXPECT_EQ(sum, 3);
+}
+
+TEST(StaticArray, InsertDel)
+{
+    StaticArray<int, 8> array;
+    array.push(1);
+    array.push(3);
+    array.insert(1, 2);
+    array.prepend(0);
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(array[i], i);
+
+    array.del(1);
+    EXPECT_EQ(array.size(), 3);
+    EXPECT_EQ(array[1], 2);
+    EXPECT_EQ(array.find(1), -1);
+
+    array.clear();
+    EXPECT_TRUE(array.is_empty());
+}
+
+TEST(StaticArray, MemoryUsage)
+{
+    StaticArray<int64_t, 8> array;
+    array.push(1);
+    array.push(2);
+
+    MemoryUsage usage = array.memory_usage();
+    EXPECT_EQ(usage.m_payload, 16);
+    EXPECT_EQ(usage.m_slack, 48);
+    EXPECT_EQ(usage.total(), sizeof(array));
+}
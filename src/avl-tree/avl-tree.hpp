@@ -1,3 +1,7 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
 #include <iostream>
 #include <memory>
 #include <stack>
@@ -22,6 +26,12 @@ public:
 
     void print(std::ostream& out = std::cout) const;
 
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const { return recorder.stats(); }
+    void resetStats() { recorder.reset(); }
+
+    MemoryUsage memoryUsage() const;
+
     AVLTree& operator=(const AVLTree&);
     AVLTree& operator=(AVLTree&&) = default;
 
@@ -45,6 +55,9 @@ private:
     };
 
     std::shared_ptr<Node> root;
+    [[no_unique_address]] mutable StatsRecorder recorder;
+
+    int compare(const T& value, const T& other) const;
 
     void insert(const T& value, std::shared_ptr<Node>& root);
     void insert(T&& value, std::shared_ptr<Node>& root);
@@ -163,9 +176,23 @@ std::shared_ptr<struct AVLTree<T>::Node> AVLTree<T>::copy(std::shared_ptr<Node>
 template <typename T>
 void AVLTree<T>::insert(const T& value)
 {
+    auto timer = recorder.time(Operation::Insert);
     insert(value, root);
 }
 
+// Three way comparison with T's < and >, counting the node visit and the
+// comparisons actually made.
+template <typename T>
+int AVLTree<T>::compare(const T& value, const T& other) const
+{
+    recorder.visit();
+    recorder.comparison();
+    if (value < other)
+        return -1;
+    recorder.comparison();
+    return value > other ? 1 : 0;
+}
+
 template <typename T>
 int AVLTree<T>::height(std::shared_ptr<Node> root) const
 {
@@ -175,6 +202,7 @@ int AVLTree<T>::height(std::shared_ptr<Node> root) const
 template <typename T>
 void AVLTree<T>::rotateLeftChild(std::shared_ptr<Node>& root)
 {
+    recorder.rotation();
     auto tmp = root->left;
     root->left = tmp->right;
     tmp->right = root;
@@ -186,6 +214,7 @@ void AVLTree<T>::rotateLeftChild(std::shared_ptr<Node>& root)
 template <typename T>
 void AVLTree<T>::rotateRightChild(std::shared_ptr<Node>& root)
 {
+    recorder.rotation();
     auto tmp = root->right;
     root->right = tmp->left;
     tmp->left = root;
@@ -213,16 +242,17 @@ void AVLTree<T>::balance(std::shared_ptr<Node>& root)
 {
     if (root == nullptr)
         return;
-    if (height(root->left) - height(root->right) > ALLOWED_INBALANCE)
+    if (height(root->left) - height(root->right) > ALLOWED_INBALANCE) {
         if (height(root->left->left) >= height(root->left->right))
             rotateLeftChild(root);
         else
             doubleLeftChild(root);
-    else if (height(root->right) - height(root->left) > ALLOWED_INBALANCE)
+    } else if (height(root->right) - height(root->left) > ALLOWED_INBALANCE) {
         if (height(root->right->right) >= height(root->right->left))
             rotateRightChild(root);
         else
             doubleRightChild(root);
+    }
 
     root->height = std::max(height(root->left), height(root->right)) + 1;
 }
@@ -231,10 +261,11 @@ template <typename T>
 void AVLTree<T>::insert(const T& value, std::shared_ptr<Node>& root)
 {
     if (root == nullptr) {
+        recorder.allocation(2);
         root = std::make_shared<Node>(std::make_unique<T>(value));
-    } else if (value < *(root->value)) {
+    } else if (int order = compare(value, *root->value); order < 0) {
         insert(value, root->left);
-    } else if (value > *(root->value)) {
+    } else if (order > 0) {
         insert(value, root->right);
     }
     balance(root);
@@ -243,6 +274,7 @@ void AVLTree<T>::insert(const T& value, std::shared_ptr<Node>& root)
 template <typename T>
 void AVLTree<T>::insert(T&& value)
 {
+    auto timer = recorder.time(Operation::Insert);
     insert(std::move(value), root);
 }
 
@@ -250,10 +282,11 @@ template <typename T>
 void AVLTree<T>::insert(T&& value, std::shared_ptr<Node>& root)
 {
     if (root == nullptr) {
+        recorder.allocation(2);
         root = std::make_shared<Node>(std::make_unique<T>(std::move(value)));
-    } else if (value < *root->value) {
+    } else if (int order = compare(value, *root->value); order < 0) {
         insert(std::move(value), root->left);
-    } else if (value > *root->value) {
+    } else if (order > 0) {
         insert(std::move(value), root->right);
     }
 
@@ -263,20 +296,23 @@ void AVLTree<T>::insert(T&& value, std::shared_ptr<Node>& root)
 template <typename T>
 void AVLTree<T>::remove(const T& value)
 {
+    auto timer = recorder.time(Operation::Remove);
     remove(value, root);
 }
 
 template <typename T>
 void AVLTree<T>::remove(const T& value, std::shared_ptr<Node>& root)
 {
-    if (value < *root->value) {
+    int order = compare(value, *root->value);
+    if (order < 0) {
         remove(value, root->left);
-    } else if (value > *root->value) {
+    } else if (order > 0) {
         remove(value, root->right);
     } else if (root->left != nullptr && root->right != nullptr) {
         *root->value = *findMin(root->right)->value;
         remove(*root->value, root->right);
     } else {
+        recorder.deallocation(2);
         root = root->left == nullptr ? root->right : root->left;
     }
     balance(root);
@@ -319,22 +355,52 @@ std::shared_ptr<struct AVLTree<T>::Node> AVLTree<T>::findMin(std::shared_ptr<Nod
 template <typename T>
 bool AVLTree<T>::contains(const T& value) const
 {
+    auto timer = recorder.time(Operation::Lookup);
     return contains(value, root);
 }
 
 template <typename T>
 bool AVLTree<T>::contains(const T& value, std::shared_ptr<Node> root) const
 {
-    if (root == nullptr) {
+    if (root == nullptr)
         return false;
-    } else if (value < *(root->value)) {
-        contains(value, root->left);
-    } else if (value > *(root->value)) {
-        contains(value, root->right);
-    }
+    int order = compare(value, *root->value);
+    if (order < 0)
+        return contains(value, root->left);
+    if (order > 0)
+        return contains(value, root->right);
     return true;
 }
 
+// Every node is two allocations: make_shared puts the node after its control
+// block, and the value sits in its own block behind the unique_ptr. Walks
+// the tree.
+template <typename T>
+MemoryUsage AVLTree<T>::memoryUsage() const
+{
+    uint64_t nodes = 0;
+    std::stack<Node*> pending;
+    if (root != nullptr)
+        pending.push(root.get());
+    while (!pending.empty()) {
+        Node* node = pending.top();
+        pending.pop();
+        nodes++;
+        if (node->left != nullptr)
+            pending.push(node->left.get());
+        if (node->right != nullptr)
+            pending.push(node->right.get());
+    }
+
+    MemoryUsage usage;
+    usage.m_elements = nodes;
+    usage.m_payload = nodes * sizeof(T);
+    usage.m_overhead = nodes * (SHARED_CONTROL_BLOCK + sizeof(Node)) + sizeof(*this);
+    usage.allocations(SHARED_CONTROL_BLOCK + sizeof(Node), nodes);
+    usage.allocations(sizeof(T), nodes);
+    return usage;
+}
+
 template <typename T>
 bool AVLTree<T>::isEmpty() const
 {
@@ -0,0 +1,334 @@
+#include "../array/array.hpp"
+#include "../avl-tree/avl-tree.hpp"
+#include "../binary-search-tree/binary-search-tree.hpp"
+#include "../heap/heap.hpp"
+#include "../linked-list/linked-list.hpp"
+#include "../queue/queue-arr.hpp"
+#include "../queue/queue-deque.hpp"
+#include "../queue/queue-list.hpp"
+#include "../radix-tree/radix-tree.hpp"
+#include "../sparse-matrix/coo-builder.hpp"
+#include "../sparse-matrix/csr-matrix.hpp"
+#include "../sparse-matrix/sparse-matrix.hpp"
+#include "workload.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <list>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Every container next to its std:: counterpart on the same keys. Arguments
+// are (size, pattern), the pattern is also the label, so JSON output from two
+// commits can be matched up by name.
+
+static const Pattern all_patterns[] = { Pattern::Uniform, Pattern::Sorted, Pattern::Reverse,
+    Pattern::Zipfian, Pattern::Adversarial };
+
+// Sizes 1K to 64K for every pattern. Ordered patterns stop at OrderedLimit
+// for containers that go quadratic on them.
+template <int64_t OrderedLimit = 1 << 16>
+static void sizes(benchmark::internal::Benchmark* bench)
+{
+    for (Pattern pattern : all_patterns) {
+        bool ordered = pattern != Pattern::Uniform && pattern != Pattern::Zipfian;
+        for (int64_t size = 1 << 10; size <= (ordered ? OrderedLimit : 1 << 16); size *= 8)
+            bench->Args({ size, int64_t(pattern) });
+    }
+}
+
+static std::vector<int> keys(benchmark::State& state)
+{
+    Pattern pattern = Pattern(state.range(1));
+    state.SetLabel(pattern_name(pattern));
+    return make_keys(pattern, state.range(0));
+}
+
+// Sequences: append every key, then one pass over them.
+
+template <typename Sequence>
+static void append(Sequence& sequence, int key)
+{
+    if constexpr (requires { sequence.push(key); })
+        sequence.push(key);
+    else
+        sequence.push_back(key);
+}
+
+template <typename Sequence>
+static void BM_AppendScan(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        Sequence sequence;
+        for (int key : input)
+            append(sequence, key);
+        int64_t sum = 0;
+        for (auto& item : sequence) {
+            if constexpr (requires { item.m_value; })
+                sum += item.m_value;
+            else
+                sum += item;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_AppendScan, MyArray<int>)->Apply(sizes<>);
+BENCHMARK_TEMPLATE(BM_AppendScan, std::vector<int>)->Apply(sizes<>);
+BENCHMARK_TEMPLATE(BM_AppendScan, LinkedList<int>)->Apply(sizes<>);
+BENCHMARK_TEMPLATE(BM_AppendScan, std::list<int>)->Apply(sizes<>);
+
+// Sorting, where the pattern matters most.
+
+static void BM_SortMyArray(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        MyArray<int> array;
+        for (int key : input)
+            array.push(key);
+        state.ResumeTiming();
+        std::sort(array.data(), array.data() + array.size());
+        benchmark::DoNotOptimize(array.data());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_SortMyArray)->Apply(sizes<>);
+
+static void BM_SortLinkedList(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        LinkedList<int> list;
+        for (int key : input)
+            list.push_back(key);
+        state.ResumeTiming();
+        list.sort([](int left, int right) { return left < right; });
+        benchmark::DoNotOptimize(list.front());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_SortLinkedList)->Apply(sizes<>);
+
+static void BM_SortStdList(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::list<int> list(input.begin(), input.end());
+        state.ResumeTiming();
+        list.sort();
+        benchmark::DoNotOptimize(list.front());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_SortStdList)->Apply(sizes<>);
+
+// Queues: enqueue every key, then drain. The pattern does not change the
+// work, so only uniform keys run.
+
+template <typename Queue>
+static void BM_QueueFillDrain(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        Queue queue = [&]() {
+            if constexpr (std::is_constructible_v<Queue, size_t>)
+                return Queue(input.size() + 1);
+            else
+                return Queue();
+        }();
+        for (int key : input) {
+            if constexpr (requires { queue.enqueue(key); })
+                queue.enqueue(key);
+            else
+                queue.push(key);
+        }
+        int64_t sum = 0;
+        while (!queue.empty()) {
+            if constexpr (requires { queue.dequeue(); }) {
+                sum += queue.dequeue();
+            } else {
+                sum += queue.front();
+                queue.pop();
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+static void uniform_sizes(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t size = 1 << 10; size <= 1 << 16; size *= 8)
+        bench->Args({ size, int64_t(Pattern::Uniform) });
+}
+BENCHMARK_TEMPLATE(BM_QueueFillDrain, ArrQueue<int>)->Apply(uniform_sizes);
+BENCHMARK_TEMPLATE(BM_QueueFillDrain, ListQueue<int>)->Apply(uniform_sizes);
+BENCHMARK_TEMPLATE(BM_QueueFillDrain, std::queue<int>)->Apply(uniform_sizes);
+
+// Ordered sets: insert every key, then look every key up and check that all
+// of them are found.
+
+template <typename Set>
+static void BM_SetInsertContains(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        Set set;
+        for (int key : input)
+            set.insert(key);
+        int64_t found = 0;
+        for (int key : input)
+            found += set.contains(key);
+        benchmark::DoNotOptimize(found);
+        if (found != int64_t(input.size())) {
+            state.SkipWithError("contains() missed an inserted key");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * input.size() * 2);
+}
+// The unbalanced tree recurses once per level, ordered keys make that as
+// deep as the tree is large.
+BENCHMARK_TEMPLATE(BM_SetInsertContains, BinarySTree<int>)->Apply(sizes<1 << 12>);
+BENCHMARK_TEMPLATE(BM_SetInsertContains, AVLTree<int>)->Apply(sizes<>);
+BENCHMARK_TEMPLATE(BM_SetInsertContains, RadixTree<int>)->Apply(sizes<>);
+BENCHMARK_TEMPLATE(BM_SetInsertContains, std::set<int>)->Apply(sizes<>);
+
+// Sparse matrices: a key k goes to line k % 1024, column k / 1024, then every
+// cell is read back.
+
+static void BM_SparceMatrix(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        SparceMatrix<int> matrix(0, 1024);
+        for (int key : input)
+            matrix.insert(key % 1024, key / 1024, key + 1);
+        int64_t sum = 0;
+        for (int key : input)
+            sum += matrix.get(key % 1024, key / 1024);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * input.size() * 2);
+}
+BENCHMARK(BM_SparceMatrix)->Apply(sizes<>);
+
+static void BM_StdUnorderedMapMatrix(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    for (auto _ : state) {
+        std::unordered_map<uint64_t, int> matrix;
+        for (int key : input)
+            matrix[(uint64_t(key % 1024) << 32) | (key / 1024)] = key + 1;
+        int64_t sum = 0;
+        for (int key : input) {
+            auto it = matrix.find((uint64_t(key % 1024) << 32) | (key / 1024));
+            sum += it == matrix.end() ? 0 : it->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * input.size() * 2);
+}
+BENCHMARK(BM_StdUnorderedMapMatrix)->Apply(sizes<>);
+
+// Memory footprint: fill with uniform keys, then report memory_usage() per
+// stored element as counters. The time is the fill, only the counters matter.
+// Sparse layouts use the line/column split of BM_SparceMatrix.
+
+static void report(benchmark::State& state, const MemoryUsage& usage)
+{
+    double elements = usage.m_elements;
+    state.counters["elements"] = elements;
+    state.counters["bytes_per_element"] = usage.bytes_per_element();
+    state.counters["payload_per_element"] = usage.m_payload / elements;
+    state.counters["overhead_per_element"] = usage.m_overhead / elements;
+    state.counters["slack_per_element"] = usage.m_slack / elements;
+}
+
+template <typename Container>
+static void fill(Container& container, int key)
+{
+    if constexpr (requires { container.insert(key); })
+        container.insert(key);
+    else if constexpr (requires { container.insert(0u, 0u, key); })
+        container.insert(key % 1024, key / 1024, key + 1);
+    else
+        append(container, key);
+}
+
+template <typename Container>
+static MemoryUsage usage_of(const Container& container)
+{
+    if constexpr (requires { container.memoryUsage(); })
+        return container.memoryUsage();
+    else
+        return container.memory_usage();
+}
+
+template <typename Container>
+static void BM_Footprint(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    MemoryUsage usage;
+    for (auto _ : state) {
+        Container container = [] {
+            if constexpr (std::is_same_v<Container, SparceMatrix<int>>)
+                return Container(0, 1024);
+            else
+                return Container();
+        }();
+        for (int key : input)
+            fill(container, key);
+        usage = usage_of(container);
+    }
+    report(state, usage);
+}
+
+static void footprint_sizes(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t size = 1 << 10; size <= 1 << 20; size *= 32)
+        bench->Args({ size, int64_t(Pattern::Uniform) })->Iterations(1);
+}
+BENCHMARK_TEMPLATE(BM_Footprint, MyArray<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, LinkedList<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, BlockDeque<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, DaryHeap<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, BinarySTree<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, AVLTree<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, RadixTree<int>)->Apply(footprint_sizes);
+BENCHMARK_TEMPLATE(BM_Footprint, SparceMatrix<int>)->Apply(footprint_sizes);
+
+// The same nonzeros as compressed rows and as a sorted coordinate tensor.
+static void BM_FootprintCSR(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    MemoryUsage usage;
+    for (auto _ : state) {
+        COOBuilder<int> builder(0, 1024, 1 << 21);
+        for (int key : input)
+            builder.add(key % 1024, key / 1024, key + 1);
+        usage = builder.build_csr().memory_usage();
+    }
+    report(state, usage);
+}
+BENCHMARK(BM_FootprintCSR)->Apply(footprint_sizes);
+
+static void BM_FootprintCOO(benchmark::State& state)
+{
+    std::vector<int> input = keys(state);
+    MemoryUsage usage;
+    for (auto _ : state) {
+        COOBuilder<int> builder(0, 1024, 1 << 21);
+        for (int key : input)
+            builder.add(key % 1024, key / 1024, key + 1);
+        usage = builder.build().memory_usage();
+    }
+    report(state, usage);
+}
+BENCHMARK(BM_FootprintCOO)->Apply(footprint_sizes);
@@ -0,0 +1,53 @@
+#include "workload.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <map>
+
+TEST(Workload, Ordered)
+{
+    std::vector<int> sorted = make_keys(Pattern::Sorted, 100);
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+    EXPECT_EQ(sorted.front(), 0);
+    EXPECT_EQ(sorted.back(), 99);
+
+    std::vector<int> reverse = make_keys(Pattern::Reverse, 100);
+    EXPECT_TRUE(std::is_sorted(reverse.rbegin(), reverse.rend()));
+    EXPECT_EQ(reverse.front(), 99);
+
+    std::vector<int> adversarial = make_keys(Pattern::Adversarial, 101);
+    EXPECT_EQ(std::vector<int>(adversarial.begin(), adversarial.begin() + 5), (std::vector<int> { 0, 100, 1, 99, 2 }));
+    std::sort(adversarial.begin(), adversarial.end());
+    EXPECT_EQ(adversarial, make_keys(Pattern::Sorted, 101));
+}
+
+TEST(Workload, Random)
+{
+    for (Pattern pattern : { Pattern::Uniform, Pattern::Zipfian }) {
+        std::vector<int> keys = make_keys(pattern, 10000);
+        EXPECT_EQ(keys.size(), 10000);
+        EXPECT_EQ(keys, make_keys(pattern, 10000));
+        EXPECT_NE(keys, make_keys(pattern, 10000, 7));
+        EXPECT_TRUE(std::all_of(keys.begin(), keys.end(), [](int key) { return key >= 0; }));
+    }
+}
+
+// With theta 0.99 over 10000 keys the hottest key takes about 10% of the
+// draws and the top ten about a third, uniform keys almost never repeat.
+TEST(Workload, ZipfianSkew)
+{
+    std::map<int, int> counts;
+    for (int key : make_keys(Pattern::Zipfian, 10000))
+        counts[key]++;
+    std::vector<int> frequencies;
+    for (auto& [key, count] : counts)
+        frequencies.push_back(count);
+    std::sort(frequencies.rbegin(), frequencies.rend());
+    EXPECT_GT(frequencies[0], 700);
+    EXPECT_LT(frequencies[0], 1300);
+    EXPECT_GT(frequencies[0] + frequencies[1] + frequencies[2], frequencies[0] * 3 / 2);
+
+    std::map<int, int> uniform;
+    for (int key : make_keys(Pattern::Uniform, 10000))
+        uniform[key]++;
+    EXPECT_GT(uniform.size(), 9990);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Key sequences shared by every benchmark, so containers are compared on
+// exactly the same input.
+enum class Pattern {
+    Uniform,
+    Sorted,
+    Reverse,
+    Zipfian,
+    Adversarial
+};
+
+inline const char* pattern_name(Pattern pattern)
+{
+    switch (pattern) {
+    case Pattern::Uniform:
+        return "uniform";
+    case Pattern::Sorted:
+        return "sorted";
+    case Pattern::Reverse:
+        return "reverse";
+    case Pattern::Zipfian:
+        return "zipfian";
+    case Pattern::Adversarial:
+        return "adversarial";
+    }
+    throw std::invalid_argument("unknown pattern");
+}
+
+// Zipf distributed ranks in [0, count), rank 0 the most frequent, with the
+// rejection free method of Gray et al. from "Quickly Generating
+// Billion-Record Synthetic Databases", as used by YCSB.
+class ZipfGenerator {
+private:
+    uint64_t m_count;
+    double m_theta;
+    double m_zeta;
+    double m_alpha;
+    double m_eta;
+    std::uniform_real_distribution<double> m_uniform;
+
+    static double zeta(uint64_t count, double theta)
+    {
+        double sum = 0;
+        for (uint64_t i = 1; i <= count; i++)
+            sum += 1.0 / std::pow(double(i), theta);
+        return sum;
+    }
+
+public:
+    ZipfGenerator(uint64_t count, double theta = 0.99)
+        : m_count(count)
+        , m_theta(theta)
+        , m_zeta(zeta(count, theta))
+        , m_alpha(1.0 / (1.0 - theta))
+        , m_eta((1.0 - std::pow(2.0 / count, 1.0 - theta)) / (1.0 - zeta(2, theta) / m_zeta))
+    {
+    }
+
+    template <typename Random>
+    uint64_t operator()(Random& random)
+    {
+        double u = m_uniform(random);
+        double uz = u * m_zeta;
+        if (uz < 1.0)
+            return 0;
+        if (uz < 1.0 + std::pow(0.5, m_theta))
+            return 1;
+        return std::min<uint64_t>(m_count - 1, uint64_t(m_count * std::pow(m_eta * u - m_eta + 1.0, m_alpha)));
+    }
+};
+
+// count keys in the given pattern, all in [0, 2^31).
+//  - uniform: independent uniform keys, a few repeats.
+//  - sorted, reverse: 0 .. count - 1 ascending or descending.
+//  - zipfian: skewed repeats of count distinct keys, the hot ones scattered
+//    over the key space rather than being the smallest.
+//  - adversarial: 0, count - 1, 1, count - 2, ... Every prefix of it is a
+//    zig-zag path in an unbalanced search tree, and it defeats first, last
+//    and middle element pivots.
+inline std::vector<int> make_keys(Pattern pattern, uint64_t count, uint64_t seed = 42)
+{
+    std::vector<int> keys(count);
+    std::mt19937_64 random(seed);
+    switch (pattern) {
+    case Pattern::Uniform:
+        for (auto& key : keys)
+            key = int(random() & 0x7fffffff);
+        break;
+    case Pattern::Sorted:
+        std::iota(keys.begin(), keys.end(), 0);
+        break;
+    case Pattern::Reverse:
+        std::iota(keys.rbegin(), keys.rend(), 0);
+        break;
+    case Pattern::Zipfian: {
+        ZipfGenerator zipf(count);
+        for (auto& key : keys)
+            key = int((zipf(random) * 2654435761u) & 0x7fffffff);
+        break;
+    }
+    case Pattern::Adversarial:
+        for (uint64_t i = 0; i < count; i++)
+            keys[i] = int(i % 2 == 0 ? i / 2 : count - 1 - i / 2);
+        break;
+    }
+    return keys;
+}
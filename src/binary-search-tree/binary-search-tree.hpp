@@ -1,3 +1,5 @@
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
 #include <iostream>
 #include <memory>
 #include <stack>
@@ -22,6 +24,12 @@ public:
 
     void print(std::ostream& out = std::cout) const;
 
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const { return recorder.stats(); }
+    void resetStats() { recorder.reset(); }
+
+    MemoryUsage memoryUsage() const;
+
     BinarySTree& operator=(const BinarySTree&);
     BinarySTree& operator=(BinarySTree&&) = default;
 
@@ -42,6 +50,9 @@ private:
     };
 
     std::shared_ptr<Node> root;
+    [[no_unique_address]] mutable StatsRecorder recorder;
+
+    int compare(const T& value, const T& other) const;
 
     void insert(const T& value, std::shared_ptr<Node>& root);
     void insert(T&& value, std::shared_ptr<Node>& root);
@@ -152,17 +163,32 @@ std::shared_ptr<struct BinarySTree<T>::Node> BinarySTree<T>::copy(std::shared_pt
 template <typename T>
 void BinarySTree<T>::insert(const T& value)
 {
+    auto timer = recorder.time(Operation::Insert);
     insert(value, root);
 }
 
+// Three way comparison with T's < and >, counting the node visit and the
+// comparisons actually made.
+template <typename T>
+int BinarySTree<T>::compare(const T& value, const T& other) const
+{
+    recorder.visit();
+    recorder.comparison();
+    if (value < other)
+        return -1;
+    recorder.comparison();
+    return value > other ? 1 : 0;
+}
+
 template <typename T>
 void BinarySTree<T>::insert(const T& value, std::shared_ptr<Node>& root)
 {
     if (root == nullptr) {
+        recorder.allocation(2);
         root = std::make_shared<Node>(std::make_unique<T>(value));
-    } else if (value < *(root->value)) {
+    } else if (int order = compare(value, *root->value); order < 0) {
         insert(value, root->left);
-    } else if (value > *(root->value)) {
+    } else if (order > 0) {
         insert(value, root->right);
     }
 }
@@ -170,6 +196,7 @@ void BinarySTree<T>::insert(const T& value, std::shared_ptr<Node>& root)
 template <typename T>
 void BinarySTree<T>::insert(T&& value)
 {
+    auto timer = recorder.time(Operation::Insert);
     insert(std::move(value), root);
 }
 
@@ -177,10 +204,11 @@ template <typename T>
 void BinarySTree<T>::insert(T&& value, std::shared_ptr<Node>& root)
 {
     if (root == nullptr) {
+        recorder.allocation(2);
         root = std::make_shared<Node>(std::make_unique<T>(std::move(value)));
-    } else if (value < *root->value) {
+    } else if (int order = compare(value, *root->value); order < 0) {
         insert(std::move(value), root->left);
-    } else if (value > *root->value) {
+    } else if (order > 0) {
         insert(std::move(value), root->right);
     }
 }
@@ -188,20 +216,23 @@ void BinarySTree<T>::insert(T&& value, std::shared_ptr<Node>& root)
 template <typename T>
 void BinarySTree<T>::remove(const T& value)
 {
+    auto timer = recorder.time(Operation::Remove);
     remove(value, root);
 }
 
 template <typename T>
 void BinarySTree<T>::remove(const T& value, std::shared_ptr<Node>& root)
 {
-    if (value < *root->value) {
+    int order = compare(value, *root->value);
+    if (order < 0) {
         remove(value, root->left);
-    } else if (value > *root->value) {
+    } else if (order > 0) {
         remove(value, root->right);
     } else if (root->left != nullptr && root->right != nullptr) {
         *root->value = *findMin(root->right)->value;
         remove(*root->value, root->right);
     } else {
+        recorder.deallocation(2);
         root = root->left == nullptr ? root->right : root->left;
     }
 }
@@ -243,22 +274,52 @@ std::shared_ptr<struct BinarySTree<T>::Node> BinarySTree<T>::findMin(std::shared
 template <typename T>
 bool BinarySTree<T>::contains(const T& value) const
 {
+    auto timer = recorder.time(Operation::Lookup);
     return contains(value, root);
 }
 
 template <typename T>
 bool BinarySTree<T>::contains(const T& value, std::shared_ptr<Node> root) const
 {
-    if (root == nullptr) {
+    if (root == nullptr)
         return false;
-    } else if (value < *(root->value)) {
-        contains(value, root->left);
-    } else if (value > *(root->value)) {
-        contains(value, root->right);
-    }
+    int order = compare(value, *root->value);
+    if (order < 0)
+        return contains(value, root->left);
+    if (order > 0)
+        return contains(value, root->right);
     return true;
 }
 
+// Every node is two allocations: make_shared puts the node after its control
+// block, and the value sits in its own block behind the unique_ptr. Walks
+// the tree.
+template <typename T>
+MemoryUsage BinarySTree<T>::memoryUsage() const
+{
+    uint64_t nodes = 0;
+    std::stack<Node*> pending;
+    if (root != nullptr)
+        pending.push(root.get());
+    while (!pending.empty()) {
+        Node* node = pending.top();
+        pending.pop();
+        nodes++;
+        if (node->left != nullptr)
+            pending.push(node->left.get());
+        if (node->right != nullptr)
+            pending.push(node->right.get());
+    }
+
+    MemoryUsage usage;
+    usage.m_elements = nodes;
+    usage.m_payload = nodes * sizeof(T);
+    usage.m_overhead = nodes * (SHARED_CONTROL_BLOCK + sizeof(Node)) + sizeof(*this);
+    usage.allocations(SHARED_CONTROL_BLOCK + sizeof(Node), nodes);
+    usage.allocations(sizeof(T), nodes);
+    return usage;
+}
+
 template <typename T>
 bool BinarySTree<T>::isEmpty() const
 {
@@ -16,6 +16,17 @@ TEST_F(BinarySearchTreeTest, Contains)
     ASSERT_TRUE(tree.contains(7));
 }
 
+TEST_F(BinarySearchTreeTest, ContainsMissing)
+{
+    tree.insert(3);
+    tree.insert(11);
+    EXPECT_TRUE(tree.contains(3));
+    EXPECT_TRUE(tree.contains(11));
+    EXPECT_FALSE(tree.contains(2));
+    EXPECT_FALSE(tree.contains(5));
+    EXPECT_FALSE(tree.contains(12));
+}
+
 TEST_F(BinarySearchTreeTest, Remove)
 {
     tree.remove(7);
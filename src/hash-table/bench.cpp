@@ -0,0 +1,109 @@
+#include "../avl-tree/avl-tree.hpp"
+#include "hash-table.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <numeric>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+// Distinct keys in random order, spread over the whole int range so the
+// std::hash identity does not hand std::unordered_set sequential buckets.
+static std::vector<int> keys(int count, unsigned seed = 42)
+{
+    std::vector<int> keys(count);
+    std::iota(keys.begin(), keys.end(), 0);
+    for (int& key : keys)
+        key *= 2654435761u;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+    return keys;
+}
+
+template <typename Set>
+static void fill(Set& set, const std::vector<int>& values)
+{
+    for (int value : values)
+        set.insert(value);
+}
+
+// Inserts state.range(0) keys into an empty set.
+template <typename Set>
+static void BM_Insert(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    for (auto _ : state) {
+        Set set;
+        fill(set, values);
+        benchmark::DoNotOptimize(set);
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_Insert<FlatHashSet<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_Insert<std::unordered_set<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_Insert<AVLTree<int>>)->Range(1 << 10, 1 << 18);
+
+// Looks every key up once, in a different order than it was inserted in.
+template <typename Set>
+static void BM_LookupHit(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    Set set;
+    fill(set, values);
+    std::shuffle(values.begin(), values.end(), std::mt19937(7));
+    for (auto _ : state) {
+        for (int value : values)
+            benchmark::DoNotOptimize(set.contains(value));
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_LookupHit<FlatHashSet<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_LookupHit<std::unordered_set<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_LookupHit<AVLTree<int>>)->Range(1 << 10, 1 << 18);
+
+// Looks up keys that are not there, a miss ends at the first group with an
+// EMPTY byte.
+template <typename Set>
+static void BM_LookupMiss(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0) * 2);
+    Set set;
+    fill(set, std::vector<int>(values.begin(), values.begin() + state.range(0)));
+    std::vector<int> missing(values.begin() + state.range(0), values.end());
+    for (auto _ : state) {
+        for (int value : missing)
+            benchmark::DoNotOptimize(set.contains(value));
+    }
+    state.SetItemsProcessed(state.iterations() * missing.size());
+}
+BENCHMARK(BM_LookupMiss<FlatHashSet<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_LookupMiss<std::unordered_set<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_LookupMiss<AVLTree<int>>)->Range(1 << 10, 1 << 18);
+
+template <typename Set>
+static void erase(Set& set, int value)
+{
+    if constexpr (requires { set.remove(value); })
+        set.remove(value);
+    else
+        set.erase(value);
+}
+
+// Steady size churn: remove the oldest key, insert a new one.
+template <typename Set>
+static void BM_Churn(benchmark::State& state)
+{
+    const int size = state.range(0);
+    std::vector<int> values = keys(size * 4);
+    Set set;
+    fill(set, std::vector<int>(values.begin(), values.begin() + size));
+    size_t oldest = 0;
+    for (auto _ : state) {
+        erase(set, values[oldest % values.size()]);
+        set.insert(values[(oldest + size) % values.size()]);
+        oldest++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Churn<FlatHashSet<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_Churn<std::unordered_set<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_Churn<AVLTree<int>>)->Range(1 << 10, 1 << 18);
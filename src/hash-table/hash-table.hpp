@@ -0,0 +1,515 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FLAT_HASH_SSE2 1
+#endif
+
+// Open addressing hash tables laid out like Abseil's Swiss tables. Every slot
+// has a control byte next to it: EMPTY, DELETED, or the low 7 bits (H2) of
+// the hash of the key stored in it. Slots are probed in aligned groups of 16,
+// one SSE2 compare of a group's control bytes against H2 leaves the few slots
+// whose keys are worth comparing, and a group with an EMPTY byte ends the
+// probe. The rest of the hash (H1) picks the first group, the following ones
+// are visited in triangular order, which covers every group of a power of
+// two table.
+
+// Sixteen control bytes loaded at once. Bit i of a match is slot i of the
+// group.
+struct FlatHashGroup {
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+    static constexpr size_t WIDTH = 16;
+
+    // Control bytes of a table without slots, so probing an empty table
+    // needs neither a branch nor an allocation.
+    alignas(WIDTH) static constexpr int8_t EMPTY_GROUP[WIDTH] = { EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+        EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY };
+
+#ifdef FLAT_HASH_SSE2
+    __m128i m_control;
+
+    explicit FlatHashGroup(const int8_t* control)
+        : m_control(_mm_load_si128(reinterpret_cast<const __m128i*>(control)))
+    {
+    }
+
+    uint32_t match(int8_t h2) const
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_control));
+    }
+
+    // EMPTY and DELETED are the only control bytes with the sign bit set.
+    uint32_t match_free() const
+    {
+        return _mm_movemask_epi8(m_control);
+    }
+#else
+    const int8_t* m_control;
+
+    explicit FlatHashGroup(const int8_t* control)
+        : m_control(control)
+    {
+    }
+
+    uint32_t match(int8_t h2) const
+    {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < WIDTH; i++)
+            bits |= uint32_t(m_control[i] == h2) << i;
+        return bits;
+    }
+
+    uint32_t match_free() const
+    {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < WIDTH; i++)
+            bits |= uint32_t(m_control[i] < 0) << i;
+        return bits;
+    }
+#endif
+
+    uint32_t match_empty() const
+    {
+        return match(EMPTY);
+    }
+};
+
+// The table shared by FlatHashSet and FlatHashMap. Slot is what is stored,
+// KeyOf::key(slot) the part of it that is hashed and compared.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+class FlatHashTable {
+protected:
+    static constexpr size_t WIDTH = FlatHashGroup::WIDTH;
+    static constexpr size_t NPOS = ~size_t(0);
+
+    int8_t* m_control;
+    Slot* m_slots;
+    size_t m_capacity;
+    size_t m_group_mask;
+    size_t m_size;
+    // Slots that can still turn from EMPTY to full before the table is at
+    // 7/8 load. DELETED slots count as full.
+    size_t m_growth_left;
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] Equal m_equal;
+    [[no_unique_address]] mutable StatsRecorder m_stats;
+
+    // Murmur3 finalizer, std::hash of an integer is the integer itself and
+    // H2 would only see its low bits.
+    uint64_t hash(const Key& key) const
+    {
+        uint64_t hash = m_hash(key);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static int8_t h2(uint64_t hash)
+    {
+        return hash & 0x7f;
+    }
+
+    auto find_index(const Key& key, uint64_t hash) const -> size_t;
+    auto find_free(uint64_t hash) const -> size_t;
+    void set_control(size_t index, uint64_t hash);
+    void rehash(size_t capacity);
+    void release();
+
+    // Inserts Slot(args...) unless key is already there. Returns the slot
+    // index and whether it was inserted.
+    template <typename... Args>
+    auto emplace(const Key& key, Args&&... args) -> std::pair<size_t, bool>;
+
+    auto lookup(const Key& key) const -> size_t
+    {
+        auto timer = m_stats.time(Operation::Lookup);
+        return find_index(key, hash(key));
+    }
+
+public:
+    FlatHashTable(Hash hash = Hash(), Equal equal = Equal())
+        : m_control(const_cast<int8_t*>(FlatHashGroup::EMPTY_GROUP))
+        , m_slots(nullptr)
+        , m_capacity(0)
+        , m_group_mask(0)
+        , m_size(0)
+        , m_growth_left(0)
+        , m_hash(hash)
+        , m_equal(equal)
+    {
+    }
+
+    FlatHashTable(const FlatHashTable& other);
+    FlatHashTable(FlatHashTable&& other);
+    ~FlatHashTable() { release(); }
+
+    FlatHashTable& operator=(FlatHashTable other)
+    {
+        swap(other);
+        return *this;
+    }
+
+    void swap(FlatHashTable& other);
+
+    // Removes key, returns whether it was there.
+    bool remove(const Key& key);
+    bool contains(const Key& key) const { return lookup(key) != NPOS; }
+
+    size_t size() const { return m_size; }
+    bool is_empty() const { return m_size == 0; }
+    size_t capacity() const { return m_capacity; }
+
+    // Makes room for count elements without rehashing.
+    void reserve(size_t count);
+    void clear();
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp. Visits are
+    // probed groups, comparisons are key compares after an H2 match,
+    // resizes are rehashes.
+    ContainerStats stats() const { return m_stats.stats(); }
+    void reset_stats() { m_stats.reset(); }
+
+    // Control bytes are overhead, empty and deleted slots are slack.
+    MemoryUsage memory_usage() const;
+
+    // Visits the slots in table order, which is no order at all.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = Slot;
+        using pointer = const Slot*;
+        using reference = const Slot&;
+
+        Iterator(const FlatHashTable* table, size_t index)
+            : m_table(table)
+            , m_index(index)
+        {
+            skip();
+        }
+
+        reference operator*() const { return m_table->m_slots[m_index]; }
+        pointer operator->() const { return m_table->m_slots + m_index; }
+
+        Iterator& operator++()
+        {
+            m_index++;
+            skip();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) { return lhs.m_index == rhs.m_index; }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) { return lhs.m_index != rhs.m_index; }
+
+    private:
+        const FlatHashTable* m_table;
+        size_t m_index;
+
+        void skip()
+        {
+            while (m_index < m_table->m_capacity && m_table->m_control[m_index] < 0)
+                m_index++;
+        }
+    };
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, m_capacity); }
+};
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::FlatHashTable(const FlatHashTable& other)
+    : FlatHashTable(other.m_hash, other.m_equal)
+{
+    reserve(other.m_size);
+    for (size_t i = 0; i < other.m_capacity; i++) {
+        if (other.m_control[i] < 0)
+            continue;
+        uint64_t hash = this->hash(KeyOf::key(other.m_slots[i]));
+        size_t index = find_free(hash);
+        ::new (m_slots + index) Slot(other.m_slots[i]);
+        set_control(index, hash);
+    }
+}
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::FlatHashTable(FlatHashTable&& other)
+    : FlatHashTable(other.m_hash, other.m_equal)
+{
+    swap(other);
+}
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::swap(FlatHashTable& other)
+{
+    std::swap(m_control, other.m_control);
+    std::swap(m_slots, other.m_slots);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_group_mask, other.m_group_mask);
+    std::swap(m_size, other.m_size);
+    std::swap(m_growth_left, other.m_growth_left);
+    std::swap(m_hash, other.m_hash);
+    std::swap(m_equal, other.m_equal);
+    std::swap(m_stats, other.m_stats);
+}
+
+// Index of the slot holding key, NPOS if there is none.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+auto FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::find_index(const Key& key, uint64_t hash) const -> size_t
+{
+    size_t group = (hash >> 7) & m_group_mask;
+    for (size_t step = 1;; step++) {
+        m_stats.visit();
+        FlatHashGroup control(m_control + group * WIDTH);
+        for (uint32_t bits = control.match(h2(hash)); bits != 0; bits &= bits - 1) {
+            size_t index = group * WIDTH + __builtin_ctz(bits);
+            m_stats.comparison();
+            if (m_equal(KeyOf::key(m_slots[index]), key))
+                return index;
+        }
+        if (control.match_empty() != 0)
+            return NPOS;
+        group = (group + step) & m_group_mask;
+    }
+}
+
+// First EMPTY or DELETED slot on the probe sequence of hash.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+auto FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::find_free(uint64_t hash) const -> size_t
+{
+    size_t group = (hash >> 7) & m_group_mask;
+    for (size_t step = 1;; step++) {
+        uint32_t bits = FlatHashGroup(m_control + group * WIDTH).match_free();
+        if (bits != 0)
+            return group * WIDTH + __builtin_ctz(bits);
+        group = (group + step) & m_group_mask;
+    }
+}
+
+// Marks the just constructed slot at index full.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::set_control(size_t index, uint64_t hash)
+{
+    if (m_control[index] == FlatHashGroup::EMPTY)
+        m_growth_left--;
+    m_control[index] = h2(hash);
+    m_size++;
+}
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+template <typename... Args>
+auto FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::emplace(const Key& key, Args&&... args) -> std::pair<size_t, bool>
+{
+    auto timer = m_stats.time(Operation::Insert);
+    uint64_t hash = this->hash(key);
+    size_t index = find_index(key, hash);
+    if (index != NPOS)
+        return { index, false };
+
+    index = find_free(hash);
+    if (m_control[index] == FlatHashGroup::EMPTY && m_growth_left == 0) {
+        // Tombstones count against the load factor, so a table that is
+        // mostly DELETED is rebuilt at the same size instead of doubled.
+        bool crowded = m_size * 16 > m_capacity * 7;
+        rehash(m_capacity == 0 ? WIDTH : crowded ? m_capacity * 2 : m_capacity);
+        index = find_free(hash);
+    }
+    ::new (m_slots + index) Slot(std::forward<Args>(args)...);
+    set_control(index, hash);
+    return { index, true };
+}
+
+// A group that still has an EMPTY byte never filled up since the last
+// rehash, so no probe ever went past it and the slot can go back to EMPTY.
+// Only slots in groups that did fill up leave a DELETED tombstone.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+bool FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::remove(const Key& key)
+{
+    auto timer = m_stats.time(Operation::Remove);
+    size_t index = find_index(key, hash(key));
+    if (index == NPOS)
+        return false;
+
+    m_slots[index].~Slot();
+    m_size--;
+    if (FlatHashGroup(m_control + index / WIDTH * WIDTH).match_empty() != 0) {
+        m_control[index] = FlatHashGroup::EMPTY;
+        m_growth_left++;
+    } else {
+        m_control[index] = FlatHashGroup::DELETED;
+    }
+    return true;
+}
+
+// Moves every element into fresh arrays of capacity slots, dropping the
+// tombstones.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::rehash(size_t capacity)
+{
+    FlatHashTable old(m_hash, m_equal);
+    std::swap(m_control, old.m_control);
+    std::swap(m_slots, old.m_slots);
+    std::swap(m_capacity, old.m_capacity);
+
+    m_control = static_cast<int8_t*>(::operator new(capacity, std::align_val_t(WIDTH)));
+    std::memset(m_control, FlatHashGroup::EMPTY, capacity);
+    m_slots = static_cast<Slot*>(::operator new(capacity * sizeof(Slot), std::align_val_t(alignof(Slot))));
+    m_capacity = capacity;
+    m_group_mask = capacity / WIDTH - 1;
+    m_growth_left = capacity / 8 * 7;
+    m_size = 0;
+    m_stats.resize();
+    m_stats.allocation(2);
+
+    for (size_t i = 0; i < old.m_capacity; i++) {
+        if (old.m_control[i] < 0)
+            continue;
+        uint64_t hash = this->hash(KeyOf::key(old.m_slots[i]));
+        size_t index = find_free(hash);
+        ::new (m_slots + index) Slot(std::move(old.m_slots[i]));
+        set_control(index, hash);
+    }
+    if (old.m_capacity != 0)
+        m_stats.deallocation(2);
+}
+
+// Destroys every element and frees the arrays, leaving the table unusable
+// until the members are reset.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::release()
+{
+    if (m_capacity == 0)
+        return;
+    for (size_t i = 0; i < m_capacity; i++) {
+        if (m_control[i] >= 0)
+            m_slots[i].~Slot();
+    }
+    ::operator delete(m_control, std::align_val_t(WIDTH));
+    ::operator delete(m_slots, std::align_val_t(alignof(Slot)));
+}
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::reserve(size_t count)
+{
+    if (count <= m_size + m_growth_left)
+        return;
+    size_t capacity = WIDTH;
+    while (capacity / 8 * 7 < count)
+        capacity *= 2;
+    rehash(capacity);
+}
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::clear()
+{
+    if (m_capacity != 0)
+        m_stats.deallocation(2);
+    release();
+    m_control = const_cast<int8_t*>(FlatHashGroup::EMPTY_GROUP);
+    m_slots = nullptr;
+    m_capacity = 0;
+    m_group_mask = 0;
+    m_size = 0;
+    m_growth_left = 0;
+}
+
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename Equal>
+MemoryUsage FlatHashTable<Key, Slot, KeyOf, Hash, Equal>::memory_usage() const
+{
+    MemoryUsage usage;
+    usage.m_elements = m_size;
+    usage.m_payload = m_size * sizeof(Slot);
+    usage.m_overhead = m_capacity + sizeof(*this);
+    usage.m_slack = (m_capacity - m_size) * sizeof(Slot);
+    if (m_capacity != 0) {
+        usage.allocations(m_capacity);
+        usage.allocations(m_capacity * sizeof(Slot));
+    }
+    return usage;
+}
+
+template <typename T>
+struct FlatHashSetKey {
+    static const T& key(const T& slot) { return slot; }
+};
+
+// Unordered set with the insert/remove/contains surface of AVLTree.
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+class FlatHashSet : public FlatHashTable<T, T, FlatHashSetKey<T>, Hash, Equal> {
+public:
+    using FlatHashTable<T, T, FlatHashSetKey<T>, Hash, Equal>::FlatHashTable;
+
+    // Returns whether value was not in the set yet.
+    bool insert(const T& value) { return this->emplace(value, value).second; }
+    bool insert(T&& value) { return this->emplace(value, std::move(value)).second; }
+};
+
+template <typename K, typename V>
+struct FlatHashMapEntry {
+    K m_key;
+    V m_value;
+
+    template <typename Key, typename Value>
+    FlatHashMapEntry(Key&& key, Value&& value)
+        : m_key(std::forward<Key>(key))
+        , m_value(std::forward<Value>(value))
+    {
+    }
+
+    static const K& key(const FlatHashMapEntry& entry) { return entry.m_key; }
+};
+
+// Unordered map, iterating it yields FlatHashMapEntry.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class FlatHashMap : public FlatHashTable<K, FlatHashMapEntry<K, V>, FlatHashMapEntry<K, V>, Hash, Equal> {
+public:
+    using FlatHashTable<K, FlatHashMapEntry<K, V>, FlatHashMapEntry<K, V>, Hash, Equal>::FlatHashTable;
+
+    // Inserts key or overwrites its value, returns whether key is new.
+    bool insert(const K& key, V value)
+    {
+        auto [index, inserted] = this->emplace(key, key, std::move(value));
+        if (!inserted)
+            this->m_slots[index].m_value = std::move(value);
+        return inserted;
+    }
+
+    // nullptr when key is not in the map.
+    V* find(const K& key)
+    {
+        size_t index = this->lookup(key);
+        return index == this->NPOS ? nullptr : &this->m_slots[index].m_value;
+    }
+
+    const V* find(const K& key) const
+    {
+        size_t index = this->lookup(key);
+        return index == this->NPOS ? nullptr : &this->m_slots[index].m_value;
+    }
+
+    // Value of key, default constructed first if key is new.
+    V& operator[](const K& key)
+    {
+        size_t index = this->emplace(key, key, V()).first;
+        return this->m_slots[index].m_value;
+    }
+};
@@ -0,0 +1,184 @@
+#include "hash-table.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+TEST(FlatHashSet, InsertContainsRemove)
+{
+    FlatHashSet<int> set;
+    EXPECT_TRUE(set.is_empty());
+    EXPECT_FALSE(set.contains(7));
+    EXPECT_FALSE(set.remove(7));
+
+    EXPECT_TRUE(set.insert(7));
+    EXPECT_FALSE(set.insert(7));
+    EXPECT_TRUE(set.insert(3));
+    EXPECT_EQ(set.size(), 2);
+    EXPECT_TRUE(set.contains(7));
+    EXPECT_TRUE(set.contains(3));
+    EXPECT_FALSE(set.contains(5));
+
+    EXPECT_TRUE(set.remove(7));
+    EXPECT_FALSE(set.contains(7));
+    EXPECT_TRUE(set.contains(3));
+    EXPECT_EQ(set.size(), 1);
+}
+
+TEST(FlatHashSet, MatchesUnorderedSet)
+{
+    FlatHashSet<int> set;
+    std::unordered_set<int> expected;
+    std::mt19937 random(3);
+
+    for (int i = 0; i < 200000; i++) {
+        int key = random() % 50000;
+        if (random() % 3 == 0)
+            EXPECT_EQ(set.remove(key), expected.erase(key) == 1);
+        else
+            EXPECT_EQ(set.insert(key), expected.insert(key).second);
+    }
+    ASSERT_EQ(set.size(), expected.size());
+    for (int key = 0; key < 50000; key++)
+        EXPECT_EQ(set.contains(key), expected.count(key) == 1) << key;
+}
+
+// Removing from a group that never filled up leaves no tombstone, so a table
+// that stays small never needs to grow however many times it is churned.
+TEST(FlatHashSet, RemoveWithoutTombstones)
+{
+    FlatHashSet<int> set;
+    for (int i = 0; i < 100000; i++) {
+        set.insert(i);
+        set.remove(i);
+    }
+    EXPECT_TRUE(set.is_empty());
+    EXPECT_EQ(set.capacity(), 16);
+}
+
+// Every key in the same group, so probes run over full groups and removals
+// have to leave tombstones for the keys behind them.
+TEST(FlatHashSet, Collisions)
+{
+    struct Constant {
+        size_t operator()(int) const { return 0; }
+    };
+    FlatHashSet<int, Constant> set;
+    for (int i = 0; i < 100; i++)
+        EXPECT_TRUE(set.insert(i));
+    for (int i = 0; i < 100; i += 2)
+        EXPECT_TRUE(set.remove(i));
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(set.contains(i), i % 2 == 1) << i;
+    for (int i = 0; i < 100; i += 2)
+        EXPECT_TRUE(set.insert(i));
+    EXPECT_EQ(set.size(), 100);
+}
+
+// Churn past the load factor with a steady size: the table doubles at most
+// once, after that tombstones are purged by rehashing at the same capacity.
+TEST(FlatHashSet, ChurnKeepsCapacity)
+{
+    FlatHashSet<int> set;
+    for (int i = 0; i < 1000; i++)
+        set.insert(i);
+    for (int i = 1000; i < 50000; i++) {
+        set.remove(i - 1000);
+        set.insert(i);
+    }
+    size_t capacity = set.capacity();
+    EXPECT_LE(capacity, 4096);
+    for (int i = 50000; i < 200000; i++) {
+        set.remove(i - 1000);
+        set.insert(i);
+    }
+    EXPECT_EQ(set.size(), 1000);
+    EXPECT_EQ(set.capacity(), capacity);
+    for (int i = 199000; i < 200000; i++)
+        EXPECT_TRUE(set.contains(i));
+}
+
+TEST(FlatHashSet, Strings)
+{
+    FlatHashSet<std::string> set;
+    for (int i = 0; i < 1000; i++)
+        set.insert(std::string(40, 'a') + std::to_string(i));
+    EXPECT_TRUE(set.contains(std::string(40, 'a') + "999"));
+    EXPECT_FALSE(set.contains("a999"));
+    EXPECT_TRUE(set.remove(std::string(40, 'a') + "0"));
+    EXPECT_EQ(set.size(), 999);
+}
+
+TEST(FlatHashSet, CopyMoveIterate)
+{
+    FlatHashSet<int> set;
+    set.reserve(100);
+    size_t capacity = set.capacity();
+    for (int i = 0; i < 100; i++)
+        set.insert(i);
+    EXPECT_EQ(set.capacity(), capacity);
+
+    FlatHashSet<int> copy = set;
+    copy.remove(0);
+    EXPECT_TRUE(set.contains(0));
+    EXPECT_FALSE(copy.contains(0));
+
+    FlatHashSet<int> moved = std::move(set);
+    EXPECT_TRUE(set.is_empty());
+    EXPECT_FALSE(set.contains(0));
+    EXPECT_EQ(moved.size(), 100);
+
+    std::vector<int> keys(moved.begin(), moved.end());
+    std::sort(keys.begin(), keys.end());
+    ASSERT_EQ(keys.size(), 100);
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(keys[i], i);
+
+    moved.clear();
+    EXPECT_TRUE(moved.is_empty());
+    EXPECT_EQ(moved.begin(), moved.end());
+    moved.insert(1);
+    EXPECT_TRUE(moved.contains(1));
+}
+
+TEST(FlatHashMap, InsertFind)
+{
+    FlatHashMap<std::string, int> map;
+    EXPECT_EQ(map.find("one"), nullptr);
+    EXPECT_TRUE(map.insert("one", 1));
+    EXPECT_TRUE(map.insert("two", 2));
+    EXPECT_FALSE(map.insert("one", 11));
+    EXPECT_EQ(*map.find("one"), 11);
+    EXPECT_EQ(*map.find("two"), 2);
+
+    map["three"] += 3;
+    map["three"] += 3;
+    EXPECT_EQ(map["three"], 6);
+    EXPECT_EQ(map.size(), 3);
+
+    EXPECT_TRUE(map.remove("two"));
+    EXPECT_EQ(map.find("two"), nullptr);
+
+    int sum = 0;
+    for (const auto& entry : map)
+        sum += entry.m_value;
+    EXPECT_EQ(sum, 17);
+}
+
+TEST(FlatHashMap, MatchesUnorderedMap)
+{
+    FlatHashMap<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 random(5);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t key = random() % 20000;
+        map[key] += i;
+        expected[key] += i;
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    for (const auto& [key, value] : expected)
+        EXPECT_EQ(*map.find(key), value);
+}
@@ -0,0 +1,107 @@
+#include "../avl-tree/avl-tree.hpp"
+#include "heap.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <vector>
+
+// Distinct keys in random order, AVLTree drops duplicates.
+static std::vector<int> keys(int count)
+{
+    std::vector<int> keys(count);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    return keys;
+}
+
+// Pushes state.range(0) keys and pops them all, smallest first.
+template <int D>
+static void BM_DaryHeap(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    for (auto _ : state) {
+        DaryHeap<int, D, std::greater<int>> heap;
+        for (int value : values) {
+            heap.push(value);
+        }
+        while (!heap.empty()) {
+            benchmark::DoNotOptimize(heap.top());
+            heap.pop();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_DaryHeap<2>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_DaryHeap<4>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_DaryHeap<8>)->Range(1 << 10, 1 << 20);
+
+static void BM_StdPriorityQueue(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    for (auto _ : state) {
+        std::priority_queue<int, std::vector<int>, std::greater<int>> heap;
+        for (int value : values) {
+            heap.push(value);
+        }
+        while (!heap.empty()) {
+            benchmark::DoNotOptimize(heap.top());
+            heap.pop();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_StdPriorityQueue)->Range(1 << 10, 1 << 20);
+
+static void BM_AVLTreeAsPriorityQueue(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    for (auto _ : state) {
+        AVLTree<int> tree;
+        for (int value : values) {
+            tree.insert(value);
+        }
+        while (!tree.isEmpty()) {
+            int min = tree.findMin();
+            benchmark::DoNotOptimize(min);
+            tree.remove(min);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_AVLTreeAsPriorityQueue)->Range(1 << 10, 1 << 20);
+
+static void BM_DaryHeapify(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    for (auto _ : state) {
+        DaryHeap<int> heap(values.begin(), values.end());
+        benchmark::DoNotOptimize(heap.top());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_DaryHeapify)->Range(1 << 10, 1 << 20);
+
+// Dijkstra-like pattern: every pop is followed by a few decrease_key calls.
+static void BM_AddressableHeapDecreaseKey(benchmark::State& state)
+{
+    std::vector<int> values = keys(state.range(0));
+    for (auto _ : state) {
+        AddressableHeap<int> heap;
+        std::vector<int> handles;
+        for (int value : values) {
+            handles.push_back(heap.push(value + static_cast<int>(values.size())));
+        }
+        size_t next = 0;
+        while (!heap.empty()) {
+            heap.pop();
+            for (int i = 0; i < 3 && next < handles.size(); i++, next++) {
+                if (heap.contains(handles[next]))
+                    heap.decrease_key(handles[next], heap.value(handles[next]) - static_cast<int>(values.size()));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_AddressableHeapDecreaseKey)->Range(1 << 10, 1 << 20);
@@ -0,0 +1,433 @@
+#pragma once
+
+#include "../array/array.hpp"
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+// Implicit d-ary heap stored in a MyArray. With D children per node the tree
+// is log_D(n) deep, so pushes touch fewer levels, and the children compared
+// when sifting down sit next to each other in memory (a 4-ary heap of ints
+// reads one cache line per level).
+//
+// Like std::priority_queue, top() is the largest element for the default
+// std::less; use std::greater for a min-heap.
+template <typename T, int D = 4, typename Compare = std::less<T>>
+class DaryHeap {
+    static_assert(D >= 2, "a heap node needs at least two children");
+
+private:
+    MyArray<T> m_heap;
+    Compare m_compare;
+    [[no_unique_address]] StatsRecorder m_stats;
+
+    bool less(const T& left, const T& right)
+    {
+        m_stats.comparison();
+        return m_compare(left, right);
+    }
+
+    void sift_up(int index);
+    void sift_down(int index);
+
+public:
+    DaryHeap(Compare compare = Compare())
+        : m_compare(compare)
+    {
+    }
+
+    template <typename Iterator>
+    DaryHeap(Iterator first, Iterator last, Compare compare = Compare())
+        : m_compare(compare)
+    {
+        heapify(first, last);
+    }
+
+    int size() { return m_heap.size(); }
+
+    bool empty() { return m_heap.is_empty(); }
+
+    const T& top();
+
+    void push(T value);
+
+    void pop();
+
+    template <typename Iterator>
+    void heapify(Iterator first, Iterator last);
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const
+    {
+        ContainerStats stats = m_stats.stats();
+        stats.add_storage(m_heap.stats());
+        return stats;
+    }
+
+    void reset_stats()
+    {
+        m_stats.reset();
+        m_heap.reset_stats();
+    }
+
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage = m_heap.memory_usage();
+        usage.m_overhead += sizeof(*this) - sizeof(m_heap);
+        return usage;
+    }
+};
+
+template <typename T, int D, typename Compare>
+void DaryHeap<T, D, Compare>::sift_up(int index)
+{
+    T* heap = m_heap.data();
+    T value = std::move(heap[index]);
+    while (index > 0) {
+        int parent = (index - 1) / D;
+        if (!less(heap[parent], value))
+            break;
+        heap[index] = std::move(heap[parent]);
+        index = parent;
+    }
+    heap[index] = std::move(value);
+}
+
+template <typename T, int D, typename Compare>
+void DaryHeap<T, D, Compare>::sift_down(int index)
+{
+    T* heap = m_heap.data();
+    const int size = m_heap.size();
+    T value = std::move(heap[index]);
+    for (;;) {
+        int first = index * D + 1;
+        if (first >= size)
+            break;
+        int last = first + D < size ? first + D : size;
+        int best = first;
+        for (int child = first + 1; child < last; child++) {
+            if (less(heap[best], heap[child]))
+                best = child;
+        }
+        if (!less(value, heap[best]))
+            break;
+        heap[index] = std::move(heap[best]);
+        index = best;
+    }
+    heap[index] = std::move(value);
+}
+
+template <typename T, int D, typename Compare>
+const T& DaryHeap<T, D, Compare>::top()
+{
+    if (m_heap.is_empty())
+        throw std::runtime_error("top of an empty heap");
+    return m_heap.data()[0];
+}
+
+template <typename T, int D, typename Compare>
+void DaryHeap<T, D, Compare>::push(T value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    m_heap.push(std::move(value));
+    sift_up(m_heap.size() - 1);
+}
+
+// The element moved to the root comes from the bottom, so it almost always
+// sinks back to the bottom: the hole left by the top is walked down to a
+// leaf picking the best child, without comparing against that element, and
+// the element is then sifted up from there.
+template <typename T, int D, typename Compare>
+void DaryHeap<T, D, Compare>::pop()
+{
+    auto timer = m_stats.time(Operation::Remove);
+    if (m_heap.is_empty())
+        throw std::runtime_error("pop from an empty heap");
+    T* heap = m_heap.data();
+    const int size = m_heap.size() - 1;
+    int index = 0;
+    for (;;) {
+        int first = index * D + 1;
+        if (first >= size)
+            break;
+        int last = first + D < size ? first + D : size;
+        int best = first;
+        for (int child = first + 1; child < last; child++) {
+            if (less(heap[best], heap[child]))
+                best = child;
+        }
+        heap[index] = std::move(heap[best]);
+        index = best;
+    }
+    if (index != size) {
+        heap[index] = std::move(heap[size]);
+        m_heap.pop();
+        sift_up(index);
+    } else {
+        m_heap.pop();
+    }
+}
+
+// Replaces the contents with [first, last) in O(n), sifting down every inner
+// node from the last one up (Floyd's construction).
+template <typename T, int D, typename Compare>
+template <typename Iterator>
+void DaryHeap<T, D, Compare>::heapify(Iterator first, Iterator last)
+{
+    while (!m_heap.is_empty()) {
+        m_heap.pop();
+    }
+    for (; first != last; ++first) {
+        m_heap.push(*first);
+    }
+    // (size - 2) / D would truncate to 0 for an empty range and sift a slot
+    // that holds no element.
+    if (m_heap.size() < 2) {
+        return;
+    }
+    for (int i = (m_heap.size() - 2) / D; i >= 0; i--) {
+        sift_down(i);
+    }
+}
+
+// d-ary heap whose elements can be changed while they are queued. push()
+// returns a handle that stays valid until the element leaves the heap, and
+// a handle table tracks where each element currently sits, so
+// decrease_key() and remove() start sifting right from it.
+//
+// decrease_key() is a min-heap operation, so unlike DaryHeap the default
+// comparison is std::greater and top() is the smallest element.
+template <typename T, int D = 4, typename Compare = std::greater<T>>
+class AddressableHeap {
+    static_assert(D >= 2, "a heap node needs at least two children");
+
+private:
+    // Heap of handles; m_values and m_position are indexed by handle, and a
+    // handle that is not queued has position -1 and sits in m_free.
+    MyArray<int> m_heap;
+    MyArray<T> m_values;
+    MyArray<int> m_position;
+    MyArray<int> m_free;
+    Compare m_compare;
+    [[no_unique_address]] StatsRecorder m_stats;
+
+    bool before(int left, int right)
+    {
+        m_stats.comparison();
+        return m_compare(m_values.data()[right], m_values.data()[left]);
+    }
+
+    void place(int index, int handle)
+    {
+        m_heap.data()[index] = handle;
+        m_position.data()[handle] = index;
+    }
+
+    void sift_up(int index);
+    void sift_down(int index);
+    void check(int handle);
+
+public:
+    AddressableHeap(Compare compare = Compare())
+        : m_compare(compare)
+    {
+    }
+
+    int size() { return m_heap.size(); }
+
+    bool empty() { return m_heap.is_empty(); }
+
+    bool contains(int handle)
+    {
+        return handle >= 0 && handle < m_position.size() && m_position.data()[handle] >= 0;
+    }
+
+    const T& top();
+
+    int top_handle();
+
+    const T& value(int handle);
+
+    int push(T value);
+
+    void pop();
+
+    void decrease_key(int handle, T value);
+
+    void update(int handle, T value);
+
+    void remove(int handle);
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const
+    {
+        ContainerStats stats = m_stats.stats();
+        stats.add_storage(m_heap.stats());
+        stats.add_storage(m_values.stats());
+        stats.add_storage(m_position.stats());
+        stats.add_storage(m_free.stats());
+        return stats;
+    }
+
+    void reset_stats()
+    {
+        m_stats.reset();
+        m_heap.reset_stats();
+        m_values.reset_stats();
+        m_position.reset_stats();
+        m_free.reset_stats();
+    }
+
+    // The handle arrays are overhead. Values of handles that are not queued
+    // are dead space in m_values, so slack.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        for (const MyArray<int>* index : { &m_heap, &m_position, &m_free }) {
+            MemoryUsage part = index->memory_usage();
+            usage.m_overhead += part.m_payload;
+            usage.m_slack += part.m_slack;
+        }
+        MemoryUsage values = m_values.memory_usage();
+        usage.m_elements = m_heap.memory_usage().m_elements;
+        usage.m_payload = usage.m_elements * sizeof(T);
+        usage.m_slack += values.m_slack + values.m_payload - usage.m_payload;
+        usage.m_overhead += sizeof(*this);
+        return usage;
+    }
+};
+
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::sift_up(int index)
+{
+    int handle = m_heap.data()[index];
+    while (index > 0) {
+        int parent = (index - 1) / D;
+        int parent_handle = m_heap.data()[parent];
+        if (!before(handle, parent_handle))
+            break;
+        place(index, parent_handle);
+        index = parent;
+    }
+    place(index, handle);
+}
+
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::sift_down(int index)
+{
+    const int* heap = m_heap.data();
+    const int size = m_heap.size();
+    int handle = heap[index];
+    for (;;) {
+        int first = index * D + 1;
+        if (first >= size)
+            break;
+        int last = first + D < size ? first + D : size;
+        int best = first;
+        for (int child = first + 1; child < last; child++) {
+            if (before(heap[child], heap[best]))
+                best = child;
+        }
+        if (!before(heap[best], handle))
+            break;
+        place(index, heap[best]);
+        index = best;
+    }
+    place(index, handle);
+}
+
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::check(int handle)
+{
+    if (!contains(handle))
+        throw std::invalid_argument("handle is not in the heap");
+}
+
+template <typename T, int D, typename Compare>
+const T& AddressableHeap<T, D, Compare>::top()
+{
+    return m_values.data()[top_handle()];
+}
+
+template <typename T, int D, typename Compare>
+int AddressableHeap<T, D, Compare>::top_handle()
+{
+    if (m_heap.is_empty())
+        throw std::runtime_error("top of an empty heap");
+    return m_heap.data()[0];
+}
+
+template <typename T, int D, typename Compare>
+const T& AddressableHeap<T, D, Compare>::value(int handle)
+{
+    check(handle);
+    return m_values.data()[handle];
+}
+
+template <typename T, int D, typename Compare>
+int AddressableHeap<T, D, Compare>::push(T value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    int handle;
+    if (!m_free.is_empty()) {
+        handle = m_free.data()[m_free.size() - 1];
+        m_free.pop();
+        m_values.data()[handle] = std::move(value);
+    } else {
+        handle = m_values.size();
+        m_values.push(std::move(value));
+        m_position.push(-1);
+    }
+    m_heap.push(handle);
+    sift_up(m_heap.size() - 1);
+    return handle;
+}
+
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::pop()
+{
+    remove(top_handle());
+}
+
+// Moves the element closer to the top: the new value must not compare
+// worse than the current one.
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::decrease_key(int handle, T value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    check(handle);
+    if (m_compare(value, m_values.data()[handle]))
+        throw std::invalid_argument("decrease_key would move the element away from the top");
+    m_values.data()[handle] = std::move(value);
+    sift_up(m_position.data()[handle]);
+}
+
+// Changes the value in either direction.
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::update(int handle, T value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    check(handle);
+    m_values.data()[handle] = std::move(value);
+    int index = m_position.data()[handle];
+    sift_up(index);
+    sift_down(m_position.data()[handle]);
+}
+
+template <typename T, int D, typename Compare>
+void AddressableHeap<T, D, Compare>::remove(int handle)
+{
+    auto timer = m_stats.time(Operation::Remove);
+    check(handle);
+    int index = m_position.data()[handle];
+    int last = m_heap.data()[m_heap.size() - 1];
+    m_heap.pop();
+    m_position.data()[handle] = -1;
+    m_free.push(handle);
+    if (last == handle)
+        return;
+
+    place(index, last);
+    sift_up(index);
+    sift_down(m_position.data()[last]);
+}
@@ -0,0 +1,117 @@
+#include "heap.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+TEST(DaryHeap, PushPop)
+{
+    DaryHeap<int> heap;
+    const int values[] = { 5, 1, 9, 3, 7, 9, 2 };
+
+    EXPECT_TRUE(heap.empty());
+    for (int value : values) {
+        heap.push(value);
+    }
+    EXPECT_EQ(heap.size(), 7);
+
+    const int sorted[] = { 9, 9, 7, 5, 3, 2, 1 };
+    for (int value : sorted) {
+        EXPECT_EQ(heap.top(), value);
+        heap.pop();
+    }
+    EXPECT_TRUE(heap.empty());
+    EXPECT_THROW(heap.top(), std::runtime_error);
+    EXPECT_THROW(heap.pop(), std::runtime_error);
+}
+
+TEST(DaryHeap, MinHeap)
+{
+    DaryHeap<int, 2, std::greater<int>> heap;
+    for (int i = 10; i > 0; i--) {
+        heap.push(i);
+    }
+    for (int i = 1; i <= 10; i++) {
+        EXPECT_EQ(heap.top(), i);
+        heap.pop();
+    }
+}
+
+TEST(DaryHeap, Heapify)
+{
+    std::vector<int> values(1000);
+    std::mt19937 random(7);
+    for (int& value : values) {
+        value = random() % 500;
+    }
+
+    DaryHeap<int, 8> heap(values.begin(), values.end());
+    std::sort(values.rbegin(), values.rend());
+
+    ASSERT_EQ(heap.size(), 1000);
+    for (int value : values) {
+        EXPECT_EQ(heap.top(), value);
+        heap.pop();
+    }
+
+    DaryHeap<int, 8> empty(values.end(), values.end());
+    EXPECT_TRUE(empty.empty());
+    empty.heapify(values.begin(), values.begin() + 1);
+    ASSERT_EQ(empty.size(), 1);
+    EXPECT_EQ(empty.top(), values[0]);
+    empty.heapify(values.end(), values.end());
+    EXPECT_TRUE(empty.empty());
+}
+
+TEST(AddressableHeap, DecreaseKey)
+{
+    AddressableHeap<int> heap;
+    int a = heap.push(10);
+    int b = heap.push(20);
+    int c = heap.push(30);
+
+    EXPECT_EQ(heap.top(), 10);
+    heap.decrease_key(c, 5);
+    EXPECT_EQ(heap.top_handle(), c);
+    EXPECT_THROW(heap.decrease_key(b, 25), std::invalid_argument);
+
+    heap.update(c, 40);
+    EXPECT_EQ(heap.top_handle(), a);
+    heap.pop();
+    EXPECT_FALSE(heap.contains(a));
+    EXPECT_THROW(heap.value(a), std::invalid_argument);
+    EXPECT_EQ(heap.top(), 20);
+    EXPECT_EQ(heap.value(c), 40);
+
+    // Handles of popped elements are reused.
+    EXPECT_EQ(heap.push(1), a);
+}
+
+TEST(AddressableHeap, MatchesSortedOrder)
+{
+    AddressableHeap<int, 3> heap;
+    std::vector<int> handles;
+    std::vector<int> values;
+    std::mt19937 random(11);
+
+    for (int i = 0; i < 500; i++) {
+        handles.push_back(heap.push(1000 + random() % 1000));
+    }
+    for (int i = 0; i < 500; i += 2) {
+        heap.decrease_key(handles[i], heap.value(handles[i]) - random() % 1000);
+    }
+    for (int i = 1; i < 500; i += 10) {
+        heap.remove(handles[i]);
+    }
+    for (int handle : handles) {
+        if (heap.contains(handle))
+            values.push_back(heap.value(handle));
+    }
+    std::sort(values.begin(), values.end());
+
+    ASSERT_EQ(heap.size(), values.size());
+    for (int value : values) {
+        EXPECT_EQ(heap.top(), value);
+        heap.pop();
+    }
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "../linked-list/list-links.hpp"
+#include "../stats/memory-usage.hpp"
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+// Link embedded in the objects put on an IntrusiveList. An object can be on
+// as many lists at the same time as it has hooks. Copying an object does not
+// copy its membership, and destroying it takes it out of its list.
+struct ListHook {
+    ListHook* m_next;
+    ListHook* m_prev;
+
+    ListHook()
+        : m_next(nullptr)
+        , m_prev(nullptr) {};
+
+    ListHook(const ListHook&)
+        : ListHook() {};
+
+    ListHook& operator=(const ListHook&)
+    {
+        return *this;
+    }
+
+    ~ListHook()
+    {
+        unlink();
+    }
+
+    bool linked() const
+    {
+        return m_next != nullptr;
+    }
+
+    // Removes the object from whatever list it is on in O(1), without
+    // needing a reference to the list.
+    void unlink()
+    {
+        if (!linked())
+            return;
+        detail::unlink_node(this);
+        m_next = nullptr;
+        m_prev = nullptr;
+    }
+
+    void link(ListHook* prev, ListHook* next)
+    {
+        detail::link_node(this, prev, next);
+    }
+};
+
+// Doubly linked list over objects that embed a ListHook member at Offset,
+// given as offsetof(T, member). The list never allocates or copies, it only
+// links the objects it is given, so their lifetime stays with the caller (a
+// pool, the stack, ...).
+//
+// Because objects can unlink themselves, the list does not keep a counter and
+// size() walks the list. empty() is O(1).
+template <typename T, std::size_t Offset>
+class IntrusiveList {
+    static_assert(std::is_standard_layout_v<T>, "offsetof is only defined for standard layout types");
+    static_assert(Offset + sizeof(ListHook) <= sizeof(T), "Offset must be the offset of a ListHook member");
+
+private:
+    // Circular list around a sentinel, so linking never checks for nullptr.
+    ListHook m_root;
+
+    static ListHook* hook(T& value)
+    {
+        return reinterpret_cast<ListHook*>(reinterpret_cast<char*>(&value) + Offset);
+    }
+
+    static T* owner(ListHook* hook)
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - Offset);
+    }
+
+    struct Iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = T*;
+        using reference = T&;
+
+        Iterator(ListHook* ptr)
+            : m_ptr(ptr) {};
+
+        reference operator*() const { return *owner(m_ptr); }
+        pointer operator->() const { return owner(m_ptr); }
+
+        Iterator& operator++()
+        {
+            m_ptr = m_ptr->m_next;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        Iterator& operator--()
+        {
+            m_ptr = m_ptr->m_prev;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            Iterator tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b)
+        {
+            return a.m_ptr == b.m_ptr;
+        }
+        friend bool operator!=(const Iterator& a, const Iterator& b)
+        {
+            return a.m_ptr != b.m_ptr;
+        }
+
+    private:
+        ListHook* m_ptr;
+    };
+
+public:
+    Iterator begin() { return Iterator(m_root.m_next); }
+
+    Iterator end() { return Iterator(&m_root); }
+
+    IntrusiveList();
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    ~IntrusiveList();
+
+    int size();
+
+    bool empty();
+
+    void push_front(T& value);
+
+    void pop_front();
+
+    void push_back(T& value);
+
+    void pop_back();
+
+    T& front();
+
+    T& back();
+
+    void insert(T& position, T& value);
+
+    void erase(T& value);
+
+    void move_to_front(T& value);
+
+    void move_to_back(T& value);
+
+    void clear();
+
+    MemoryUsage memory_usage();
+};
+
+template <typename T, std::size_t Offset>
+IntrusiveList<T, Offset>::IntrusiveList()
+{
+    m_root.m_next = &m_root;
+    m_root.m_prev = &m_root;
+}
+
+template <typename T, std::size_t Offset>
+IntrusiveList<T, Offset>::~IntrusiveList()
+{
+    clear();
+    m_root.m_next = nullptr;
+    m_root.m_prev = nullptr;
+}
+
+template <typename T, std::size_t Offset>
+int IntrusiveList<T, Offset>::size()
+{
+    int size = 0;
+    for (ListHook* curr = m_root.m_next; curr != &m_root; curr = curr->m_next) {
+        size++;
+    }
+    return size;
+}
+
+// The list owns no element and allocates nothing, all it costs is the hook
+// inside every element and the sentinel. Walks the list, like size().
+template <typename T, std::size_t Offset>
+MemoryUsage IntrusiveList<T, Offset>::memory_usage()
+{
+    MemoryUsage usage;
+    usage.m_elements = size();
+    usage.m_overhead = usage.m_elements * sizeof(ListHook) + sizeof(*this);
+    return usage;
+}
+
+template <typename T, std::size_t Offset>
+bool IntrusiveList<T, Offset>::empty()
+{
+    return m_root.m_next == &m_root;
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::push_front(T& value)
+{
+    ListHook* node = hook(value);
+    node->unlink();
+    node->link(&m_root, m_root.m_next);
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::pop_front()
+{
+    if (!empty())
+        m_root.m_next->unlink();
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::push_back(T& value)
+{
+    ListHook* node = hook(value);
+    node->unlink();
+    node->link(m_root.m_prev, &m_root);
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::pop_back()
+{
+    if (!empty())
+        m_root.m_prev->unlink();
+}
+
+template <typename T, std::size_t Offset>
+T& IntrusiveList<T, Offset>::front()
+{
+    return *owner(m_root.m_next);
+}
+
+template <typename T, std::size_t Offset>
+T& IntrusiveList<T, Offset>::back()
+{
+    return *owner(m_root.m_prev);
+}
+
+// Inserts value right before position, which must already be on this list.
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::insert(T& position, T& value)
+{
+    ListHook* node = hook(value);
+    ListHook* next = hook(position);
+    if (node == next)
+        return;
+    node->unlink();
+    node->link(next->m_prev, next);
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::erase(T& value)
+{
+    hook(value)->unlink();
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::move_to_front(T& value)
+{
+    push_front(value);
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::move_to_back(T& value)
+{
+    push_back(value);
+}
+
+template <typename T, std::size_t Offset>
+void IntrusiveList<T, Offset>::clear()
+{
+    while (!empty()) {
+        m_root.m_next->unlink();
+    }
+}
@@ -0,0 +1,98 @@
+#include "intrusive-list.hpp"
+#include <cstddef>
+#include <gtest/gtest.h>
+
+struct Entry {
+    int value;
+    ListHook lru;
+    ListHook timers;
+
+    Entry(int v)
+        : value(v) {};
+};
+
+using LruList = IntrusiveList<Entry, offsetof(Entry, lru)>;
+using TimerList = IntrusiveList<Entry, offsetof(Entry, timers)>;
+
+TEST(IntrusiveList, PushPop)
+{
+    Entry entries[] = { 1, 2, 3 };
+    LruList list;
+
+    EXPECT_TRUE(list.empty());
+    list.push_back(entries[1]);
+    list.push_back(entries[2]);
+    list.push_front(entries[0]);
+
+    EXPECT_EQ(list.size(), 3);
+    EXPECT_EQ(list.front().value, 1);
+    EXPECT_EQ(list.back().value, 3);
+
+    int i = 1;
+    for (auto& entry : list) {
+        EXPECT_EQ(entry.value, i++);
+        EXPECT_EQ(&entry, &entries[entry.value - 1]);
+    }
+
+    list.pop_front();
+    list.pop_back();
+    EXPECT_EQ(list.size(), 1);
+    EXPECT_EQ(list.front().value, 2);
+    EXPECT_FALSE(entries[0].lru.linked());
+    EXPECT_TRUE(entries[1].lru.linked());
+}
+
+TEST(IntrusiveList, MultipleLists)
+{
+    Entry entries[] = { 1, 2, 3 };
+    LruList lru;
+    TimerList timers;
+
+    for (auto& entry : entries) {
+        lru.push_back(entry);
+        timers.push_front(entry);
+    }
+
+    EXPECT_EQ(lru.front().value, 1);
+    EXPECT_EQ(timers.front().value, 3);
+
+    lru.erase(entries[2]);
+    EXPECT_EQ(lru.size(), 2);
+    EXPECT_EQ(timers.size(), 3);
+}
+
+TEST(IntrusiveList, SelfRemoval)
+{
+    Entry first(1);
+    LruList list;
+    list.push_back(first);
+    {
+        Entry second(2);
+        list.push_back(second);
+        EXPECT_EQ(list.size(), 2);
+    }
+    EXPECT_EQ(list.size(), 1);
+
+    first.lru.unlink();
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(IntrusiveList, MoveToFront)
+{
+    Entry entries[] = { 1, 2, 3, 4 };
+    LruList list;
+    for (auto& entry : entries) {
+        list.push_back(entry);
+    }
+
+    list.move_to_front(entries[2]);
+    list.move_to_back(entries[0]);
+    list.insert(entries[3], entries[1]);
+
+    const int order[] = { 3, 2, 4, 1 };
+    int i = 0;
+    for (auto& entry : list) {
+        EXPECT_EQ(entry.value, order[i++]);
+    }
+    EXPECT_EQ(list.size(), 4);
+}
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
+#include "list-links.hpp"
 #include <functional>
+#include <queue>
 #include <stdexcept>
+#include <vector>
 
 template <typename T>
 class LinkedList {
@@ -18,21 +23,15 @@ protected:
 
         Node(T value, struct Node* prev, struct Node* next)
             : m_value(value)
-            , m_next(next)
-            , m_prev(prev)
         {
-            if (m_next != nullptr) {
-                m_next->m_prev = this;
-            }
-            if (m_prev != nullptr) {
-                m_prev->m_next = this;
-            }
+            detail::link_node(this, prev, next);
         }
     };
 
     struct Node* m_head;
     struct Node* m_tail;
     int m_size;
+    [[no_unique_address]] StatsRecorder m_stats;
 
     struct Iterator {
         using iterator_category = std::forward_iterator_tag;
@@ -72,6 +71,10 @@ protected:
         pointer m_ptr;
     };
 
+    static struct Node* merge_nodes(struct Node* left, struct Node* right, std::function<bool(T left, T right)>& comparator);
+    void relink(struct Node* head);
+    void count_comparisons(std::function<bool(T left, T right)>& comparator);
+
 public:
     Iterator begin() { return Iterator(m_head); }
 
@@ -110,6 +113,10 @@ public:
     void insert(int index, T value);
     void insert_ord(T value, std::function<bool(T left, T right)>);
 
+    void sort(std::function<bool(T left, T right)> comparator);
+    void merge(LinkedList<T>& other, std::function<bool(T left, T right)> comparator);
+    void merge(std::vector<LinkedList<T>*> lists, std::function<bool(T left, T right)> comparator);
+
     void erase(int index);
 
     void erase(Node it);
@@ -119,6 +126,12 @@ public:
     void reverse();
 
     int remove_value(int value);
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const { return m_stats.stats(); }
+    void reset_stats() { m_stats.reset(); }
+
+    MemoryUsage memory_usage() const;
 };
 
 template <typename T>
@@ -155,6 +168,7 @@ bool LinkedList<T>::empty()
 template <typename T>
 T LinkedList<T>::value_at(int index)
 {
+    auto timer = m_stats.time(Operation::Lookup);
     if (index < 0)
         throw std::invalid_argument("index cannot be negative");
     if (index == m_size - 1)
@@ -162,6 +176,7 @@ T LinkedList<T>::value_at(int index)
     struct Node* tmp = m_head;
 
     for (int i = 0; i < index; i++) {
+        m_stats.visit();
         tmp = tmp->m_next;
         if (tmp == nullptr)
             throw std::runtime_error("index out of range");
@@ -178,6 +193,8 @@ T LinkedList<T>::operator[](int index)
 template <typename T>
 void LinkedList<T>::push_front(T value)
 {
+    auto timer = m_stats.time(Operation::Insert);
+    m_stats.allocation();
     m_head = new Node(value, nullptr, m_head);
     m_size++;
     if (m_size == 1) {
@@ -188,8 +205,12 @@ void LinkedList<T>::push_front(T value)
 template <typename T>
 void LinkedList<T>::pop_front()
 {
+    auto timer = m_stats.time(Operation::Remove);
+    m_stats.deallocation();
     if (m_size == 1) {
         delete m_head;
+        m_head = nullptr;
+        m_tail = nullptr;
     } else {
         m_head = m_head->m_next;
         delete m_head->m_prev;
@@ -200,10 +221,12 @@ void LinkedList<T>::pop_front()
 template <typename T>
 void LinkedList<T>::push_back(T value)
 {
+    auto timer = m_stats.time(Operation::Insert);
     if (m_size < 1) {
         push_front(value);
         return;
     }
+    m_stats.allocation();
     m_tail = new Node(value, m_tail, nullptr);
     m_size++;
 }
@@ -211,10 +234,12 @@ void LinkedList<T>::push_back(T value)
 template <typename T>
 void LinkedList<T>::pop_back()
 {
+    auto timer = m_stats.time(Operation::Remove);
     if (m_size == 1) {
         pop_front();
         return;
     }
+    m_stats.deallocation();
 
     m_tail = m_tail->m_prev;
     delete m_tail->m_next;
@@ -237,6 +262,7 @@ T LinkedList<T>::back()
 template <typename T>
 void LinkedList<T>::insert(int index, T value)
 {
+    auto timer = m_stats.time(Operation::Insert);
     if (index >= m_size || index < 0)
         throw std::invalid_argument("index out of range");
     if (index == 0) {
@@ -246,8 +272,10 @@ void LinkedList<T>::insert(int index, T value)
 
     struct Node* tmp = m_head;
     for (int i = 0; i < index; i++) {
+        m_stats.visit();
         tmp = tmp->m_next;
     }
+    m_stats.allocation();
     tmp = new Node(value, tmp->m_prev, tmp);
     m_size++;
 }
@@ -255,6 +283,8 @@ void LinkedList<T>::insert(int index, T value)
 template <typename T>
 void LinkedList<T>::insert_ord(T value, std::function<bool(T left, T right)> comparator)
 {
+    auto timer = m_stats.time(Operation::Insert);
+    count_comparisons(comparator);
     if (m_size == 0 || !comparator(value, m_head->m_value)) {
         push_front(value);
         return;
@@ -262,15 +292,170 @@ void LinkedList<T>::insert_ord(T value, std::function<bool(T left, T right)> com
 
     struct Node* tmp = m_head;
     while (comparator(value, tmp->m_value)) {
+        m_stats.visit();
         tmp = tmp->m_next;
     }
+    m_stats.allocation();
     tmp = new Node(value, tmp->m_prev, tmp);
     m_size++;
 }
 
+// Merges two nullptr terminated chains linked through m_next. On ties the
+// node from the left chain goes first, which keeps the merge stable.
+template <typename T>
+struct LinkedList<T>::Node* LinkedList<T>::merge_nodes(struct Node* left, struct Node* right, std::function<bool(T left, T right)>& comparator)
+{
+    struct Node* head = nullptr;
+    struct Node** link = &head;
+    while (left != nullptr && right != nullptr) {
+        if (comparator(right->m_value, left->m_value)) {
+            *link = right;
+            right = right->m_next;
+        } else {
+            *link = left;
+            left = left->m_next;
+        }
+        link = &(*link)->m_next;
+    }
+    *link = left != nullptr ? left : right;
+    return head;
+}
+
+// Rebuilds the m_prev links and the head/tail pointers of a chain that was
+// only kept consistent through m_next.
+template <typename T>
+void LinkedList<T>::relink(struct Node* head)
+{
+    m_head = head;
+    m_tail = nullptr;
+    for (struct Node* curr = head; curr != nullptr; curr = curr->m_next) {
+        curr->m_prev = m_tail;
+        m_tail = curr;
+    }
+}
+
+// Every node is its own allocation, the two links are overhead.
+template <typename T>
+MemoryUsage LinkedList<T>::memory_usage() const
+{
+    MemoryUsage usage;
+    usage.m_elements = m_size;
+    usage.m_payload = uint64_t(m_size) * sizeof(T);
+    usage.m_overhead = uint64_t(m_size) * (sizeof(Node) - sizeof(T)) + sizeof(*this);
+    usage.allocations(sizeof(Node), m_size);
+    return usage;
+}
+
+// Wraps comparator to count its calls. Without DS_ENABLE_STATS the branch is
+// constant and comparator is left alone.
+template <typename T>
+void LinkedList<T>::count_comparisons(std::function<bool(T left, T right)>& comparator)
+{
+    if (StatsRecorder::enabled) {
+        comparator = [this, comparator](T left, T right) {
+            m_stats.comparison();
+            return comparator(left, right);
+        };
+    }
+}
+
+// Bottom-up merge sort. bins[i] holds a sorted run of 2^i nodes, so merging a
+// new node in works like incrementing a binary counter. Nodes are only
+// relinked, nothing is allocated or copied.
+template <typename T>
+void LinkedList<T>::sort(std::function<bool(T left, T right)> comparator)
+{
+    if (m_size < 2)
+        return;
+    count_comparisons(comparator);
+
+    constexpr int BINS = 64;
+    struct Node* bins[BINS] = {};
+    struct Node* curr = m_head;
+    while (curr != nullptr) {
+        struct Node* next = curr->m_next;
+        curr->m_next = nullptr;
+
+        int i = 0;
+        for (; i < BINS - 1 && bins[i] != nullptr; i++) {
+            curr = merge_nodes(bins[i], curr, comparator);
+            bins[i] = nullptr;
+        }
+        bins[i] = merge_nodes(bins[i], curr, comparator);
+        curr = next;
+    }
+
+    struct Node* head = nullptr;
+    for (int i = 0; i < BINS; i++) {
+        head = merge_nodes(bins[i], head, comparator);
+    }
+    relink(head);
+}
+
+// Merges the already sorted other list into this one. other is left empty.
+template <typename T>
+void LinkedList<T>::merge(LinkedList<T>& other, std::function<bool(T left, T right)> comparator)
+{
+    if (&other == this || other.m_size == 0)
+        return;
+    count_comparisons(comparator);
+
+    relink(merge_nodes(m_head, other.m_head, comparator));
+    m_size += other.m_size;
+
+    other.m_head = nullptr;
+    other.m_tail = nullptr;
+    other.m_size = 0;
+}
+
+// k-way merge of this list and the already sorted lists, using a heap of the
+// current head of every list. Equal values keep the order of the lists they
+// came from, this list being the first one. All the lists are left empty.
+template <typename T>
+void LinkedList<T>::merge(std::vector<LinkedList<T>*> lists, std::function<bool(T left, T right)> comparator)
+{
+    count_comparisons(comparator);
+    using Entry = std::pair<struct Node*, size_t>;
+    auto after = [&comparator](const Entry& left, const Entry& right) {
+        if (comparator(right.first->m_value, left.first->m_value))
+            return true;
+        if (comparator(left.first->m_value, right.first->m_value))
+            return false;
+        return left.second > right.second;
+    };
+    std::priority_queue<Entry, std::vector<Entry>, decltype(after)> heap(after);
+
+    if (m_head != nullptr)
+        heap.push({ m_head, 0 });
+    for (size_t i = 0; i < lists.size(); i++) {
+        LinkedList<T>* list = lists[i];
+        if (list == this || list->m_size == 0)
+            continue;
+        heap.push({ list->m_head, i + 1 });
+        m_size += list->m_size;
+        list->m_head = nullptr;
+        list->m_tail = nullptr;
+        list->m_size = 0;
+    }
+
+    struct Node* head = nullptr;
+    struct Node** link = &head;
+    while (!heap.empty()) {
+        Entry top = heap.top();
+        heap.pop();
+        *link = top.first;
+        link = &top.first->m_next;
+        if (top.first->m_next != nullptr)
+            heap.push({ top.first->m_next, top.second });
+    }
+    *link = nullptr;
+    relink(head);
+}
+
 template <typename T>
 void LinkedList<T>::erase(int index)
 {
+    auto timer = m_stats.time(Operation::Remove);
     if (index >= m_size || index < 0)
         throw std::invalid_argument("index out of range");
     if (index == 0) {
@@ -280,10 +465,13 @@ void LinkedList<T>::erase(int index)
 
     struct Node* tmp = m_head;
     for (int i = 0; i < index; i++) {
+        m_stats.visit();
         tmp = tmp->m_next;
     }
-    tmp->prev->m_next = tmp->m_next;
-    tmp->next->m_prev = tmp->m_prev;
+    if (tmp == m_tail)
+        m_tail = tmp->m_prev;
+    detail::unlink_node(tmp);
+    m_stats.deallocation();
     delete tmp;
     m_size--;
 }
@@ -291,12 +479,7 @@ void LinkedList<T>::erase(int index)
 template <typename T>
 void LinkedList<T>::erase(LinkedList<T>::Node it)
 {
-    if (it.m_next != nullptr) {
-        it.m_next->m_prev = it.m_prev;
-    }
-    if (it.m_prev != nullptr) {
-        it.m_prev->m_next = it.m_next;
-    }
+    detail::unlink_node(&it);
     m_size--;
 }
 
@@ -323,6 +506,7 @@ void LinkedList<T>::reverse()
 template <typename T>
 int LinkedList<T>::remove_value(int value)
 {
+    auto timer = m_stats.time(Operation::Remove);
     if (m_head->m_value == value) {
         pop_front();
         return 0;
@@ -330,6 +514,7 @@ int LinkedList<T>::remove_value(int value)
 
     struct Node* tmp = m_head;
     while (tmp != nullptr && tmp->m_value != value) {
+        m_stats.visit();
         tmp = tmp->m_next;
     }
 
@@ -339,11 +524,8 @@ int LinkedList<T>::remove_value(int value)
     if (tmp == m_tail)
         m_tail = tmp->m_prev;
 
-    if (tmp->m_prev != nullptr)
-        tmp->m_prev->m_next = tmp->m_next;
-
-    if (tmp->m_next != nullptr)
-        tmp->m_next->m_prev = tmp->m_prev;
+    detail::unlink_node(tmp);
+    m_stats.deallocation();
     delete tmp;
 
     m_size--;
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace detail {
+
+// Splices node in between prev and next. Either neighbour may be nullptr at
+// the ends of a nullptr terminated list, like LinkedList's.
+template <typename Node>
+void link_node(Node* node, Node* prev, Node* next)
+{
+    node->m_prev = prev;
+    node->m_next = next;
+    if (next != nullptr)
+        next->m_prev = node;
+    if (prev != nullptr)
+        prev->m_next = node;
+}
+
+// Joins the neighbours of node around it. The links of node itself are left
+// as they are.
+template <typename Node>
+void unlink_node(Node* node)
+{
+    if (node->m_next != nullptr)
+        node->m_next->m_prev = node->m_prev;
+    if (node->m_prev != nullptr)
+        node->m_prev->m_next = node->m_next;
+}
+
+}
@@ -1,4 +1,4 @@
-#include "linked_list.hpp"
+#include "linked-list.hpp"
 #include <gtest/gtest.h>
 
 TEST(LinkedList, InsertOrd)
@@ -17,3 +17,116 @@ TEST(LinkedList, InsertOrd)
     EXPECT_EQ(list[1], 8);
     EXPECT_EQ(list[2], 9);
 }
+
+TEST(LinkedList, Sort)
+{
+    LinkedList<int> list;
+    const int values[] = { 5, 3, 9, 1, 7, 3, 8 };
+    const int sorted[] = { 1, 3, 3, 5, 7, 8, 9 };
+
+    for (int value : values) {
+        list.push_back(value);
+    }
+    list.sort([](int left, int right) { return left < right; });
+
+    ASSERT_EQ(list.size(), 7);
+    int i = 0;
+    for (auto& node : list) {
+        EXPECT_EQ(node.m_value, sorted[i++]);
+    }
+    EXPECT_EQ(list.front(), 1);
+    EXPECT_EQ(list.back(), 9);
+
+    list.reverse();
+    EXPECT_EQ(list.front(), 9);
+    EXPECT_EQ(list.back(), 1);
+}
+
+TEST(LinkedList, SortStable)
+{
+    LinkedList<std::pair<int, int>> list;
+    for (int i = 0; i < 100; i++) {
+        list.push_back({ i % 4, i });
+    }
+    list.sort([](std::pair<int, int> left, std::pair<int, int> right) { return left.first < right.first; });
+
+    std::pair<int, int> prev = list.front();
+    list.pop_front();
+    while (!list.empty()) {
+        std::pair<int, int> curr = list.front();
+        list.pop_front();
+        EXPECT_LE(prev.first, curr.first);
+        if (prev.first == curr.first) {
+            EXPECT_LT(prev.second, curr.second);
+        }
+        prev = curr;
+    }
+}
+
+TEST(LinkedList, Merge)
+{
+    LinkedList<int> list;
+    LinkedList<int> other;
+    auto isSmaller = [](int left, int right) {
+        return left < right;
+    };
+
+    for (int i = 0; i < 10; i += 2) {
+        list.push_back(i);
+        other.push_back(i + 1);
+    }
+    list.merge(other, isSmaller);
+
+    EXPECT_TRUE(other.empty());
+    ASSERT_EQ(list.size(), 10);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(list[i], i);
+    }
+    EXPECT_EQ(list.back(), 9);
+}
+
+TEST(LinkedList, MergeK)
+{
+    LinkedList<int> list;
+    LinkedList<int> lists[3];
+    auto isSmaller = [](int left, int right) {
+        return left < right;
+    };
+
+    for (int i = 0; i < 12; i++) {
+        if (i % 4 == 0)
+            list.push_back(i);
+        else
+            lists[i % 4 - 1].push_back(i);
+    }
+    list.merge({ &lists[0], &lists[1], &lists[2] }, isSmaller);
+
+    ASSERT_EQ(list.size(), 12);
+    for (int i = 0; i < 12; i++) {
+        EXPECT_EQ(list[i], i);
+        EXPECT_TRUE(lists[i % 3].empty());
+    }
+    EXPECT_EQ(list.front(), 0);
+    EXPECT_EQ(list.back(), 11);
+}
+
+TEST(LinkedList, EraseAndRemove)
+{
+    LinkedList<int> list;
+    for (int value : { 1, 2, 3, 4, 5 }) {
+        list.push_back(value);
+    }
+
+    list.erase(2);
+    list.erase(3);
+    EXPECT_EQ(list.size(), 3);
+    EXPECT_EQ(list.back(), 4);
+    EXPECT_EQ(list.remove_value(4), 0);
+    EXPECT_EQ(list.remove_value(4), -1);
+    EXPECT_EQ(list.back(), 2);
+
+    list.insert(1, 7);
+    EXPECT_EQ(list[0], 1);
+    EXPECT_EQ(list[1], 7);
+    EXPECT_EQ(list[2], 2);
+}
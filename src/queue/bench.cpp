@@ -0,0 +1,443 @@
+#include "queue-arr.hpp"
+#include "queue-blocking.hpp"
+#include "queue-deque.hpp"
+#include "queue-list.hpp"
+#include "queue-mpmc.hpp"
+#include "queue-spsc.hpp"
+#include "queue.hpp"
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <pthread.h>
+#include <queue>
+#include <sched.h>
+#include <sys/resource.h>
+#include <thread>
+
+// Pins the calling thread to one core for the scope and then restores its
+// mask. New threads inherit their creator's mask, so a benchmark thread left
+// pinned would squeeze every later benchmark onto that core.
+class Pin {
+private:
+    cpu_set_t m_saved;
+
+public:
+    Pin(unsigned int cpu)
+    {
+        pthread_getaffinity_np(pthread_self(), sizeof(m_saved), &m_saved);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % std::thread::hardware_concurrency(), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+    ~Pin() { pthread_setaffinity_np(pthread_self(), sizeof(m_saved), &m_saved); }
+};
+
+static constexpr int64_t ITEMS = 1 << 22;
+
+// One producer and one consumer pinned to different cores, moving ITEMS
+// values per iteration in batches of state.range(0) (1 uses the single
+// element calls).
+static void BM_SPSCQueue(benchmark::State& state)
+{
+    if (std::thread::hardware_concurrency() < 2) {
+        state.SkipWithError("needs two cores, both sides busy wait");
+        return;
+    }
+
+    const size_t batch = state.range(0);
+    SPSCQueue<int64_t> queue(1 << 14);
+    std::vector<int64_t> in(batch), out(batch);
+
+    for (auto _ : state) {
+        std::thread consumer([&]() {
+            Pin pinned(1);
+            int64_t received = 0;
+            int64_t sum = 0;
+            while (received < ITEMS) {
+                if (batch == 1) {
+                    int64_t value;
+                    if (queue.try_dequeue(value)) {
+                        sum += value;
+                        received++;
+                    }
+                    continue;
+                }
+                size_t count = queue.try_dequeue_bulk(out.data(), batch);
+                for (size_t i = 0; i < count; i++) {
+                    sum += out[i];
+                }
+                received += count;
+            }
+            benchmark::DoNotOptimize(sum);
+        });
+
+        Pin pinned(0);
+        int64_t sent = 0;
+        while (sent < ITEMS) {
+            if (batch == 1) {
+                sent += queue.try_enqueue(sent);
+                continue;
+            }
+            for (size_t i = 0; i < batch; i++) {
+                in[i] = sent + i;
+            }
+            size_t count = static_cast<size_t>(ITEMS - sent) < batch ? ITEMS - sent : batch;
+            sent += queue.try_enqueue_bulk(in.data(), count);
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * ITEMS);
+}
+BENCHMARK(BM_SPSCQueue)->Arg(1)->Arg(16)->Arg(256)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Baseline: the same transfer through a std::queue behind a mutex.
+static void BM_MutexQueue(benchmark::State& state)
+{
+    std::queue<int64_t> queue;
+    std::mutex mutex;
+
+    for (auto _ : state) {
+        std::thread consumer([&]() {
+            Pin pinned(1);
+            int64_t received = 0;
+            int64_t sum = 0;
+            while (received < ITEMS) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!queue.empty()) {
+                    sum += queue.front();
+                    queue.pop();
+                    received++;
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        });
+
+        Pin pinned(0);
+        for (int64_t sent = 0; sent < ITEMS; sent++) {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push(sent);
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * ITEMS);
+}
+BENCHMARK(BM_MutexQueue)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Contention: every thread enqueues and then dequeues one value, so all the
+// threads hammer both ends of the same queue.
+static MPMCQueue<int64_t> s_mpmc(1 << 12);
+static LockFreeQueue<int64_t> s_lock_free;
+
+// Threads confined to one core only measure time slicing, so the runs with
+// more than one thread skip themselves rather than report that as
+// contention.
+static bool check_cores(benchmark::State& state)
+{
+    cpu_set_t set;
+    if (state.threads() > 1 && (sched_getaffinity(0, sizeof(set), &set) != 0 || CPU_COUNT(&set) < 2)) {
+        state.SkipWithError("needs two allowed cores, the affinity mask has one");
+        return false;
+    }
+    return true;
+}
+
+static void BM_MPMCQueueContention(benchmark::State& state)
+{
+    if (!check_cores(state))
+        return;
+    int64_t value = state.thread_index();
+    for (auto _ : state) {
+        s_mpmc.enqueue(value);
+        value = s_mpmc.dequeue();
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_MPMCQueueContention)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_LockFreeQueueContention(benchmark::State& state)
+{
+    if (!check_cores(state))
+        return;
+    int64_t value = state.thread_index();
+    for (auto _ : state) {
+        s_lock_free.enqueue(value);
+        value = s_lock_free.dequeue();
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_LockFreeQueueContention)->ThreadRange(1, 64)->UseRealTime();
+
+static std::queue<int64_t> s_locked;
+static std::mutex s_locked_mutex;
+
+static void BM_MutexQueueContention(benchmark::State& state)
+{
+    if (!check_cores(state))
+        return;
+    int64_t value = state.thread_index();
+    for (auto _ : state) {
+        {
+            std::lock_guard<std::mutex> lock(s_locked_mutex);
+            s_locked.push(value);
+        }
+        for (int i = 0;; detail::backoff(i)) {
+            std::lock_guard<std::mutex> lock(s_locked_mutex);
+            if (!s_locked.empty()) {
+                value = s_locked.front();
+                s_locked.pop();
+                break;
+            }
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_MutexQueueContention)->ThreadRange(1, 64)->UseRealTime();
+
+// Per operation cost of the same queue called directly, where the compiler
+// inlines everything, and through the type erased AnyQueue.
+template <typename Q>
+static void enqueue_dequeue(benchmark::State& state, Q& queue)
+{
+    int64_t value = 0;
+    for (auto _ : state) {
+        queue.enqueue(value);
+        queue.enqueue(value + 1);
+        value = queue.dequeue();
+        value += queue.dequeue();
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+
+// Kept out of line so the call sites only see an AnyQueue and cannot
+// devirtualize it.
+template <typename Q>
+[[gnu::noinline]] static AnyQueue<int64_t> erase(Q& queue)
+{
+    return AnyQueue<int64_t>(queue);
+}
+
+static void BM_ArrQueueDirect(benchmark::State& state)
+{
+    ArrQueue<int64_t> queue(1024);
+    enqueue_dequeue(state, queue);
+}
+BENCHMARK(BM_ArrQueueDirect);
+
+static void BM_ArrQueueErased(benchmark::State& state)
+{
+    ArrQueue<int64_t> arr(1024);
+    AnyQueue<int64_t> queue = erase(arr);
+    enqueue_dequeue(state, queue);
+}
+BENCHMARK(BM_ArrQueueErased);
+
+static void BM_ListQueueDirect(benchmark::State& state)
+{
+    ListQueue<int64_t> queue;
+    enqueue_dequeue(state, queue);
+}
+BENCHMARK(BM_ListQueueDirect);
+
+static void BM_ListQueueErased(benchmark::State& state)
+{
+    ListQueue<int64_t> list;
+    AnyQueue<int64_t> queue = erase(list);
+    enqueue_dequeue(state, queue);
+}
+BENCHMARK(BM_ListQueueErased);
+
+// Fills a queue with state.range(0) elements and drains it again.
+template <typename Q>
+static void fill_drain(benchmark::State& state, Q& queue)
+{
+    const int64_t count = state.range(0);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < count; i++) {
+            queue.enqueue(i);
+        }
+        int64_t sum = 0;
+        while (!queue.empty()) {
+            sum += queue.dequeue();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+}
+
+static void BM_BlockDequeFillDrain(benchmark::State& state)
+{
+    BlockDeque<int64_t> queue;
+    fill_drain(state, queue);
+}
+BENCHMARK(BM_BlockDequeFillDrain)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+
+static void BM_ArrQueueFillDrain(benchmark::State& state)
+{
+    ArrQueue<int64_t> queue(state.range(0) + 1);
+    fill_drain(state, queue);
+}
+BENCHMARK(BM_ArrQueueFillDrain)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+
+static void BM_ListQueueFillDrain(benchmark::State& state)
+{
+    ListQueue<int64_t> queue;
+    fill_drain(state, queue);
+}
+BENCHMARK(BM_ListQueueFillDrain)->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+
+// Moving batches of state.range(0) elements through an ArrQueue, one
+// element at a time and with the bulk calls.
+static void BM_ArrQueueSingle(benchmark::State& state)
+{
+    const size_t batch = state.range(0);
+    ArrQueue<int64_t> queue(batch + 1);
+    std::vector<int64_t> in(batch, 1), out(batch);
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch; i++) {
+            queue.enqueue(in[i]);
+        }
+        for (size_t i = 0; i < batch; i++) {
+            out[i] = queue.dequeue();
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ArrQueueSingle)->Arg(64)->Arg(1024);
+
+static void BM_ArrQueueBulk(benchmark::State& state)
+{
+    const size_t batch = state.range(0);
+    ArrQueue<int64_t> queue(batch + 1);
+    std::vector<int64_t> in(batch, 1), out(batch);
+    for (auto _ : state) {
+        queue.enqueue_bulk(in);
+        queue.dequeue_bulk(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ArrQueueBulk)->Arg(64)->Arg(1024);
+
+// Consuming in place: summing straight out of the buffer.
+static void BM_ArrQueueFrontSpan(benchmark::State& state)
+{
+    const size_t batch = state.range(0);
+    ArrQueue<int64_t> queue(batch + 1);
+    std::vector<int64_t> in(batch, 1);
+    for (auto _ : state) {
+        queue.enqueue_bulk(in);
+        int64_t sum = 0;
+        while (!queue.empty()) {
+            std::span<int64_t> front = queue.front_span();
+            for (int64_t value : front) {
+                sum += value;
+            }
+            queue.commit_read(front.size());
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ArrQueueFrontSpan)->Arg(64)->Arg(1024);
+
+// Round trip between two threads through two BlockingQueues: half of it is
+// the latency of waking a thread that waits in pop_wait().
+static void BM_BlockingQueuePingPong(benchmark::State& state)
+{
+    BlockingQueue<int64_t> ping(16), pong(16);
+    std::thread echo([&]() {
+        Pin pinned(1);
+        int64_t value;
+        while (ping.pop_wait(value)) {
+            pong.push_wait(value);
+        }
+    });
+
+    int64_t value = 0;
+    {
+        Pin pinned(0);
+        for (auto _ : state) {
+            ping.push_wait(value);
+            pong.pop_wait(value);
+        }
+    }
+    ping.close();
+    echo.join();
+    state.counters["one_way_seconds"] = benchmark::Counter(state.iterations() * 2, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_BlockingQueuePingPong)->UseRealTime();
+
+static double cpu_seconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// A producer hands over one element every state.range(0) microseconds
+// (0 is full speed). Reports the cores used by both threads together: a
+// consumer sleeping in pop_wait() against one spinning on try_dequeue().
+template <typename Push, typename Consume>
+static void paced(benchmark::State& state, Push push, Consume consume)
+{
+    constexpr int64_t ITEMS = 2000;
+    const auto gap = std::chrono::microseconds(state.range(0));
+    double cpu = 0;
+    double wall = 0;
+
+    for (auto _ : state) {
+        double cpu_start = cpu_seconds();
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&]() { consume(ITEMS); });
+        for (int64_t i = 0; i < ITEMS; i++) {
+            if (gap.count() > 0)
+                std::this_thread::sleep_for(gap);
+            push(i);
+        }
+        consumer.join();
+        wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cpu += cpu_seconds() - cpu_start;
+    }
+    state.counters["cpu_utilization"] = cpu / wall;
+    state.SetItemsProcessed(state.iterations() * ITEMS);
+}
+
+static void BM_BlockingQueuePaced(benchmark::State& state)
+{
+    BlockingQueue<int64_t> queue(1024);
+    paced(
+        state, [&](int64_t value) { queue.push_wait(value); },
+        [&](int64_t count) {
+            int64_t value;
+            for (int64_t i = 0; i < count; i++) {
+                queue.pop_wait(value);
+            }
+        });
+}
+BENCHMARK(BM_BlockingQueuePaced)->Arg(0)->Arg(100)->Iterations(2)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_SpinningConsumerPaced(benchmark::State& state)
+{
+    SPSCQueue<int64_t> queue(1024);
+    paced(
+        state,
+        [&](int64_t value) {
+            while (!queue.try_enqueue(value)) {
+                std::this_thread::yield();
+            }
+        },
+        [&](int64_t count) {
+            int64_t value;
+            for (int64_t i = 0; i < count;) {
+                i += queue.try_dequeue(value);
+            }
+        });
+}
+BENCHMARK(BM_SpinningConsumerPaced)->Arg(0)->Arg(100)->Iterations(2)->UseRealTime()->Unit(benchmark::kMillisecond);
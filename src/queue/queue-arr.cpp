@@ -1,44 +1,10 @@
+#include "queue-arr.hpp"
 #include "queue.hpp"
-#include <gtest //gtest.h>
-
-template <typename T>
-class ArrQueue : public Queue<T> {
-private:
-    T* m_queue;
-    size_t m_write;
-    size_t m_read;
-    size_t m_size;
-
-public:
-    ArrQueue(size_t size)
-        : m_write(0)
-        , m_read(0)
-        , m_size(size)
-    {
-        m_queue = new T[m_size];
-    }
-
-    void enqueue(T value) override
-    {
-        if ((m_write + 1) % m_size == m_read) {
-            throw std::runtime_error("Queue buffer would be full");
-        }
-        m_queue[m_write] = value;
-        m_write = (m_write + 1) % m_size;
-    }
-
-    T dequeue() override
-    {
-        T value = m_queue[m_read];
-        m_read = (m_read + 1) % m_size;
-        return value;
-    }
+#include <gtest/gtest.h>
 
-    bool empty() override
-    {
-        return m_write == m_read;
-    }
-};
+static_assert(Queue<ArrQueue<int>, int>);
+static_assert(!std::is_constructible_v<AnyQueue<int>, AnyQueue<int>&>);
+static_assert(std::is_move_constructible_v<AnyQueue<int>>);
 
 TEST(Queue, LinkedList)
 {
@@ -52,3 +18,70 @@ TEST(Queue, LinkedList)
     EXPECT_EQ(queue.dequeue(), 4);
     EXPECT_TRUE(queue.empty());
 }
+
+TEST(Queue, AnyQueue)
+{
+    ArrQueue<int> arr(4);
+    AnyQueue<int> queue(arr);
+
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(4);
+    queue.enqueue(5);
+    EXPECT_FALSE(arr.empty());
+
+    EXPECT_EQ(queue.dequeue(), 4);
+    EXPECT_EQ(arr.dequeue(), 5);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, ArrQueueBulk)
+{
+    ArrQueue<int> queue(8);
+    const int in[] = { 0, 1, 2, 3, 4, 5, 6 };
+    int out[7];
+
+    queue.enqueue_bulk(std::span(in, 5));
+    EXPECT_EQ(queue.dequeue_bulk(std::span(out, 4)), 4);
+    EXPECT_EQ(out[3], 3);
+
+    // Wraps around the end of the buffer.
+    EXPECT_THROW(queue.enqueue_bulk(in), std::runtime_error);
+    queue.enqueue_bulk(std::span(in, 6));
+    EXPECT_TRUE(queue.full());
+    EXPECT_EQ(queue.size(), 7);
+
+    EXPECT_EQ(queue.dequeue_bulk(out), 7);
+    EXPECT_EQ(out[0], 4);
+    for (int i = 1; i < 7; i++) {
+        EXPECT_EQ(out[i], i - 1);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.dequeue_bulk(out), 0);
+}
+
+TEST(Queue, ArrQueuePeek)
+{
+    ArrQueue<int> queue(4);
+    const int in[] = { 1, 2, 3 };
+
+    EXPECT_THROW(queue.peek(), std::runtime_error);
+    EXPECT_TRUE(queue.front_span().empty());
+
+    queue.enqueue_bulk(in);
+    queue.peek() = 10;
+    EXPECT_EQ(queue.front_span().size(), 3);
+    queue.commit_read(2);
+    EXPECT_EQ(queue.peek(), 3);
+
+    // The data now wraps, so the first span stops at the end of the buffer.
+    queue.enqueue_bulk(std::span(in, 2));
+    std::span<int> front = queue.front_span();
+    ASSERT_EQ(front.size(), 2);
+    EXPECT_EQ(front[0], 3);
+    EXPECT_EQ(front[1], 1);
+    queue.commit_read(front.size());
+    EXPECT_EQ(queue.front_span().size(), 1);
+    EXPECT_THROW(queue.commit_read(2), std::invalid_argument);
+    EXPECT_EQ(queue.dequeue(), 2);
+}
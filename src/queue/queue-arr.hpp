@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "queue.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+template <typename T>
+class ArrQueue {
+private:
+    T* m_queue;
+    size_t m_write;
+    size_t m_read;
+    size_t m_size;
+
+public:
+    ArrQueue(size_t size)
+        : m_write(0)
+        , m_read(0)
+        , m_size(size)
+    {
+        m_queue = new T[m_size];
+    }
+
+    ArrQueue(const ArrQueue&) = delete;
+    ArrQueue& operator=(const ArrQueue&) = delete;
+
+    ~ArrQueue()
+    {
+        delete[] m_queue;
+    }
+
+    void enqueue(T value)
+    {
+        if ((m_write + 1) % m_size == m_read) {
+            throw std::runtime_error("Queue buffer would be full");
+        }
+        m_queue[m_write] = value;
+        m_write = (m_write + 1) % m_size;
+    }
+
+    T dequeue()
+    {
+        T value = m_queue[m_read];
+        m_read = (m_read + 1) % m_size;
+        return value;
+    }
+
+    bool empty()
+    {
+        return m_write == m_read;
+    }
+
+    bool full()
+    {
+        return (m_write + 1) % m_size == m_read;
+    }
+
+    size_t size()
+    {
+        return (m_write + m_size - m_read) % m_size;
+    }
+
+    // Enqueues all the values or, if they do not fit, none of them. The run
+    // is copied with at most two copies, split at the end of the buffer.
+    void enqueue_bulk(std::span<const T> values)
+    {
+        if (values.size() > m_size - 1 - size()) {
+            throw std::runtime_error("Queue buffer would be full");
+        }
+        size_t first = std::min(values.size(), m_size - m_write);
+        detail::copy_elements(values.data(), first, m_queue + m_write);
+        detail::copy_elements(values.data() + first, values.size() - first, m_queue);
+        m_write = (m_write + values.size()) % m_size;
+    }
+
+    // Dequeues up to values.size() elements and returns how many it did.
+    size_t dequeue_bulk(std::span<T> values)
+    {
+        size_t count = std::min(values.size(), size());
+        size_t first = std::min(count, m_size - m_read);
+        detail::move_elements(m_queue + m_read, first, values.data());
+        detail::move_elements(m_queue, count - first, values.data() + first);
+        m_read = (m_read + count) % m_size;
+        return count;
+    }
+
+    // The next element to be dequeued, left in place.
+    T& peek()
+    {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return m_queue[m_read];
+    }
+
+    // The queued elements that are contiguous in the buffer from the next
+    // one to be dequeued. They stay queued until commit_read() is called.
+    std::span<T> front_span()
+    {
+        size_t end = m_write >= m_read ? m_write : m_size;
+        return { m_queue + m_read, end - m_read };
+    }
+
+    // The ring always keeps one slot free, it counts as slack with the
+    // rest of the unused slots.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        usage.m_elements = (m_write + m_size - m_read) % m_size;
+        usage.m_payload = usage.m_elements * sizeof(T);
+        usage.m_overhead = sizeof(*this);
+        usage.m_slack = (m_size - usage.m_elements) * sizeof(T);
+        usage.allocations(m_size * sizeof(T));
+        return usage;
+    }
+
+    // Dequeues count elements without copying them out.
+    void commit_read(size_t count)
+    {
+        if (count > size()) {
+            throw std::invalid_argument("cannot commit more than is queued");
+        }
+        m_read = (m_read + count) % m_size;
+    }
+};
@@ -0,0 +1,106 @@
+#include "queue-blocking.hpp"
+#include "queue.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static_assert(Queue<BlockingQueue<int>, int>);
+
+TEST(Queue, Blocking)
+{
+    BlockingQueue<int> queue(2);
+
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(4);
+    EXPECT_FALSE(queue.empty());
+
+    EXPECT_EQ(queue.dequeue(), 4);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, BlockingTimeout)
+{
+    BlockingQueue<int> queue(2);
+    int value;
+
+    EXPECT_FALSE(queue.try_pop(value));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_wait_for(value, 20ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.push_wait_for(2, 20ms));
+    EXPECT_FALSE(queue.try_push(3));
+    EXPECT_FALSE(queue.push_wait_for(3, 20ms));
+
+    EXPECT_TRUE(queue.pop_wait_for(value, 20ms));
+    EXPECT_EQ(value, 1);
+}
+
+TEST(Queue, BlockingClose)
+{
+    BlockingQueue<int> queue(4);
+    int value;
+
+    queue.push_wait(1);
+    queue.push_wait(2);
+    std::thread closer([&queue]() {
+        std::this_thread::sleep_for(10ms);
+        queue.close();
+    });
+
+    // What was queued before close() is still drained.
+    EXPECT_TRUE(queue.pop_wait(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(queue.pop_wait(value));
+    EXPECT_EQ(value, 2);
+    // Then the wait is ended by close().
+    EXPECT_FALSE(queue.pop_wait(value));
+    closer.join();
+
+    EXPECT_TRUE(queue.closed());
+    EXPECT_FALSE(queue.push_wait(3));
+    EXPECT_THROW(queue.enqueue(3), std::runtime_error);
+}
+
+TEST(Queue, BlockingThreads)
+{
+    constexpr int PRODUCERS = 3;
+    constexpr int CONSUMERS = 3;
+    constexpr int COUNT = 30000;
+    BlockingQueue<int> queue(8);
+    std::vector<std::thread> threads;
+    std::vector<long> sums(CONSUMERS, 0);
+
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = p; i < COUNT; i += PRODUCERS) {
+                queue.push_wait(i);
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&queue, &sums, c]() {
+            int value;
+            while (queue.pop_wait(value)) {
+                sums[c] += value;
+            }
+        });
+    }
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads[p].join();
+    }
+    queue.close();
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads[PRODUCERS + c].join();
+    }
+
+    long sum = 0;
+    for (long part : sums) {
+        sum += part;
+    }
+    EXPECT_EQ(sum, static_cast<long>(COUNT) * (COUNT - 1) / 2);
+}
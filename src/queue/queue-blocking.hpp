@@ -0,0 +1,274 @@
+#pragma once
+
+#include "queue-arr.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace detail {
+
+// Sleeps while word still holds expected, until woken by futex_wake(), or
+// until timeout (nullptr waits forever). Spurious returns are allowed.
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, const std::chrono::nanoseconds* timeout)
+{
+#ifdef __linux__
+    timespec ts;
+    if (timeout != nullptr) {
+        ts.tv_sec = timeout->count() / 1000000000;
+        ts.tv_nsec = timeout->count() % 1000000000;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, timeout != nullptr ? &ts : nullptr, nullptr, 0);
+#else
+    if (timeout == nullptr) {
+        word.wait(expected);
+    } else {
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(*timeout, std::chrono::microseconds(50)));
+    }
+#endif
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word, bool all)
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, all ? INT32_MAX : 1, nullptr, nullptr, 0);
+#else
+    if (all)
+        word.notify_all();
+    else
+        word.notify_one();
+#endif
+}
+
+}
+
+// Bounded queue on the ring of ArrQueue whose calls wait instead of failing:
+// pop_wait() sleeps while the queue is empty and push_wait() while it is
+// full. A waiting thread first spins for a while, adapting how long to how
+// often spinning paid off, and then sleeps on a futex. Wakeups only cost a
+// syscall when somebody is actually asleep.
+//
+// close() rejects new elements and wakes everybody up; consumers keep
+// popping what is left and get false once the queue is drained.
+template <typename T>
+class BlockingQueue {
+private:
+    static constexpr int MIN_SPIN = 16;
+    static constexpr int MAX_SPIN = 4096;
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::mutex m_mutex;
+    ArrQueue<T> m_queue;
+    bool m_closed;
+
+    // Event counters, bumped after every push (m_items) and every pop
+    // (m_space); they are the futex words the threads sleep on.
+    alignas(CACHE_LINE) std::atomic<uint32_t> m_items;
+    std::atomic<uint32_t> m_consumers_asleep;
+    alignas(CACHE_LINE) std::atomic<uint32_t> m_space;
+    std::atomic<uint32_t> m_producers_asleep;
+    alignas(CACHE_LINE) std::atomic<int> m_spin;
+
+    using clock = std::chrono::steady_clock;
+
+    void signal(std::atomic<uint32_t>& event, std::atomic<uint32_t>& asleep)
+    {
+        event.fetch_add(1, std::memory_order_seq_cst);
+        if (asleep.load(std::memory_order_seq_cst) > 0)
+            detail::futex_wake(event, false);
+    }
+
+    // Waits for event to move past seen. Returns false if the deadline
+    // passed first.
+    bool wait(std::atomic<uint32_t>& event, std::atomic<uint32_t>& asleep, uint32_t seen, const clock::time_point* deadline)
+    {
+        int spin = m_spin.load(std::memory_order_relaxed);
+        for (int i = 0; i < spin; i++) {
+            if (event.load(std::memory_order_acquire) != seen) {
+                m_spin.store(std::min(spin * 2, MAX_SPIN), std::memory_order_relaxed);
+                return true;
+            }
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        m_spin.store(std::max(spin / 2, MIN_SPIN), std::memory_order_relaxed);
+
+        std::chrono::nanoseconds timeout;
+        if (deadline != nullptr) {
+            timeout = *deadline - clock::now();
+            if (timeout.count() <= 0)
+                return false;
+        }
+        asleep.fetch_add(1, std::memory_order_seq_cst);
+        if (event.load(std::memory_order_seq_cst) == seen)
+            detail::futex_wait(event, seen, deadline != nullptr ? &timeout : nullptr);
+        asleep.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool push(T& value, const clock::time_point* deadline)
+    {
+        for (;;) {
+            uint32_t seen = m_space.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_closed)
+                    return false;
+                if (!m_queue.full()) {
+                    m_queue.enqueue(std::move(value));
+                    break;
+                }
+            }
+            if (!wait(m_space, m_producers_asleep, seen, deadline))
+                return false;
+        }
+        signal(m_items, m_consumers_asleep);
+        return true;
+    }
+
+    bool pop(T& value, const clock::time_point* deadline)
+    {
+        for (;;) {
+            uint32_t seen = m_items.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_queue.empty()) {
+                    value = m_queue.dequeue();
+                    break;
+                }
+                if (m_closed)
+                    return false;
+            }
+            if (!wait(m_items, m_consumers_asleep, seen, deadline))
+                return false;
+        }
+        signal(m_space, m_producers_asleep);
+        return true;
+    }
+
+public:
+    BlockingQueue(size_t capacity)
+        : m_queue(capacity + 1)
+        , m_closed(false)
+        , m_items(0)
+        , m_consumers_asleep(0)
+        , m_space(0)
+        , m_producers_asleep(0)
+        , m_spin(MIN_SPIN)
+    {
+    }
+
+    BlockingQueue(const BlockingQueue&) = delete;
+    BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+    // Waits for a free slot. Returns false if the queue is closed.
+    bool push_wait(T value)
+    {
+        return push(value, nullptr);
+    }
+
+    // Waits for an element. Returns false once the queue is closed and
+    // drained.
+    bool pop_wait(T& value)
+    {
+        return pop(value, nullptr);
+    }
+
+    // Like push_wait(), also returning false if no slot freed up in time.
+    template <typename Rep, typename Period>
+    bool push_wait_for(T value, std::chrono::duration<Rep, Period> timeout)
+    {
+        clock::time_point deadline = clock::now() + timeout;
+        return push(value, &deadline);
+    }
+
+    // Like pop_wait(), also returning false if no element came in time.
+    template <typename Rep, typename Period>
+    bool pop_wait_for(T& value, std::chrono::duration<Rep, Period> timeout)
+    {
+        clock::time_point deadline = clock::now() + timeout;
+        return pop(value, &deadline);
+    }
+
+    bool try_push(T value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed || m_queue.full())
+                return false;
+            m_queue.enqueue(std::move(value));
+        }
+        signal(m_items, m_consumers_asleep);
+        return true;
+    }
+
+    bool try_pop(T& value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_queue.empty())
+                return false;
+            value = m_queue.dequeue();
+        }
+        signal(m_space, m_producers_asleep);
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_items.fetch_add(1, std::memory_order_seq_cst);
+        m_space.fetch_add(1, std::memory_order_seq_cst);
+        detail::futex_wake(m_items, true);
+        detail::futex_wake(m_space, true);
+    }
+
+    bool closed()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    void enqueue(T value)
+    {
+        if (!push_wait(std::move(value))) {
+            throw std::runtime_error("Queue is closed");
+        }
+    }
+
+    T dequeue()
+    {
+        T value;
+        if (!pop_wait(value)) {
+            throw std::runtime_error("Queue is closed");
+        }
+        return value;
+    }
+
+    bool empty()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.empty();
+    }
+
+    MemoryUsage memory_usage()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MemoryUsage usage = m_queue.memory_usage();
+        usage.m_overhead += sizeof(*this) - sizeof(m_queue);
+        return usage;
+    }
+};
@@ -0,0 +1,129 @@
+#include "queue-deque.hpp"
+#include "queue.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+static_assert(Queue<BlockDeque<int>, int>);
+
+TEST(Queue, BlockDeque)
+{
+    BlockDeque<int> queue;
+
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(4);
+    EXPECT_FALSE(queue.empty());
+
+    EXPECT_EQ(queue.dequeue(), 4);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, BlockDequeFifo)
+{
+    BlockDeque<int> queue;
+    int next = 0;
+
+    // Keeps a window of elements sliding through many blocks, so blocks are
+    // released at the front and reused at the back.
+    for (int i = 0; i < 100000; i++) {
+        queue.enqueue(i);
+        if (i % 3 != 0) {
+            EXPECT_EQ(queue.dequeue(), next++);
+        }
+    }
+    EXPECT_EQ(queue.size(), 100000 - next);
+    while (!queue.empty()) {
+        EXPECT_EQ(queue.dequeue(), next++);
+    }
+    EXPECT_EQ(next, 100000);
+}
+
+TEST(Queue, BlockDequeBothEnds)
+{
+    BlockDeque<int> deque;
+
+    for (int i = 0; i < 5000; i++) {
+        deque.push_back(i);
+        deque.push_front(-i - 1);
+    }
+    ASSERT_EQ(deque.size(), 10000);
+    EXPECT_EQ(deque.front(), -5000);
+    EXPECT_EQ(deque.back(), 4999);
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_EQ(deque[i], i - 5000);
+    }
+
+    for (int i = 0; i < 5000; i++) {
+        deque.pop_front();
+    }
+    EXPECT_EQ(deque.front(), 0);
+    while (deque.size() > 1) {
+        deque.pop_back();
+    }
+    EXPECT_EQ(deque.back(), 0);
+    deque.pop_back();
+    EXPECT_TRUE(deque.empty());
+    EXPECT_THROW(deque.pop_back(), std::runtime_error);
+
+    deque.push_front(1);
+    EXPECT_EQ(deque.at(0), 1);
+    EXPECT_THROW(deque.at(1), std::invalid_argument);
+}
+
+TEST(Queue, BlockDequeDestroysElements)
+{
+    BlockDeque<std::string> deque;
+    std::string& first = (deque.push_back("first"), deque.front());
+
+    for (int i = 0; i < 1000; i++) {
+        deque.push_back(std::to_string(i) + " long enough to live on the heap");
+        deque.push_front(std::to_string(i) + " long enough to live on the heap");
+    }
+    // Growing never moves what is already stored.
+    EXPECT_EQ(first, "first");
+    deque.pop_back();
+    deque.pop_front();
+    EXPECT_EQ(deque.size(), 1999);
+}
+
+TEST(Queue, BlockDequeBulk)
+{
+    BlockDeque<int> queue;
+    std::vector<int> in(10000);
+    std::vector<int> out(10000);
+    for (int i = 0; i < 10000; i++) {
+        in[i] = i;
+    }
+
+    queue.enqueue(-1);
+    queue.enqueue_bulk(in);
+    EXPECT_EQ(queue.size(), 10001);
+    EXPECT_EQ(queue.peek(), -1);
+    queue.commit_read(1);
+
+    EXPECT_EQ(queue.dequeue_bulk(std::span(out.data(), 6000)), 6000);
+    EXPECT_EQ(queue.dequeue_bulk(std::span(out.data() + 6000, 6000)), 4000);
+    EXPECT_EQ(out, in);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_TRUE(queue.front_span().empty());
+}
+
+TEST(Queue, BlockDequeFrontSpan)
+{
+    BlockDeque<int> queue;
+    for (int i = 0; i < 5000; i++) {
+        queue.enqueue(i);
+    }
+
+    int expected = 0;
+    while (!queue.empty()) {
+        std::span<int> front = queue.front_span();
+        ASSERT_FALSE(front.empty());
+        for (int value : front) {
+            EXPECT_EQ(value, expected++);
+        }
+        queue.commit_read(front.size());
+    }
+    EXPECT_EQ(expected, 5000);
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+// Double ended queue storing its elements in fixed size blocks. The blocks
+// are kept in a ring of block pointers (the map), so pushing or popping at
+// either end is O(1), growing only copies block pointers and never moves an
+// element, and blocks emptied at one end are kept aside and reused at the
+// other end instead of going back to the allocator.
+template <typename T>
+class BlockDeque {
+private:
+    static constexpr size_t BLOCK_BYTES = 4096;
+    static constexpr size_t BLOCK_SIZE = sizeof(T) * 16 > BLOCK_BYTES ? 16 : BLOCK_BYTES / sizeof(T);
+    static constexpr size_t SPARE_BLOCKS = 4;
+
+    // Ring of m_map_mask + 1 block pointers, the m_blocks used ones start at
+    // m_first. The first element is at offset m_start of the first block.
+    T** m_map;
+    size_t m_map_mask;
+    size_t m_first;
+    size_t m_blocks;
+    size_t m_start;
+    size_t m_size;
+
+    T* m_spare[SPARE_BLOCKS];
+    size_t m_spares;
+
+    T*& block(size_t index)
+    {
+        return m_map[(m_first + index) & m_map_mask];
+    }
+
+    T* slot(size_t index)
+    {
+        size_t pos = m_start + index;
+        return block(pos / BLOCK_SIZE) + pos % BLOCK_SIZE;
+    }
+
+    T* acquire_block()
+    {
+        if (m_spares > 0)
+            return m_spare[--m_spares];
+        return static_cast<T*>(::operator new(BLOCK_SIZE * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void release_block(T* block)
+    {
+        if (m_spares < SPARE_BLOCKS) {
+            m_spare[m_spares++] = block;
+            return;
+        }
+        ::operator delete(block, std::align_val_t(alignof(T)));
+    }
+
+    // Doubles the map, copying the used block pointers to its front.
+    void grow_map()
+    {
+        size_t capacity = (m_map_mask + 1) * 2;
+        T** map = new T*[capacity];
+        for (size_t i = 0; i < m_blocks; i++) {
+            map[i] = block(i);
+        }
+        delete[] m_map;
+        m_map = map;
+        m_map_mask = capacity - 1;
+        m_first = 0;
+    }
+
+public:
+    BlockDeque()
+        : m_map(new T*[8])
+        , m_map_mask(7)
+        , m_first(0)
+        , m_blocks(0)
+        , m_start(0)
+        , m_size(0)
+        , m_spare {}
+        , m_spares(0)
+    {
+    }
+
+    BlockDeque(const BlockDeque&) = delete;
+    BlockDeque& operator=(const BlockDeque&) = delete;
+
+    ~BlockDeque()
+    {
+        clear();
+        for (size_t i = 0; i < m_blocks; i++) {
+            ::operator delete(block(i), std::align_val_t(alignof(T)));
+        }
+        while (m_spares > 0) {
+            ::operator delete(m_spare[--m_spares], std::align_val_t(alignof(T)));
+        }
+        delete[] m_map;
+    }
+
+    size_t size()
+    {
+        return m_size;
+    }
+
+    // The map is overhead. The unused slots of the end blocks and the spare
+    // blocks kept for reuse are slack.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        usage.m_elements = m_size;
+        usage.m_payload = m_size * sizeof(T);
+        usage.m_overhead = (m_map_mask + 1) * sizeof(T*) + sizeof(*this);
+        usage.m_slack = ((m_blocks + m_spares) * BLOCK_SIZE - m_size) * sizeof(T);
+        usage.allocations(BLOCK_SIZE * sizeof(T), m_blocks + m_spares);
+        usage.allocations((m_map_mask + 1) * sizeof(T*));
+        return usage;
+    }
+
+    bool empty()
+    {
+        return m_size == 0;
+    }
+
+    T& operator[](size_t index)
+    {
+        return *slot(index);
+    }
+
+    T& at(size_t index)
+    {
+        if (index >= m_size)
+            throw std::invalid_argument("index out of range");
+        return *slot(index);
+    }
+
+    T& front()
+    {
+        return *slot(0);
+    }
+
+    T& back()
+    {
+        return *slot(m_size - 1);
+    }
+
+    void push_back(T value)
+    {
+        if (m_start + m_size == m_blocks * BLOCK_SIZE) {
+            if (m_blocks == m_map_mask + 1)
+                grow_map();
+            block(m_blocks) = acquire_block();
+            m_blocks++;
+        }
+        new (slot(m_size)) T(std::move(value));
+        m_size++;
+    }
+
+    void push_front(T value)
+    {
+        if (m_start == 0) {
+            if (m_blocks == m_map_mask + 1)
+                grow_map();
+            m_first = (m_first - 1) & m_map_mask;
+            block(0) = acquire_block();
+            m_blocks++;
+            m_start = BLOCK_SIZE;
+        }
+        m_start--;
+        new (slot(0)) T(std::move(value));
+        m_size++;
+    }
+
+    void pop_front()
+    {
+        if (m_size == 0)
+            throw std::runtime_error("pop from an empty deque");
+        commit_read(1);
+    }
+
+    void pop_back()
+    {
+        if (m_size == 0)
+            throw std::runtime_error("pop from an empty deque");
+        slot(m_size - 1)->~T();
+        m_size--;
+        if (m_start + m_size <= (m_blocks - 1) * BLOCK_SIZE) {
+            m_blocks--;
+            release_block(block(m_blocks));
+            if (m_size == 0)
+                m_start = 0;
+        }
+    }
+
+    void clear()
+    {
+        while (m_size > 0) {
+            pop_back();
+        }
+    }
+
+    void enqueue(T value)
+    {
+        push_back(std::move(value));
+    }
+
+    // Appends all the values, one copy per block they land in.
+    void enqueue_bulk(std::span<const T> values)
+    {
+        size_t done = 0;
+        while (done < values.size()) {
+            size_t end = m_start + m_size;
+            if (end == m_blocks * BLOCK_SIZE) {
+                if (m_blocks == m_map_mask + 1)
+                    grow_map();
+                block(m_blocks) = acquire_block();
+                m_blocks++;
+            }
+            size_t offset = end % BLOCK_SIZE;
+            size_t count = std::min(values.size() - done, BLOCK_SIZE - offset);
+            std::uninitialized_copy_n(values.data() + done, count, block(end / BLOCK_SIZE) + offset);
+            m_size += count;
+            done += count;
+        }
+    }
+
+    // Dequeues up to values.size() elements and returns how many it did.
+    size_t dequeue_bulk(std::span<T> values)
+    {
+        size_t count = std::min(values.size(), m_size);
+        size_t done = 0;
+        while (done < count) {
+            std::span<T> front = front_span();
+            size_t run = std::min(front.size(), count - done);
+            std::move(front.begin(), front.begin() + run, values.begin() + done);
+            commit_read(run);
+            done += run;
+        }
+        return count;
+    }
+
+    T& peek()
+    {
+        if (m_size == 0)
+            throw std::runtime_error("Queue is empty");
+        return front();
+    }
+
+    // The elements at the front that live in the same block, left in place
+    // until commit_read() is called.
+    std::span<T> front_span()
+    {
+        if (m_size == 0)
+            return {};
+        return { slot(0), std::min(m_size, BLOCK_SIZE - m_start) };
+    }
+
+    // Drops count elements from the front, handing emptied blocks back to
+    // the spare pool.
+    void commit_read(size_t count)
+    {
+        if (count > m_size)
+            throw std::invalid_argument("cannot commit more than is queued");
+        while (count > 0) {
+            size_t run = std::min(count, BLOCK_SIZE - m_start);
+            std::destroy_n(slot(0), run);
+            m_start += run;
+            m_size -= run;
+            count -= run;
+            if (m_start == BLOCK_SIZE || m_size == 0) {
+                release_block(block(0));
+                m_first = (m_first + 1) & m_map_mask;
+                m_blocks--;
+                m_start = 0;
+            }
+        }
+    }
+
+    T dequeue()
+    {
+        if (m_size == 0)
+            throw std::runtime_error("Queue is empty");
+        T value = std::move(front());
+        pop_front();
+        return value;
+    }
+};
@@ -1,30 +1,8 @@
-#include "../linked_list/linked_list.hpp"
+#include "queue-list.hpp"
 #include "queue.hpp"
-#include <gtest //gtest.h>
+#include <gtest/gtest.h>
 
-template <typename T>
-class ListQueue : public Queue<T> {
-private:
-    LinkedList<T> m_queue;
-
-public:
-    void enqueue(T value) override
-    {
-        m_queue.push_back(value);
-    }
-
-    T dequeue() override
-    {
-        T value = m_queue.value_n_from_end(0);
-        m_queue.pop_back();
-        return value;
-    }
-
-    bool empty() override
-    {
-        return m_queue.empty();
-    }
-};
+static_assert(Queue<ListQueue<int>, int>);
 
 TEST(Queue, LinkedList)
 {
@@ -38,3 +16,16 @@ TEST(Queue, LinkedList)
     EXPECT_EQ(queue.dequeue(), 4);
     EXPECT_TRUE(queue.empty());
 }
+
+TEST(Queue, LinkedListFifo)
+{
+    ListQueue<int> queue;
+
+    for (int i = 0; i < 10; i++) {
+        queue.enqueue(i);
+    }
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(queue.dequeue(), i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../linked-list/linked-list.hpp"
+
+template <typename T>
+class ListQueue {
+private:
+    LinkedList<T> m_queue;
+
+public:
+    void enqueue(T value)
+    {
+        m_queue.push_back(value);
+    }
+
+    T dequeue()
+    {
+        T value = m_queue.front();
+        m_queue.pop_front();
+        return value;
+    }
+
+    bool empty()
+    {
+        return m_queue.empty();
+    }
+
+    MemoryUsage memory_usage() const
+    {
+        return m_queue.memory_usage();
+    }
+};
@@ -0,0 +1,104 @@
+#include "queue-mpmc.hpp"
+#include "queue.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+static_assert(Queue<MPMCQueue<int>, int>);
+static_assert(Queue<LockFreeQueue<int>, int>);
+
+// Runs producers and consumers over the same queue and checks that every
+// value came out exactly once.
+template <typename Q>
+static void transfer(Q& queue, int producers, int consumers, int count)
+{
+    std::vector<std::thread> threads;
+    std::vector<std::vector<int>> received(consumers);
+
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p, producers, count]() {
+            for (int i = p; i < count; i += producers) {
+                queue.enqueue(i);
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&queue, &received, c, consumers, count]() {
+            for (int i = c; i < count; i += consumers) {
+                received[c].push_back(queue.dequeue());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<bool> seen(count, false);
+    for (auto& values : received) {
+        for (int value : values) {
+            ASSERT_FALSE(seen[value]);
+            seen[value] = true;
+        }
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, MPMC)
+{
+    MPMCQueue<int> queue(2);
+
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(4);
+    EXPECT_FALSE(queue.empty());
+
+    EXPECT_EQ(queue.dequeue(), 4);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, MPMCFull)
+{
+    MPMCQueue<int> queue(4);
+    int value;
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_enqueue(i));
+    }
+    EXPECT_FALSE(queue.try_enqueue(4));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_dequeue(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_dequeue(value));
+}
+
+TEST(Queue, MPMCThreads)
+{
+    MPMCQueue<int> queue(16);
+    transfer(queue, 4, 4, 1 << 16);
+}
+
+TEST(Queue, LockFree)
+{
+    LockFreeQueue<int> queue;
+    int value;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.try_dequeue(value));
+
+    for (int i = 0; i < 100; i++) {
+        queue.enqueue(i);
+    }
+    EXPECT_FALSE(queue.empty());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(queue.dequeue(), i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, LockFreeThreads)
+{
+    LockFreeQueue<int> queue;
+    transfer(queue, 4, 4, 1 << 16);
+}
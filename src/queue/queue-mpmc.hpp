@@ -0,0 +1,279 @@
+#pragma once
+
+#include "../reclamation/hazard-pointers.hpp"
+#include "../stats/memory-usage.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace detail {
+
+// Spins for a while and then starts yielding the core, used by the blocking
+// calls of the lock-free queues while they wait for an element or a slot.
+inline void backoff(int& iteration)
+{
+    if (iteration < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        std::this_thread::yield();
+    }
+    iteration++;
+}
+
+}
+
+// Bounded multi-producer/multi-consumer queue (Dmitry Vyukov's design). Every
+// slot carries a sequence number telling whose turn it is: a producer at
+// position pos may write the slot once its sequence is pos, a consumer may
+// read it once it is pos + 1. Producers and consumers only contend on their
+// own position counter.
+template <typename T>
+class MPMCQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Cell {
+        std::atomic<size_t> m_sequence;
+        T m_value;
+    };
+
+    alignas(CACHE_LINE) std::atomic<size_t> m_write;
+    alignas(CACHE_LINE) std::atomic<size_t> m_read;
+    alignas(CACHE_LINE) Cell* m_queue;
+    size_t m_mask;
+
+public:
+    MPMCQueue(size_t capacity)
+        : m_write(0)
+        , m_read(0)
+        , m_mask(std::bit_ceil(capacity < 2 ? 2 : capacity) - 1)
+    {
+        m_queue = new Cell[m_mask + 1];
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_queue[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    ~MPMCQueue()
+    {
+        delete[] m_queue;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    // The element count is a snapshot while other threads are running. The
+    // sequence number of every cell is overhead.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        size_t read = m_read.load(std::memory_order_acquire);
+        size_t write = m_write.load(std::memory_order_acquire);
+        usage.m_elements = write > read ? std::min<uint64_t>(write - read, capacity()) : 0;
+        usage.m_payload = usage.m_elements * sizeof(T);
+        usage.m_overhead = capacity() * (sizeof(Cell) - sizeof(T)) + sizeof(*this);
+        usage.m_slack = (capacity() - usage.m_elements) * sizeof(T);
+        usage.allocations(capacity() * sizeof(Cell));
+        return usage;
+    }
+
+    bool try_enqueue(const T& value)
+    {
+        size_t pos = m_write.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_queue[pos & m_mask];
+            size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_write.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_write.load(std::memory_order_relaxed);
+            }
+        }
+        cell->m_value = value;
+        cell->m_sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_dequeue(T& value)
+    {
+        size_t pos = m_read.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_queue[pos & m_mask];
+            size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_read.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_read.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->m_value);
+        cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waits for a free slot.
+    void enqueue(T value)
+    {
+        for (int i = 0; !try_enqueue(value);) {
+            detail::backoff(i);
+        }
+    }
+
+    // Waits for an element.
+    T dequeue()
+    {
+        T value;
+        for (int i = 0; !try_dequeue(value);) {
+            detail::backoff(i);
+        }
+        return value;
+    }
+
+    // Only a snapshot while other threads are using the queue.
+    bool empty()
+    {
+        return m_read.load(std::memory_order_acquire) >= m_write.load(std::memory_order_acquire);
+    }
+};
+
+// Unbounded multi-producer/multi-consumer queue (Michael & Scott). The head
+// always points at a dummy node; dequeuing swings the head to the next node
+// and retires the old dummy through HazardPointers, so no thread can be left
+// reading freed memory.
+template <typename T>
+class LockFreeQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Node {
+        std::atomic<Node*> m_next;
+        T m_value;
+
+        Node()
+            : m_next(nullptr)
+            , m_value() {};
+
+        Node(const T& value)
+            : m_next(nullptr)
+            , m_value(value) {};
+    };
+
+    alignas(CACHE_LINE) std::atomic<Node*> m_head;
+    alignas(CACHE_LINE) std::atomic<Node*> m_tail;
+
+public:
+    LockFreeQueue()
+    {
+        Node* dummy = new Node;
+        m_head.store(dummy, std::memory_order_relaxed);
+        m_tail.store(dummy, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    ~LockFreeQueue()
+    {
+        Node* curr = m_head.load(std::memory_order_relaxed);
+        while (curr != nullptr) {
+            Node* next = curr->m_next.load(std::memory_order_relaxed);
+            delete curr;
+            curr = next;
+        }
+    }
+
+    // Never fails, the queue grows as needed.
+    bool try_enqueue(const T& value)
+    {
+        Node* node = new Node(value);
+        for (;;) {
+            Node* tail = HazardPointers::protect(0, m_tail);
+            Node* next = tail->m_next.load(std::memory_order_acquire);
+            if (tail != m_tail.load(std::memory_order_acquire))
+                continue;
+            if (next != nullptr) {
+                // Another producer linked a node but did not move the tail yet.
+                m_tail.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (tail->m_next.compare_exchange_weak(next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                m_tail.compare_exchange_strong(tail, node, std::memory_order_release, std::memory_order_relaxed);
+                break;
+            }
+        }
+        HazardPointers::clear();
+        return true;
+    }
+
+    bool try_dequeue(T& value)
+    {
+        for (;;) {
+            Node* head = HazardPointers::protect(0, m_head);
+            Node* tail = m_tail.load(std::memory_order_acquire);
+            Node* next = HazardPointers::protect(1, head->m_next);
+            if (head != m_head.load(std::memory_order_acquire))
+                continue;
+            if (next == nullptr) {
+                HazardPointers::clear();
+                return false;
+            }
+            if (head == tail) {
+                m_tail.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            // Copied before the CAS: once the head moves, next is the new
+            // dummy and another consumer may already be moving past it.
+            T result = next->m_value;
+            if (m_head.compare_exchange_strong(head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                HazardPointers::clear();
+                HazardPointers::retire(head);
+                value = std::move(result);
+                return true;
+            }
+        }
+    }
+
+    void enqueue(T value)
+    {
+        try_enqueue(value);
+    }
+
+    // Waits for an element.
+    T dequeue()
+    {
+        T value;
+        for (int i = 0; !try_dequeue(value);) {
+            detail::backoff(i);
+        }
+        return value;
+    }
+
+    // Only a snapshot while other threads are using the queue.
+    bool empty()
+    {
+        Node* head = HazardPointers::protect(0, m_head);
+        bool empty = head->m_next.load(std::memory_order_acquire) == nullptr;
+        HazardPointers::clear();
+        return empty;
+    }
+};
@@ -0,0 +1,119 @@
+#include "queue-spsc.hpp"
+#include "queue.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+static_assert(Queue<SPSCQueue<int>, int>);
+
+TEST(Queue, SPSC)
+{
+    SPSCQueue<int> queue(3);
+
+    EXPECT_EQ(queue.capacity(), 4);
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(4);
+    EXPECT_FALSE(queue.empty());
+
+    EXPECT_EQ(queue.dequeue(), 4);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, SPSCFull)
+{
+    SPSCQueue<int> queue(4);
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_enqueue(i));
+    }
+    EXPECT_FALSE(queue.try_enqueue(4));
+    EXPECT_THROW(queue.enqueue(4), std::runtime_error);
+
+    int value;
+    EXPECT_TRUE(queue.try_dequeue(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.try_enqueue(4));
+}
+
+TEST(Queue, SPSCBulkWrap)
+{
+    SPSCQueue<int> queue(8);
+    int in[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    int out[8];
+
+    EXPECT_EQ(queue.try_enqueue_bulk(in, 6), 6);
+    EXPECT_EQ(queue.try_dequeue_bulk(out, 5), 5);
+
+    // Wraps around the end of the buffer.
+    EXPECT_EQ(queue.try_enqueue_bulk(in, 8), 7);
+    EXPECT_EQ(queue.try_dequeue_bulk(out, 8), 8);
+    EXPECT_EQ(out[0], 5);
+    for (int i = 1; i < 8; i++) {
+        EXPECT_EQ(out[i], i - 1);
+    }
+    EXPECT_EQ(queue.try_dequeue_bulk(out, 8), 0);
+}
+
+TEST(Queue, SPSCThreads)
+{
+    constexpr int COUNT = 1 << 18;
+    SPSCQueue<int> queue(64);
+
+    std::thread producer([&queue]() {
+        int batch[16];
+        int next = 0;
+        while (next < COUNT) {
+            size_t pushed;
+            if (next % 3 == 0) {
+                pushed = queue.try_enqueue(next);
+            } else {
+                int count = 0;
+                for (; count < 16 && next + count < COUNT; count++) {
+                    batch[count] = next + count;
+                }
+                pushed = queue.try_enqueue_bulk(batch, count);
+            }
+            if (pushed == 0)
+                std::this_thread::yield();
+            next += pushed;
+        }
+    });
+
+    int expected = 0;
+    int batch[16];
+    while (expected < COUNT) {
+        size_t count = queue.try_dequeue_bulk(batch, expected % 2 ? 16 : 1);
+        if (count == 0)
+            std::this_thread::yield();
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_EQ(batch[i], expected++);
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(Queue, SPSCPeek)
+{
+    SPSCQueue<int> queue(4);
+    const int in[] = { 1, 2, 3 };
+
+    EXPECT_TRUE(queue.front_span().empty());
+    EXPECT_THROW(queue.peek(), std::runtime_error);
+
+    EXPECT_EQ(queue.try_enqueue_bulk(std::span(in)), 3);
+    EXPECT_EQ(queue.peek(), 1);
+    queue.commit_read(3);
+
+    EXPECT_EQ(queue.try_enqueue_bulk(std::span(in)), 3);
+    std::span<int> front = queue.front_span();
+    ASSERT_EQ(front.size(), 1);
+    EXPECT_EQ(front[0], 1);
+    queue.commit_read(1);
+    front = queue.front_span();
+    ASSERT_EQ(front.size(), 2);
+    EXPECT_EQ(front[1], 3);
+    EXPECT_THROW(queue.commit_read(3), std::invalid_argument);
+    queue.commit_read(2);
+    EXPECT_TRUE(queue.empty());
+}
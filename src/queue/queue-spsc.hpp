@@ -0,0 +1,212 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "queue.hpp"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer
+// thread. It is the ring of ArrQueue with:
+//  - a power of two capacity, so indices wrap with a mask instead of %,
+//  - free running read/write indices published with acquire/release,
+//  - every index on its own cache line, next to the cached copy of the
+//    opposite index, so a side only touches the other side's line when its
+//    cached view says the queue is full (or empty).
+template <typename T>
+class SPSCQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Producer side: written by the producer, read by the consumer.
+    alignas(CACHE_LINE) std::atomic<size_t> m_write;
+    size_t m_read_cache;
+
+    // Consumer side: written by the consumer, read by the producer.
+    alignas(CACHE_LINE) std::atomic<size_t> m_read;
+    size_t m_write_cache;
+
+    // Read only after construction.
+    alignas(CACHE_LINE) T* m_queue;
+    size_t m_mask;
+
+public:
+    SPSCQueue(size_t capacity)
+        : m_write(0)
+        , m_read_cache(0)
+        , m_read(0)
+        , m_write_cache(0)
+        , m_mask(std::bit_ceil(capacity < 2 ? 2 : capacity) - 1)
+    {
+        m_queue = new T[m_mask + 1];
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    ~SPSCQueue()
+    {
+        delete[] m_queue;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    // The element count is a snapshot while the other side is running.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        size_t read = m_read.load(std::memory_order_acquire);
+        usage.m_elements = std::min<uint64_t>(m_write.load(std::memory_order_acquire) - read, capacity());
+        usage.m_payload = usage.m_elements * sizeof(T);
+        usage.m_overhead = sizeof(*this);
+        usage.m_slack = (capacity() - usage.m_elements) * sizeof(T);
+        usage.allocations(capacity() * sizeof(T));
+        return usage;
+    }
+
+    // Producer only.
+    bool try_enqueue(const T& value)
+    {
+        const size_t write = m_write.load(std::memory_order_relaxed);
+        if (write - m_read_cache > m_mask) {
+            m_read_cache = m_read.load(std::memory_order_acquire);
+            if (write - m_read_cache > m_mask)
+                return false;
+        }
+        m_queue[write & m_mask] = value;
+        m_write.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Enqueues as many of the count values as fit and returns
+    // how many were enqueued, publishing them all with a single store.
+    size_t try_enqueue_bulk(const T* values, size_t count)
+    {
+        const size_t write = m_write.load(std::memory_order_relaxed);
+        size_t free = capacity() - (write - m_read_cache);
+        if (free < count) {
+            m_read_cache = m_read.load(std::memory_order_acquire);
+            free = capacity() - (write - m_read_cache);
+        }
+        if (count > free)
+            count = free;
+        if (count == 0)
+            return 0;
+
+        const size_t start = write & m_mask;
+        const size_t first = count < capacity() - start ? count : capacity() - start;
+        detail::copy_elements(values, first, m_queue + start);
+        detail::copy_elements(values + first, count - first, m_queue);
+        m_write.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t try_enqueue_bulk(std::span<const T> values)
+    {
+        return try_enqueue_bulk(values.data(), values.size());
+    }
+
+    // Consumer only.
+    bool try_dequeue(T& value)
+    {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        if (read == m_write_cache) {
+            m_write_cache = m_write.load(std::memory_order_acquire);
+            if (read == m_write_cache)
+                return false;
+        }
+        value = std::move(m_queue[read & m_mask]);
+        m_read.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Dequeues up to count values into values and returns how
+    // many were dequeued.
+    size_t try_dequeue_bulk(T* values, size_t count)
+    {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        size_t available = m_write_cache - read;
+        if (available < count) {
+            m_write_cache = m_write.load(std::memory_order_acquire);
+            available = m_write_cache - read;
+        }
+        if (count > available)
+            count = available;
+        if (count == 0)
+            return 0;
+
+        const size_t start = read & m_mask;
+        const size_t first = count < capacity() - start ? count : capacity() - start;
+        detail::move_elements(m_queue + start, first, values);
+        detail::move_elements(m_queue, count - first, values + first);
+        m_read.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t try_dequeue_bulk(std::span<T> values)
+    {
+        return try_dequeue_bulk(values.data(), values.size());
+    }
+
+    // Consumer only. The published elements that are contiguous in the
+    // buffer, left in place until commit_read() hands their slots back to
+    // the producer.
+    std::span<T> front_span()
+    {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        if (read == m_write_cache)
+            m_write_cache = m_write.load(std::memory_order_acquire);
+        const size_t start = read & m_mask;
+        const size_t available = m_write_cache - read;
+        return { m_queue + start, available < capacity() - start ? available : capacity() - start };
+    }
+
+    // Consumer only.
+    T& peek()
+    {
+        std::span<T> front = front_span();
+        if (front.empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return front[0];
+    }
+
+    // Consumer only. Dequeues count elements without copying them out.
+    void commit_read(size_t count)
+    {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        if (count > m_write_cache - read) {
+            throw std::invalid_argument("cannot commit more than is queued");
+        }
+        m_read.store(read + count, std::memory_order_release);
+    }
+
+    // Producer only.
+    void enqueue(T value)
+    {
+        if (!try_enqueue(value)) {
+            throw std::runtime_error("Queue buffer would be full");
+        }
+    }
+
+    // Consumer only.
+    T dequeue()
+    {
+        T value;
+        if (!try_dequeue(value)) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return value;
+    }
+
+    // Exact when called from the consumer, a snapshot otherwise.
+    bool empty()
+    {
+        return m_read.load(std::memory_order_relaxed) == m_write.load(std::memory_order_acquire);
+    }
+};
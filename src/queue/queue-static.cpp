@@ -0,0 +1,118 @@
+#include "queue-static.hpp"
+#include "queue.hpp"
+#include <gtest/gtest.h>
+#include <type_traits>
+
+static_assert(Queue<StaticRing<int, 8>, int>);
+static_assert(std::is_trivially_copyable_v<StaticRing<int, 8>>);
+
+// Runs through the buffer a few times so every position wraps.
+template <size_t N>
+static constexpr int wrapped_sum()
+{
+    StaticRing<int, N> queue;
+    int sum = 0;
+    for (int i = 0; i < 20; i++) {
+        queue.enqueue(i);
+        if (queue.full())
+            sum += queue.dequeue();
+    }
+    while (!queue.empty())
+        sum += queue.dequeue();
+    return sum;
+}
+
+static_assert(wrapped_sum<4>() == 190);
+static_assert(wrapped_sum<5>() == 190);
+
+static constexpr size_t bulk_round_trip()
+{
+    StaticRing<int, 6> queue;
+    const int in[] = { 0, 1, 2, 3, 4 };
+    int out[6] = {};
+    queue.enqueue_bulk(std::span(in, 4));
+    queue.dequeue_bulk(std::span(out, 3));
+    queue.enqueue_bulk(in);
+    return queue.dequeue_bulk(out) + out[1];
+}
+
+static_assert(bulk_round_trip() == 6);
+
+TEST(StaticRing, EnqueueDequeue)
+{
+    StaticRing<int, 3> queue;
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(1);
+    queue.enqueue(2);
+    queue.enqueue(3);
+    EXPECT_TRUE(queue.full());
+    EXPECT_THROW(queue.enqueue(4), std::runtime_error);
+
+    EXPECT_EQ(queue.dequeue(), 1);
+    queue.enqueue(4);
+    for (int i = 2; i <= 4; i++)
+        EXPECT_EQ(queue.dequeue(), i);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(StaticRing, AnyQueue)
+{
+    StaticRing<int, 4> ring;
+    AnyQueue<int> queue(ring);
+
+    queue.enqueue(4);
+    queue.enqueue(5);
+    EXPECT_EQ(queue.dequeue(), 4);
+    EXPECT_EQ(ring.dequeue(), 5);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(StaticRing, Bulk)
+{
+    StaticRing<int, 8> queue;
+    const int in[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+    int out[8];
+
+    queue.enqueue_bulk(std::span(in, 5));
+    EXPECT_EQ(queue.dequeue_bulk(std::span(out, 4)), 4);
+
+    // Wraps around the end of the buffer, and all eight slots can be used.
+    EXPECT_THROW(queue.enqueue_bulk(in), std::runtime_error);
+    queue.enqueue_bulk(std::span(in, 7));
+    EXPECT_TRUE(queue.full());
+
+    EXPECT_EQ(queue.dequeue_bulk(out), 8);
+    EXPECT_EQ(out[0], 4);
+    for (int i = 1; i < 8; i++)
+        EXPECT_EQ(out[i], i - 1);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(StaticRing, Peek)
+{
+    StaticRing<int, 4> queue;
+    const int in[] = { 1, 2, 3 };
+
+    EXPECT_THROW(queue.peek(), std::runtime_error);
+    queue.enqueue_bulk(in);
+    queue.commit_read(2);
+    EXPECT_EQ(queue.peek(), 3);
+
+    queue.enqueue_bulk(std::span(in, 2));
+    std::span<int> front = queue.front_span();
+    ASSERT_EQ(front.size(), 2);
+    EXPECT_EQ(front[1], 1);
+    EXPECT_THROW(queue.commit_read(4), std::invalid_argument);
+}
+
+TEST(StaticRing, MemoryUsage)
+{
+    StaticRing<int64_t, 8> queue;
+    queue.enqueue(1);
+
+    MemoryUsage usage = queue.memory_usage();
+    EXPECT_EQ(usage.m_payload, 8);
+    EXPECT_EQ(usage.m_slack, 56);
+    EXPECT_EQ(usage.total(), sizeof(queue));
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "queue.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+// ArrQueue with its capacity fixed at compile time and the buffer stored
+// inline: no heap, so it can live on the stack or in a shared memory
+// segment, and every operation is constexpr. Unlike ArrQueue it keeps a
+// count instead of a free slot, so all N slots can be used.
+//
+// Positions are always below 2 * N before wrapping. A power of two N wraps
+// with a mask, any other N with one compare instead of a division.
+template <typename T, size_t N>
+class StaticRing {
+    static_assert(N > 0, "a static ring needs at least one slot");
+
+private:
+    size_t m_read = 0;
+    size_t m_size = 0;
+    T m_queue[N] {};
+
+    static constexpr size_t wrap(size_t position)
+    {
+        if constexpr (std::has_single_bit(N))
+            return position & (N - 1);
+        else
+            return position >= N ? position - N : position;
+    }
+
+public:
+    constexpr StaticRing() = default;
+
+    constexpr void enqueue(T value)
+    {
+        if (full()) {
+            throw std::runtime_error("Queue buffer would be full");
+        }
+        m_queue[wrap(m_read + m_size)] = value;
+        m_size++;
+    }
+
+    constexpr T dequeue()
+    {
+        T value = m_queue[m_read];
+        m_read = wrap(m_read + 1);
+        m_size--;
+        return value;
+    }
+
+    constexpr bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    constexpr bool full() const
+    {
+        return m_size == N;
+    }
+
+    constexpr size_t size() const
+    {
+        return m_size;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    // Enqueues all the values or, if they do not fit, none of them.
+    constexpr void enqueue_bulk(std::span<const T> values)
+    {
+        if (values.size() > N - m_size) {
+            throw std::runtime_error("Queue buffer would be full");
+        }
+        size_t write = wrap(m_read + m_size);
+        size_t first = std::min(values.size(), N - write);
+        detail::copy_elements(values.data(), first, m_queue + write);
+        detail::copy_elements(values.data() + first, values.size() - first, m_queue);
+        m_size += values.size();
+    }
+
+    // Dequeues up to values.size() elements and returns how many it did.
+    constexpr size_t dequeue_bulk(std::span<T> values)
+    {
+        size_t count = std::min(values.size(), m_size);
+        size_t first = std::min(count, N - m_read);
+        detail::move_elements(m_queue + m_read, first, values.data());
+        detail::move_elements(m_queue, count - first, values.data() + first);
+        m_read = wrap(m_read + count);
+        m_size -= count;
+        return count;
+    }
+
+    constexpr T& peek()
+    {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return m_queue[m_read];
+    }
+
+    // The queued elements that are contiguous in the buffer from the next
+    // one to be dequeued, see ArrQueue::front_span().
+    constexpr std::span<T> front_span()
+    {
+        return { m_queue + m_read, std::min(m_size, N - m_read) };
+    }
+
+    constexpr void commit_read(size_t count)
+    {
+        if (count > m_size) {
+            throw std::invalid_argument("cannot commit more than is queued");
+        }
+        m_read = wrap(m_read + count);
+        m_size -= count;
+    }
+
+    // No heap blocks, the unused slots count as slack.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        usage.m_elements = m_size;
+        usage.m_payload = m_size * sizeof(T);
+        usage.m_slack = (N - m_size) * sizeof(T);
+        usage.m_overhead = sizeof(*this) - N * sizeof(T);
+        return usage;
+    }
+};
@@ -0,0 +1,76 @@
+#include "queue-work-stealing.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(Queue, WorkStealing)
+{
+    WorkStealingDeque<int> deque(2);
+    int value;
+
+    EXPECT_TRUE(deque.empty());
+    EXPECT_FALSE(deque.pop(value));
+    EXPECT_FALSE(deque.steal(value));
+
+    // Grows past the initial capacity.
+    for (int i = 0; i < 10; i++) {
+        deque.push(i);
+    }
+    EXPECT_EQ(deque.size(), 10);
+
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 9);
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, 0);
+    for (int i = 8; i > 0; i--) {
+        EXPECT_TRUE(deque.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(Queue, WorkStealingThreads)
+{
+    constexpr int COUNT = 100000;
+    constexpr int THIEVES = 3;
+    WorkStealingDeque<int> deque(16);
+    std::atomic<bool> done(false);
+    std::vector<std::vector<int>> taken(THIEVES + 1);
+    std::vector<std::thread> thieves;
+
+    for (int t = 0; t < THIEVES; t++) {
+        thieves.emplace_back([&, t]() {
+            int value;
+            while (!done.load(std::memory_order_acquire) || !deque.empty()) {
+                if (deque.steal(value))
+                    taken[t].push_back(value);
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    int value;
+    for (int i = 0; i < COUNT; i++) {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(value))
+            taken[THIEVES].push_back(value);
+    }
+    while (deque.pop(value)) {
+        taken[THIEVES].push_back(value);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    std::vector<int> seen(COUNT, 0);
+    for (auto& values : taken) {
+        for (int v : values) {
+            seen[v]++;
+        }
+    }
+    for (int i = 0; i < COUNT; i++) {
+        ASSERT_EQ(seen[i], 1) << "element " << i;
+    }
+}
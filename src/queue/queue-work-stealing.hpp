@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev work-stealing deque, with the memory orderings of Le et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (2013).
+//
+// The owner thread pushes and pops at the bottom like a stack; any other
+// thread may steal from the top. The elements live in a power of two ring
+// like the one of ArrQueue, which the owner replaces with one twice as big
+// when it fills up. Thieves may still be reading a replaced ring, so those
+// are only freed with the deque.
+//
+// T is copied with plain atomic loads and stores, so it has to be trivially
+// copyable; a deque of task pointers is the intended use.
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque elements must be trivially copyable");
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Ring {
+        int64_t m_mask;
+        std::atomic<T>* m_slots;
+
+        Ring(int64_t capacity)
+            : m_mask(capacity - 1)
+            , m_slots(new std::atomic<T>[capacity])
+        {
+        }
+
+        ~Ring()
+        {
+            delete[] m_slots;
+        }
+
+        int64_t capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        T get(int64_t index) const
+        {
+            return m_slots[index & m_mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T value)
+        {
+            m_slots[index & m_mask].store(value, std::memory_order_relaxed);
+        }
+
+        Ring* grow(int64_t top, int64_t bottom) const
+        {
+            Ring* ring = new Ring(capacity() * 2);
+            for (int64_t i = top; i < bottom; i++) {
+                ring->put(i, get(i));
+            }
+            return ring;
+        }
+    };
+
+    alignas(CACHE_LINE) std::atomic<int64_t> m_top;
+    alignas(CACHE_LINE) std::atomic<int64_t> m_bottom;
+    std::atomic<Ring*> m_ring;
+    std::vector<Ring*> m_retired;
+
+public:
+    WorkStealingDeque(size_t capacity = 64)
+        : m_top(0)
+        , m_bottom(0)
+        , m_ring(new Ring(std::bit_ceil(capacity < 2 ? 2 : capacity)))
+    {
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    ~WorkStealingDeque()
+    {
+        delete m_ring.load(std::memory_order_relaxed);
+        for (Ring* ring : m_retired) {
+            delete ring;
+        }
+    }
+
+    // Owner only.
+    void push(T value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        if (bottom - top > ring->m_mask) {
+            m_retired.push_back(ring);
+            ring = ring->grow(top, bottom);
+            m_ring.store(ring, std::memory_order_release);
+        }
+        ring->put(bottom, value);
+        // A release store rather than the paper's release fence followed by
+        // a relaxed store: same code on x86, and visible to TSan.
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Owner only. Takes the most recently pushed element.
+    bool pop(T& value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        // Seq_cst store and load in place of the paper's fence between
+        // them, which TSan does not model. On x86 the store is the xchg
+        // standing in for the mfence.
+        m_bottom.store(bottom, std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_seq_cst);
+
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        value = ring->get(bottom);
+        if (top == bottom) {
+            // Last element: race the thieves for it.
+            bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread. Takes the oldest element; fails if the deque is empty or
+    // another thread got that element first.
+    bool steal(T& value)
+    {
+        // Seq_cst loads order against pop's store to m_bottom without a
+        // fence, as in pop.
+        int64_t top = m_top.load(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom)
+            return false;
+
+        Ring* ring = m_ring.load(std::memory_order_acquire);
+        value = ring->get(top);
+        return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // Only a snapshot while other threads are using the deque.
+    bool empty()
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        return top >= bottom;
+    }
+
+    size_t size()
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? bottom - top : 0;
+    }
+};
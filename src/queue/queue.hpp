@@ -1,8 +1,102 @@
 #pragma once
 
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Anything that can be used as a queue of T. Code written against this
+// concept calls the queue's own members directly, so every operation can be
+// inlined and nothing goes through a vtable.
+template <typename Q, typename T>
+concept Queue = requires(Q& queue, T value) {
+    queue.enqueue(value);
+    { queue.dequeue() } -> std::convertible_to<T>;
+    { queue.empty() } -> std::convertible_to<bool>;
+};
+
+// Type erased view over any Queue of T, for the callers that need to pick
+// the queue at run time. It does not own the queue it refers to, and every
+// call goes through a virtual function.
 template <typename T>
-class Queue {
-    virtual void enqueue(T value) = 0;
-    virtual T dequeue() = 0;
-    virtual bool empty() = 0;
+class AnyQueue {
+private:
+    struct Concept {
+        virtual ~Concept() = default;
+        virtual void enqueue(T value) = 0;
+        virtual T dequeue() = 0;
+        virtual bool empty() = 0;
+    };
+
+    template <typename Q>
+    struct Model final : Concept {
+        Q& m_queue;
+
+        Model(Q& queue)
+            : m_queue(queue) {};
+
+        void enqueue(T value) override { m_queue.enqueue(value); }
+        T dequeue() override { return m_queue.dequeue(); }
+        bool empty() override { return m_queue.empty(); }
+    };
+
+    std::unique_ptr<Concept> m_queue;
+
+public:
+    // An AnyQueue is itself a Queue, keep copies of one from wrapping it.
+    template <typename Q>
+        requires Queue<Q, T> && (!std::same_as<std::remove_cvref_t<Q>, AnyQueue>)
+    AnyQueue(Q& queue)
+        : m_queue(std::make_unique<Model<Q>>(queue))
+    {
+    }
+
+    void enqueue(T value)
+    {
+        m_queue->enqueue(value);
+    }
+
+    T dequeue()
+    {
+        return m_queue->dequeue();
+    }
+
+    bool empty()
+    {
+        return m_queue->empty();
+    }
 };
+
+namespace detail {
+
+// Element copies used by the bulk operations of the queues. Trivially
+// copyable runs go through a single memcpy, except in constant evaluation.
+template <typename T>
+constexpr void copy_elements(const T* src, size_t count, T* dst)
+{
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (!std::is_constant_evaluated()) {
+            if (count > 0)
+                std::memcpy(dst, src, count * sizeof(T));
+            return;
+        }
+    }
+    std::copy_n(src, count, dst);
+}
+
+template <typename T>
+constexpr void move_elements(T* src, size_t count, T* dst)
+{
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (!std::is_constant_evaluated()) {
+            if (count > 0)
+                std::memcpy(dst, src, count * sizeof(T));
+            return;
+        }
+    }
+    std::move(src, src + count, dst);
+}
+
+}
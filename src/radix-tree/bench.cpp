@@ -0,0 +1,132 @@
+#include "../avl-tree/avl-tree.hpp"
+#include "radix-tree.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+// RadixTree against AVLTree on int and uint64_t keys. Sizes go up to 16M
+// keys, where an AVLTree takes about 2GB; raise MAX_KEYS for runs at 100M
+// keys and more on a machine with the memory for it.
+static constexpr int64_t MAX_KEYS = 1 << 24;
+
+// Distinct keys in random order: ints spread over the whole int range,
+// 64 bit keys uniform.
+template <typename Key>
+static std::vector<Key> keys(int64_t count, unsigned seed = 42)
+{
+    std::mt19937_64 random(seed);
+    std::vector<Key> keys(count);
+    for (int64_t i = 0; i < count; i++) {
+        if constexpr (sizeof(Key) == 8)
+            keys[i] = Key((random() & ~uint64_t(0xffffffff)) | uint64_t(i));
+        else
+            keys[i] = Key(uint32_t(i) * 2654435761u);
+    }
+    std::shuffle(keys.begin(), keys.end(), random);
+    return keys;
+}
+
+// The set of the last size asked for, built once for every run at that size.
+template <typename Set, typename Key>
+static Set& filled(int64_t count)
+{
+    static std::unique_ptr<Set> set;
+    static int64_t size = -1;
+    if (size != count) {
+        set.reset();
+        set = std::make_unique<Set>();
+        for (Key key : keys<Key>(count))
+            set->insert(key);
+        size = count;
+    }
+    return *set;
+}
+
+// Inserts state.range(0) keys into an empty set.
+template <typename Set, typename Key>
+static void BM_Insert(benchmark::State& state)
+{
+    std::vector<Key> values = keys<Key>(state.range(0));
+    for (auto _ : state) {
+        Set set;
+        for (Key value : values)
+            set.insert(value);
+        benchmark::DoNotOptimize(set);
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_Insert<RadixTree<int>, int>)->Range(1 << 12, MAX_KEYS)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Insert<AVLTree<int>, int>)->Range(1 << 12, MAX_KEYS)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Insert<RadixTree<uint64_t>, uint64_t>)->Range(1 << 12, MAX_KEYS)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Insert<AVLTree<uint64_t>, uint64_t>)->Range(1 << 12, MAX_KEYS)->Unit(benchmark::kMillisecond);
+
+// Looks up 1M random keys that are all in the set, and reports its
+// memoryUsage() per key.
+template <typename Set, typename Key>
+static void BM_LookupHit(benchmark::State& state)
+{
+    Set& set = filled<Set, Key>(state.range(0));
+    std::vector<Key> values = keys<Key>(state.range(0));
+    values.resize(std::min<size_t>(values.size(), 1 << 20));
+    std::shuffle(values.begin(), values.end(), std::mt19937(7));
+    for (auto _ : state) {
+        for (Key value : values)
+            benchmark::DoNotOptimize(set.contains(value));
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+    state.counters["bytes_per_key"] = set.memoryUsage().bytes_per_element();
+}
+BENCHMARK(BM_LookupHit<RadixTree<int>, int>)->Range(1 << 12, MAX_KEYS);
+BENCHMARK(BM_LookupHit<AVLTree<int>, int>)->Range(1 << 12, MAX_KEYS);
+BENCHMARK(BM_LookupHit<RadixTree<uint64_t>, uint64_t>)->Range(1 << 12, MAX_KEYS);
+BENCHMARK(BM_LookupHit<AVLTree<uint64_t>, uint64_t>)->Range(1 << 12, MAX_KEYS);
+
+// 64 bit keys from another seed, nearly all absent.
+template <typename Set, typename Key>
+static void BM_LookupMiss(benchmark::State& state)
+{
+    Set& set = filled<Set, Key>(state.range(0));
+    std::vector<Key> values = keys<Key>(std::min<int64_t>(state.range(0), 1 << 20), 1);
+    for (auto _ : state) {
+        for (Key value : values)
+            benchmark::DoNotOptimize(set.contains(value));
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_LookupMiss<RadixTree<uint64_t>, uint64_t>)->Range(1 << 12, MAX_KEYS);
+BENCHMARK(BM_LookupMiss<AVLTree<uint64_t>, uint64_t>)->Range(1 << 12, MAX_KEYS);
+
+// Sum over 1000 consecutive keys from a random start, the ordered query
+// AVLTree has no API for, against std::set.
+template <typename Set>
+static void scan(Set& set, uint64_t low, uint64_t high, uint64_t& sum)
+{
+    if constexpr (requires { set.forRange(low, high, [](uint64_t) {}); }) {
+        set.forRange(low, high, [&](uint64_t key) { sum += key; });
+    } else {
+        for (auto it = set.lower_bound(low); it != set.end() && *it < high; ++it)
+            sum += *it;
+    }
+}
+
+template <typename Set>
+static void BM_Range(benchmark::State& state)
+{
+    Set& set = filled<Set, uint64_t>(state.range(0));
+    std::mt19937_64 random(3);
+    // Keys are uniform in their upper half, 1000 of them span about
+    // 1000 / size of the key space.
+    uint64_t width = ~uint64_t(0) / state.range(0) * 1000;
+    for (auto _ : state) {
+        uint64_t low = random() % (~uint64_t(0) - width);
+        uint64_t sum = 0;
+        scan(set, low, low + width, sum);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Range<RadixTree<uint64_t>>)->Range(1 << 12, MAX_KEYS);
+BENCHMARK(BM_Range<std::set<uint64_t>>)->Range(1 << 12, MAX_KEYS);
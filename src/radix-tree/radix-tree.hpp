@@ -0,0 +1,1077 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RADIX_TREE_SSE2 1
+#endif
+
+// Ordered set of integer or string keys as an adaptive radix tree (Leis et
+// al., "The Adaptive Radix Tree: ARTful Indexing for Main-Memory
+// Databases"). Keys are split into bytes, integers big endian with the sign
+// bit flipped, so byte order is key order. Every inner node branches on one
+// byte and is sized to its children: Node4 and Node16 keep sorted byte
+// arrays (Node16 searched with one SSE2 compare), Node48 maps all 256 bytes
+// to 48 slots, Node256 is a plain array of children.
+//
+// Single child paths are compressed into a node prefix of up to MAX_PREFIX
+// bytes; longer shared prefixes, which only string keys can have, chain
+// single child nodes. Leaves sit as high as the keys under them allow.
+// Integer leaves are the key itself stored in the child slot, tagged in
+// bit 0, so integer trees allocate only inner nodes. The first byte of a 64
+// bit key does not fit, but it is always the root's branch byte: the root is
+// never a leaf and never has a prefix. String leaves are allocated with
+// their bytes, and a string that ends where an inner node starts hangs off
+// that node's m_end.
+//
+// Lookups skip the prefixes and compare the whole key at the leaf.
+template <typename Key>
+class RadixTree {
+    static constexpr bool INTEGER = std::is_integral_v<Key> && !std::is_same_v<Key, bool>;
+    static_assert((INTEGER && sizeof(Key) <= 8) || std::is_same_v<Key, std::string>,
+        "radix tree keys are integers of up to 64 bits or std::string");
+
+public:
+    // Keys are passed as integers or as views of the string's bytes.
+    using KeyArg = std::conditional_t<INTEGER, Key, std::string_view>;
+
+    static constexpr size_t MAX_PREFIX = 12;
+
+    RadixTree() = default;
+    RadixTree(const RadixTree&) = delete;
+    RadixTree& operator=(const RadixTree&) = delete;
+
+    ~RadixTree()
+    {
+        makeEmpty();
+    }
+
+    // Returns whether key was not in the tree yet.
+    bool insert(KeyArg key);
+    // Returns whether key was in the tree.
+    bool remove(KeyArg key);
+    bool contains(KeyArg key) const;
+
+    Key findMin() const;
+    Key findMax() const;
+
+    // Calls fn(key) for every key in [low, high), in order. String keys are
+    // passed as views that are only valid during the call.
+    template <typename Fn>
+    void forRange(KeyArg low, KeyArg high, Fn&& fn) const;
+
+    size_t size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    void makeEmpty();
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp.
+    ContainerStats stats() const { return m_stats.stats(); }
+    void resetStats() { m_stats.reset(); }
+
+    // Integer keys are payload inside the child slots, the rest of the
+    // nodes is overhead.
+    MemoryUsage memoryUsage() const;
+
+private:
+    // A child: 0 when empty, a Node*, or a leaf tagged with LEAF.
+    using Slot = uintptr_t;
+    static constexpr Slot LEAF = 1;
+
+    enum class Type : uint8_t {
+        Node4,
+        Node16,
+        Node48,
+        Node256,
+    };
+
+    // Integer trees have no m_end, it reads as an empty slot.
+    struct NoEnd {
+        operator Slot() const { return 0; }
+    };
+
+    struct Node {
+        Type m_type;
+        uint8_t m_prefixLength = 0;
+        uint16_t m_count = 0;
+        uint8_t m_prefix[MAX_PREFIX];
+        // The leaf of the string that ends right before this node's
+        // children, which all have longer keys.
+        [[no_unique_address]] std::conditional_t<INTEGER, NoEnd, Slot> m_end {};
+
+        Node(Type type)
+            : m_type(type)
+        {
+        }
+    };
+
+    struct Node4 : Node {
+        uint8_t m_keys[4] {};
+        Slot m_children[4] {};
+
+        Node4()
+            : Node(Type::Node4)
+        {
+        }
+    };
+
+    struct Node16 : Node {
+        uint8_t m_keys[16] {};
+        Slot m_children[16] {};
+
+        Node16()
+            : Node(Type::Node16)
+        {
+        }
+    };
+
+    // m_index holds the child's slot plus one, 0 for no child.
+    struct Node48 : Node {
+        uint8_t m_index[256] {};
+        Slot m_children[48] {};
+
+        Node48()
+            : Node(Type::Node48)
+        {
+        }
+    };
+
+    struct Node256 : Node {
+        Slot m_children[256] {};
+
+        Node256()
+            : Node(Type::Node256)
+        {
+        }
+    };
+
+    // A string leaf, its m_length bytes are allocated right after it.
+    struct Leaf {
+        uint32_t m_length;
+
+        uint8_t* bytes() { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
+
+    // The bytes of a key, computed from m_encoded for integers.
+    struct KeyBytes {
+        uint64_t m_encoded = 0;
+        std::string_view m_string;
+
+        size_t length() const
+        {
+            if constexpr (INTEGER)
+                return sizeof(Key);
+            else
+                return m_string.size();
+        }
+
+        uint8_t operator[](size_t index) const
+        {
+            if constexpr (INTEGER)
+                return uint8_t(m_encoded >> (8 * (sizeof(Key) - 1 - index)));
+            else
+                return uint8_t(m_string[index]);
+        }
+    };
+
+    // Integer leaves keep everything but the first byte of a 64 bit key.
+    static constexpr uint64_t LEAF_MASK = sizeof(Key) < 8 ? ~uint64_t(0) : (uint64_t(1) << 56) - 1;
+
+    Slot m_root = 0;
+    size_t m_size = 0;
+    [[no_unique_address]] mutable StatsRecorder m_stats;
+
+    static uint64_t encode(Key key)
+    {
+        uint64_t bits = std::make_unsigned_t<Key>(key);
+        if constexpr (std::is_signed_v<Key>)
+            bits ^= uint64_t(1) << (8 * sizeof(Key) - 1);
+        return bits;
+    }
+
+    static Key decode(uint64_t bits)
+    {
+        if constexpr (std::is_signed_v<Key>)
+            bits ^= uint64_t(1) << (8 * sizeof(Key) - 1);
+        return Key(std::make_unsigned_t<Key>(bits));
+    }
+
+    static KeyBytes bytesOf(KeyArg key)
+    {
+        KeyBytes bytes;
+        if constexpr (INTEGER)
+            bytes.m_encoded = encode(key);
+        else
+            bytes.m_string = key;
+        return bytes;
+    }
+
+    static bool isLeaf(Slot slot) { return (slot & LEAF) != 0; }
+    static Node* nodeOf(Slot slot) { return reinterpret_cast<Node*>(slot); }
+    static Leaf* leafOf(Slot slot) { return reinterpret_cast<Leaf*>(slot & ~LEAF); }
+
+    // The key of a leaf below the root, whose first byte is first.
+    static KeyBytes leafBytes(Slot leaf, uint8_t first)
+    {
+        KeyBytes bytes;
+        if constexpr (INTEGER) {
+            bytes.m_encoded = leaf >> 8;
+            if constexpr (sizeof(Key) == 8)
+                bytes.m_encoded |= uint64_t(first) << 56;
+        } else {
+            bytes.m_string = std::string_view(reinterpret_cast<const char*>(leafOf(leaf)->bytes()), leafOf(leaf)->m_length);
+        }
+        return bytes;
+    }
+
+    static KeyArg argOf(const KeyBytes& bytes)
+    {
+        if constexpr (INTEGER)
+            return decode(bytes.m_encoded);
+        else
+            return bytes.m_string;
+    }
+
+    // Orders the bytes of two keys.
+    static int compare(const KeyBytes& left, const KeyBytes& right)
+    {
+        if constexpr (INTEGER)
+            return left.m_encoded < right.m_encoded ? -1 : left.m_encoded != right.m_encoded;
+        else
+            return left.m_string.compare(right.m_string);
+    }
+
+    // The first byte of a leaf's key is matched on the way down.
+    bool leafMatches(Slot leaf, const KeyBytes& key) const
+    {
+        m_stats.comparison();
+        if constexpr (INTEGER) {
+            return (leaf >> 8) == (key.m_encoded & LEAF_MASK);
+        } else {
+            Leaf* data = leafOf(leaf);
+            return data->m_length == key.length() && std::memcmp(data->bytes(), key.m_string.data(), data->m_length) == 0;
+        }
+    }
+
+    Slot makeLeaf(const KeyBytes& key)
+    {
+        if constexpr (INTEGER) {
+            return ((key.m_encoded & LEAF_MASK) << 8) | LEAF;
+        } else {
+            m_stats.allocation();
+            void* memory = ::operator new(sizeof(Leaf) + key.length());
+            Leaf* leaf = ::new (memory) Leaf { uint32_t(key.length()) };
+            std::memcpy(leaf->bytes(), key.m_string.data(), key.length());
+            return reinterpret_cast<Slot>(leaf) | LEAF;
+        }
+    }
+
+    void freeLeaf(Slot leaf)
+    {
+        if constexpr (!INTEGER) {
+            m_stats.deallocation();
+            ::operator delete(leafOf(leaf));
+        }
+    }
+
+    static bool hasEnd(const Node* node)
+    {
+        if constexpr (INTEGER)
+            return false;
+        else
+            return node->m_end != 0;
+    }
+
+    static size_t nodeSize(Type type)
+    {
+        switch (type) {
+        case Type::Node4:
+            return sizeof(Node4);
+        case Type::Node16:
+            return sizeof(Node16);
+        case Type::Node48:
+            return sizeof(Node48);
+        case Type::Node256:
+            return sizeof(Node256);
+        }
+        return 0;
+    }
+
+    template <typename N>
+    N* makeNode()
+    {
+        m_stats.allocation();
+        return new N;
+    }
+
+    void freeNode(Node* node);
+    void destroy(Slot slot);
+
+    // Number of prefix bytes of node that match key from depth on.
+    static size_t prefixMatch(const Node* node, const KeyBytes& key, size_t depth)
+    {
+        size_t length = 0;
+        while (length < node->m_prefixLength && depth + length < key.length()
+            && node->m_prefix[length] == key[depth + length])
+            length++;
+        return length;
+    }
+
+    static Slot* findChild(Node* node, uint8_t byte);
+
+    // Calls fn(byte, child) for the children on bytes from `from` up, in
+    // order, until fn returns false. Returns whether it got to the end.
+    template <typename Fn>
+    static bool eachChild(Node* node, unsigned from, Fn&& fn);
+
+    static Slot lastChild(Node* node, uint8_t& byte);
+
+    void copyHeader(Node* to, const Node* from);
+    Node* grow(Node* node);
+    void shrink(Slot& ref, Node* node);
+    void addChild(Slot& ref, Node* node, uint8_t byte, Slot child);
+    void removeChild(Slot& ref, Node* node, uint8_t byte);
+
+    void placeLeaf(Slot& ref, Node* node, const KeyBytes& key, Slot leaf, size_t depth);
+    Slot splitLeaf(Slot leaf, const KeyBytes& key, size_t depth);
+    Slot splitPrefix(Node* node, size_t matched, const KeyBytes& key, size_t depth);
+
+    bool remove(Slot& ref, const KeyBytes& key, size_t depth, bool root);
+    void collapse(Slot& ref, bool root);
+
+    template <typename Fn>
+    bool scan(Slot slot, size_t depth, uint8_t first, const KeyBytes& low, const KeyBytes& high,
+        bool lowTight, bool highTight, Fn& fn) const;
+
+    void account(Slot slot, MemoryUsage& usage) const;
+};
+
+template <typename Key>
+void RadixTree<Key>::freeNode(Node* node)
+{
+    m_stats.deallocation();
+    switch (node->m_type) {
+    case Type::Node4:
+        delete static_cast<Node4*>(node);
+        break;
+    case Type::Node16:
+        delete static_cast<Node16*>(node);
+        break;
+    case Type::Node48:
+        delete static_cast<Node48*>(node);
+        break;
+    case Type::Node256:
+        delete static_cast<Node256*>(node);
+        break;
+    }
+}
+
+template <typename Key>
+void RadixTree<Key>::destroy(Slot slot)
+{
+    if (isLeaf(slot)) {
+        freeLeaf(slot);
+        return;
+    }
+    Node* node = nodeOf(slot);
+    eachChild(node, 0, [&](uint8_t, Slot child) {
+        destroy(child);
+        return true;
+    });
+    if (hasEnd(node))
+        freeLeaf(node->m_end);
+    freeNode(node);
+}
+
+template <typename Key>
+auto RadixTree<Key>::findChild(Node* node, uint8_t byte) -> Slot*
+{
+    switch (node->m_type) {
+    case Type::Node4: {
+        Node4* node4 = static_cast<Node4*>(node);
+        for (int i = 0; i < node->m_count; i++) {
+            if (node4->m_keys[i] == byte)
+                return &node4->m_children[i];
+        }
+        return nullptr;
+    }
+    case Type::Node16: {
+        Node16* node16 = static_cast<Node16*>(node);
+#ifdef RADIX_TREE_SSE2
+        __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(node16->m_keys));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(char(byte)), keys));
+        mask &= (1u << node->m_count) - 1;
+        return mask != 0 ? &node16->m_children[__builtin_ctz(mask)] : nullptr;
+#else
+        for (int i = 0; i < node->m_count; i++) {
+            if (node16->m_keys[i] == byte)
+                return &node16->m_children[i];
+        }
+        return nullptr;
+#endif
+    }
+    case Type::Node48: {
+        Node48* node48 = static_cast<Node48*>(node);
+        uint8_t index = node48->m_index[byte];
+        return index != 0 ? &node48->m_children[index - 1] : nullptr;
+    }
+    case Type::Node256: {
+        Node256* node256 = static_cast<Node256*>(node);
+        return node256->m_children[byte] != 0 ? &node256->m_children[byte] : nullptr;
+    }
+    }
+    return nullptr;
+}
+
+template <typename Key>
+template <typename Fn>
+bool RadixTree<Key>::eachChild(Node* node, unsigned from, Fn&& fn)
+{
+    switch (node->m_type) {
+    case Type::Node4: {
+        Node4* node4 = static_cast<Node4*>(node);
+        for (int i = 0; i < node->m_count; i++) {
+            if (node4->m_keys[i] >= from && !fn(node4->m_keys[i], node4->m_children[i]))
+                return false;
+        }
+        break;
+    }
+    case Type::Node16: {
+        Node16* node16 = static_cast<Node16*>(node);
+        for (int i = 0; i < node->m_count; i++) {
+            if (node16->m_keys[i] >= from && !fn(node16->m_keys[i], node16->m_children[i]))
+                return false;
+        }
+        break;
+    }
+    case Type::Node48: {
+        Node48* node48 = static_cast<Node48*>(node);
+        for (unsigned byte = from; byte < 256; byte++) {
+            uint8_t index = node48->m_index[byte];
+            if (index != 0 && !fn(uint8_t(byte), node48->m_children[index - 1]))
+                return false;
+        }
+        break;
+    }
+    case Type::Node256: {
+        Node256* node256 = static_cast<Node256*>(node);
+        for (unsigned byte = from; byte < 256; byte++) {
+            if (node256->m_children[byte] != 0 && !fn(uint8_t(byte), node256->m_children[byte]))
+                return false;
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+template <typename Key>
+auto RadixTree<Key>::lastChild(Node* node, uint8_t& byte) -> Slot
+{
+    switch (node->m_type) {
+    case Type::Node4:
+        byte = static_cast<Node4*>(node)->m_keys[node->m_count - 1];
+        return static_cast<Node4*>(node)->m_children[node->m_count - 1];
+    case Type::Node16:
+        byte = static_cast<Node16*>(node)->m_keys[node->m_count - 1];
+        return static_cast<Node16*>(node)->m_children[node->m_count - 1];
+    case Type::Node48: {
+        Node48* node48 = static_cast<Node48*>(node);
+        byte = 255;
+        while (node48->m_index[byte] == 0)
+            byte--;
+        return node48->m_children[node48->m_index[byte] - 1];
+    }
+    case Type::Node256: {
+        Node256* node256 = static_cast<Node256*>(node);
+        byte = 255;
+        while (node256->m_children[byte] == 0)
+            byte--;
+        return node256->m_children[byte];
+    }
+    }
+    return 0;
+}
+
+template <typename Key>
+void RadixTree<Key>::copyHeader(Node* to, const Node* from)
+{
+    m_stats.resize();
+    to->m_prefixLength = from->m_prefixLength;
+    std::memcpy(to->m_prefix, from->m_prefix, from->m_prefixLength);
+    to->m_count = from->m_count;
+    to->m_end = from->m_end;
+}
+
+// Moves the children of a full node to one of the next size.
+template <typename Key>
+auto RadixTree<Key>::grow(Node* node) -> Node*
+{
+    Node* bigger = nullptr;
+    switch (node->m_type) {
+    case Type::Node4: {
+        Node4* from = static_cast<Node4*>(node);
+        Node16* to = makeNode<Node16>();
+        std::memcpy(to->m_keys, from->m_keys, sizeof(from->m_keys));
+        std::memcpy(to->m_children, from->m_children, sizeof(from->m_children));
+        bigger = to;
+        break;
+    }
+    case Type::Node16: {
+        Node16* from = static_cast<Node16*>(node);
+        Node48* to = makeNode<Node48>();
+        for (int i = 0; i < node->m_count; i++) {
+            to->m_index[from->m_keys[i]] = i + 1;
+            to->m_children[i] = from->m_children[i];
+        }
+        bigger = to;
+        break;
+    }
+    case Type::Node48: {
+        Node48* from = static_cast<Node48*>(node);
+        Node256* to = makeNode<Node256>();
+        for (int byte = 0; byte < 256; byte++) {
+            if (from->m_index[byte] != 0)
+                to->m_children[byte] = from->m_children[from->m_index[byte] - 1];
+        }
+        bigger = to;
+        break;
+    }
+    case Type::Node256:
+        return node;
+    }
+    copyHeader(bigger, node);
+    freeNode(node);
+    return bigger;
+}
+
+// Moves the children of a node that got sparse to one of the previous size.
+// The thresholds are below the next smaller capacity, so a node does not
+// flip between two sizes when a child comes and goes.
+template <typename Key>
+void RadixTree<Key>::shrink(Slot& ref, Node* node)
+{
+    Node* smaller = nullptr;
+    switch (node->m_type) {
+    case Type::Node4:
+        return;
+    case Type::Node16: {
+        if (node->m_count > 3)
+            return;
+        Node16* from = static_cast<Node16*>(node);
+        Node4* to = makeNode<Node4>();
+        std::memcpy(to->m_keys, from->m_keys, node->m_count);
+        std::memcpy(to->m_children, from->m_children, node->m_count * sizeof(Slot));
+        smaller = to;
+        break;
+    }
+    case Type::Node48: {
+        if (node->m_count > 12)
+            return;
+        Node48* from = static_cast<Node48*>(node);
+        Node16* to = makeNode<Node16>();
+        int count = 0;
+        for (int byte = 0; byte < 256; byte++) {
+            if (from->m_index[byte] != 0) {
+                to->m_keys[count] = byte;
+                to->m_children[count++] = from->m_children[from->m_index[byte] - 1];
+            }
+        }
+        smaller = to;
+        break;
+    }
+    case Type::Node256: {
+        if (node->m_count > 40)
+            return;
+        Node256* from = static_cast<Node256*>(node);
+        Node48* to = makeNode<Node48>();
+        int count = 0;
+        for (int byte = 0; byte < 256; byte++) {
+            if (from->m_children[byte] != 0) {
+                to->m_index[byte] = count + 1;
+                to->m_children[count++] = from->m_children[byte];
+            }
+        }
+        smaller = to;
+        break;
+    }
+    }
+    copyHeader(smaller, node);
+    freeNode(node);
+    ref = reinterpret_cast<Slot>(smaller);
+}
+
+// ref is the slot holding node, updated if it has to grow.
+template <typename Key>
+void RadixTree<Key>::addChild(Slot& ref, Node* node, uint8_t byte, Slot child)
+{
+    bool full = (node->m_type == Type::Node4 && node->m_count == 4)
+        || (node->m_type == Type::Node16 && node->m_count == 16)
+        || (node->m_type == Type::Node48 && node->m_count == 48);
+    if (full) {
+        node = grow(node);
+        ref = reinterpret_cast<Slot>(node);
+    }
+
+    switch (node->m_type) {
+    case Type::Node4:
+    case Type::Node16: {
+        uint8_t* keys;
+        Slot* children;
+        if (node->m_type == Type::Node4) {
+            keys = static_cast<Node4*>(node)->m_keys;
+            children = static_cast<Node4*>(node)->m_children;
+        } else {
+            keys = static_cast<Node16*>(node)->m_keys;
+            children = static_cast<Node16*>(node)->m_children;
+        }
+        int position = node->m_count;
+        while (position > 0 && keys[position - 1] > byte) {
+            keys[position] = keys[position - 1];
+            children[position] = children[position - 1];
+            position--;
+        }
+        keys[position] = byte;
+        children[position] = child;
+        break;
+    }
+    case Type::Node48: {
+        Node48* node48 = static_cast<Node48*>(node);
+        int free = 0;
+        while (node48->m_children[free] != 0)
+            free++;
+        node48->m_children[free] = child;
+        node48->m_index[byte] = free + 1;
+        break;
+    }
+    case Type::Node256:
+        static_cast<Node256*>(node)->m_children[byte] = child;
+        break;
+    }
+    node->m_count++;
+}
+
+template <typename Key>
+void RadixTree<Key>::removeChild(Slot& ref, Node* node, uint8_t byte)
+{
+    switch (node->m_type) {
+    case Type::Node4:
+    case Type::Node16: {
+        uint8_t* keys;
+        Slot* children;
+        if (node->m_type == Type::Node4) {
+            keys = static_cast<Node4*>(node)->m_keys;
+            children = static_cast<Node4*>(node)->m_children;
+        } else {
+            keys = static_cast<Node16*>(node)->m_keys;
+            children = static_cast<Node16*>(node)->m_children;
+        }
+        int position = 0;
+        while (keys[position] != byte)
+            position++;
+        for (; position + 1 < node->m_count; position++) {
+            keys[position] = keys[position + 1];
+            children[position] = children[position + 1];
+        }
+        keys[position] = 0;
+        children[position] = 0;
+        break;
+    }
+    case Type::Node48: {
+        Node48* node48 = static_cast<Node48*>(node);
+        node48->m_children[node48->m_index[byte] - 1] = 0;
+        node48->m_index[byte] = 0;
+        break;
+    }
+    case Type::Node256:
+        static_cast<Node256*>(node)->m_children[byte] = 0;
+        break;
+    }
+    node->m_count--;
+    shrink(ref, node);
+}
+
+template <typename Key>
+void RadixTree<Key>::placeLeaf(Slot& ref, Node* node, const KeyBytes& key, Slot leaf, size_t depth)
+{
+    if constexpr (!INTEGER) {
+        if (depth == key.length()) {
+            node->m_end = leaf;
+            return;
+        }
+    }
+    addChild(ref, node, key[depth], leaf);
+}
+
+// A node holding leaf and a new leaf for key, which differ somewhere after
+// depth.
+template <typename Key>
+auto RadixTree<Key>::splitLeaf(Slot leaf, const KeyBytes& key, size_t depth) -> Slot
+{
+    KeyBytes other = leafBytes(leaf, key[0]);
+    Node4* node = makeNode<Node4>();
+    Slot slot = reinterpret_cast<Slot>(node);
+    size_t length = 0;
+    while (length < MAX_PREFIX && depth + length < key.length() && depth + length < other.length()
+        && key[depth + length] == other[depth + length]) {
+        node->m_prefix[length] = key[depth + length];
+        length++;
+    }
+    node->m_prefixLength = length;
+    depth += length;
+
+    if (depth < key.length() && depth < other.length() && key[depth] == other[depth]) {
+        // Shared for longer than a prefix holds.
+        addChild(slot, node, key[depth], splitLeaf(leaf, key, depth + 1));
+        return slot;
+    }
+    placeLeaf(slot, node, other, leaf, depth);
+    placeLeaf(slot, node, key, makeLeaf(key), depth);
+    return slot;
+}
+
+// A node over node, for a key that leaves node's prefix after matched bytes.
+template <typename Key>
+auto RadixTree<Key>::splitPrefix(Node* node, size_t matched, const KeyBytes& key, size_t depth) -> Slot
+{
+    Node4* parent = makeNode<Node4>();
+    Slot slot = reinterpret_cast<Slot>(parent);
+    parent->m_prefixLength = matched;
+    std::memcpy(parent->m_prefix, node->m_prefix, matched);
+
+    uint8_t byte = node->m_prefix[matched];
+    node->m_prefixLength -= matched + 1;
+    std::memmove(node->m_prefix, node->m_prefix + matched + 1, node->m_prefixLength);
+    addChild(slot, parent, byte, reinterpret_cast<Slot>(node));
+    placeLeaf(slot, parent, key, makeLeaf(key), depth + matched);
+    return slot;
+}
+
+template <typename Key>
+bool RadixTree<Key>::insert(KeyArg value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    KeyBytes key = bytesOf(value);
+    if (m_root == 0)
+        m_root = reinterpret_cast<Slot>(makeNode<Node4>());
+
+    Slot* ref = &m_root;
+    size_t depth = 0;
+    for (;;) {
+        if (isLeaf(*ref)) {
+            if (leafMatches(*ref, key))
+                return false;
+            *ref = splitLeaf(*ref, key, depth);
+            break;
+        }
+
+        Node* node = nodeOf(*ref);
+        m_stats.visit();
+        size_t matched = prefixMatch(node, key, depth);
+        if (matched < node->m_prefixLength) {
+            *ref = splitPrefix(node, matched, key, depth);
+            break;
+        }
+        depth += matched;
+
+        if constexpr (!INTEGER) {
+            if (depth == key.length()) {
+                if (node->m_end != 0)
+                    return false;
+                node->m_end = makeLeaf(key);
+                break;
+            }
+        }
+        Slot* child = findChild(node, key[depth]);
+        if (child == nullptr) {
+            addChild(*ref, node, key[depth], makeLeaf(key));
+            break;
+        }
+        ref = child;
+        depth++;
+    }
+    m_size++;
+    return true;
+}
+
+template <typename Key>
+bool RadixTree<Key>::contains(KeyArg value) const
+{
+    auto timer = m_stats.time(Operation::Lookup);
+    KeyBytes key = bytesOf(value);
+    Slot slot = m_root;
+    size_t depth = 0;
+    while (slot != 0) {
+        if (isLeaf(slot))
+            return leafMatches(slot, key);
+        Node* node = nodeOf(slot);
+        m_stats.visit();
+        depth += node->m_prefixLength;
+        if constexpr (!INTEGER) {
+            if (depth >= key.length())
+                return depth == key.length() && node->m_end != 0 && leafMatches(node->m_end, key);
+        }
+        Slot* child = findChild(node, key[depth]);
+        if (child == nullptr)
+            return false;
+        slot = *child;
+        depth++;
+    }
+    return false;
+}
+
+template <typename Key>
+bool RadixTree<Key>::remove(KeyArg value)
+{
+    auto timer = m_stats.time(Operation::Remove);
+    if (m_root == 0 || !remove(m_root, bytesOf(value), 0, true))
+        return false;
+    m_size--;
+    return true;
+}
+
+// Removes key from the subtree of the node in ref, which starts at depth.
+template <typename Key>
+bool RadixTree<Key>::remove(Slot& ref, const KeyBytes& key, size_t depth, bool root)
+{
+    Node* node = nodeOf(ref);
+    m_stats.visit();
+    if (prefixMatch(node, key, depth) < node->m_prefixLength)
+        return false;
+    depth += node->m_prefixLength;
+
+    if constexpr (!INTEGER) {
+        if (depth == key.length()) {
+            if (node->m_end == 0)
+                return false;
+            freeLeaf(node->m_end);
+            node->m_end = 0;
+            collapse(ref, root);
+            return true;
+        }
+    }
+    Slot* child = findChild(node, key[depth]);
+    if (child == nullptr)
+        return false;
+    if (isLeaf(*child)) {
+        if (!leafMatches(*child, key))
+            return false;
+        freeLeaf(*child);
+        removeChild(ref, node, key[depth]);
+    } else if (!remove(*child, key, depth + 1, false)) {
+        return false;
+    }
+    collapse(ref, root);
+    return true;
+}
+
+// Restores path compression after a removal below the node in ref: a node
+// left with a single leaf is replaced by it, one left with a single inner
+// node is merged into it when their prefixes fit together. The root stays
+// until it is empty.
+template <typename Key>
+void RadixTree<Key>::collapse(Slot& ref, bool root)
+{
+    Node* node = nodeOf(ref);
+    if (root) {
+        if (node->m_count == 0 && !hasEnd(node)) {
+            freeNode(node);
+            ref = 0;
+        }
+        return;
+    }
+
+    if constexpr (!INTEGER) {
+        if (node->m_count == 0) {
+            ref = node->m_end;
+            freeNode(node);
+            return;
+        }
+    }
+    if (node->m_count != 1 || hasEnd(node))
+        return;
+
+    uint8_t byte = 0;
+    Slot child = 0;
+    eachChild(node, 0, [&](uint8_t key, Slot slot) {
+        byte = key;
+        child = slot;
+        return false;
+    });
+    if (isLeaf(child)) {
+        ref = child;
+        freeNode(node);
+        return;
+    }
+
+    Node* below = nodeOf(child);
+    size_t length = node->m_prefixLength + 1 + below->m_prefixLength;
+    if (length > MAX_PREFIX)
+        return;
+    std::memmove(below->m_prefix + node->m_prefixLength + 1, below->m_prefix, below->m_prefixLength);
+    below->m_prefix[node->m_prefixLength] = byte;
+    std::memcpy(below->m_prefix, node->m_prefix, node->m_prefixLength);
+    below->m_prefixLength = length;
+    ref = child;
+    freeNode(node);
+}
+
+template <typename Key>
+Key RadixTree<Key>::findMin() const
+{
+    if (m_root == 0)
+        throw std::runtime_error("findMin of an empty radix tree");
+    Slot slot = m_root;
+    uint8_t first = 0;
+    while (!isLeaf(slot)) {
+        Node* node = nodeOf(slot);
+        if (hasEnd(node)) {
+            slot = node->m_end;
+            break;
+        }
+        eachChild(node, 0, [&](uint8_t byte, Slot child) {
+            if (slot == m_root)
+                first = byte;
+            slot = child;
+            return false;
+        });
+    }
+    return Key(argOf(leafBytes(slot, first)));
+}
+
+template <typename Key>
+Key RadixTree<Key>::findMax() const
+{
+    if (m_root == 0)
+        throw std::runtime_error("findMax of an empty radix tree");
+    Slot slot = m_root;
+    uint8_t first = 0;
+    while (!isLeaf(slot)) {
+        Node* node = nodeOf(slot);
+        if (node->m_count == 0) {
+            slot = node->m_end;
+            break;
+        }
+        uint8_t byte = 0;
+        slot = lastChild(node, byte);
+        if (node == nodeOf(m_root))
+            first = byte;
+    }
+    return Key(argOf(leafBytes(slot, first)));
+}
+
+template <typename Key>
+template <typename Fn>
+void RadixTree<Key>::forRange(KeyArg low, KeyArg high, Fn&& fn) const
+{
+    auto timer = m_stats.time(Operation::Lookup);
+    if (m_root != 0)
+        scan(m_root, 0, 0, bytesOf(low), bytesOf(high), true, true, fn);
+}
+
+// In order walk of the keys in [low, high) under slot, at depth, below a
+// root branch byte of first. lowTight and highTight tell whether the path
+// so far equals the first bytes of low and of high; once it is above low or
+// below high the subtree needs no more checks on that side. Returns false
+// once a key at or above high was reached.
+template <typename Key>
+template <typename Fn>
+bool RadixTree<Key>::scan(Slot slot, size_t depth, uint8_t first, const KeyBytes& low, const KeyBytes& high,
+    bool lowTight, bool highTight, Fn& fn) const
+{
+    if (isLeaf(slot)) {
+        KeyBytes key = leafBytes(slot, first);
+        if (highTight && compare(key, high) >= 0)
+            return false;
+        if (!lowTight || compare(key, low) >= 0)
+            fn(argOf(key));
+        return true;
+    }
+
+    Node* node = nodeOf(slot);
+    m_stats.visit();
+    for (size_t i = 0; i < node->m_prefixLength; i++, depth++) {
+        uint8_t byte = node->m_prefix[i];
+        if (lowTight) {
+            if (depth >= low.length() || byte > low[depth])
+                lowTight = false;
+            else if (byte < low[depth])
+                return true;
+        }
+        if (highTight) {
+            if (depth >= high.length() || byte > high[depth])
+                return false;
+            if (byte < high[depth])
+                highTight = false;
+        }
+    }
+    if (hasEnd(node) && !scan(node->m_end, depth, first, low, high, lowTight, highTight, fn))
+        return false;
+
+    if (lowTight && depth >= low.length())
+        lowTight = false;
+    if (highTight && depth >= high.length())
+        return false;
+    return eachChild(node, lowTight ? low[depth] : 0, [&](uint8_t byte, Slot child) {
+        if (highTight && byte > high[depth])
+            return false;
+        return scan(child, depth + 1, depth == 0 ? byte : first, low, high,
+            lowTight && byte == low[depth], highTight && byte == high[depth], fn);
+    });
+}
+
+template <typename Key>
+void RadixTree<Key>::makeEmpty()
+{
+    if (m_root != 0)
+        destroy(m_root);
+    m_root = 0;
+    m_size = 0;
+}
+
+template <typename Key>
+void RadixTree<Key>::account(Slot slot, MemoryUsage& usage) const
+{
+    if (isLeaf(slot)) {
+        if constexpr (!INTEGER) {
+            uint64_t bytes = sizeof(Leaf) + leafOf(slot)->m_length;
+            usage.m_payload += leafOf(slot)->m_length;
+            usage.m_overhead += sizeof(Leaf);
+            usage.allocations(bytes);
+        }
+        return;
+    }
+    Node* node = nodeOf(slot);
+    uint64_t bytes = nodeSize(node->m_type);
+    usage.m_overhead += bytes;
+    usage.allocations(bytes);
+    eachChild(node, 0, [&](uint8_t, Slot child) {
+        account(child, usage);
+        return true;
+    });
+    if (hasEnd(node))
+        account(node->m_end, usage);
+}
+
+template <typename Key>
+MemoryUsage RadixTree<Key>::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.m_elements = m_size;
+    usage.m_overhead = sizeof(*this);
+    if (m_root != 0)
+        account(m_root, usage);
+    if constexpr (INTEGER) {
+        usage.m_payload = m_size * sizeof(Key);
+        usage.m_overhead -= usage.m_payload;
+    }
+    return usage;
+}
@@ -0,0 +1,179 @@
+#include "radix-tree.hpp"
+#include <climits>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+TEST(RadixTree, InsertContainsRemove)
+{
+    RadixTree<int> tree;
+    EXPECT_TRUE(tree.isEmpty());
+    EXPECT_FALSE(tree.contains(4));
+
+    EXPECT_TRUE(tree.insert(4));
+    EXPECT_TRUE(tree.insert(-7));
+    EXPECT_TRUE(tree.insert(1 << 20));
+    EXPECT_FALSE(tree.insert(4));
+    EXPECT_EQ(tree.size(), 3);
+
+    EXPECT_TRUE(tree.contains(-7));
+    EXPECT_FALSE(tree.contains(7));
+    EXPECT_FALSE(tree.contains(5));
+
+    EXPECT_TRUE(tree.remove(4));
+    EXPECT_FALSE(tree.remove(4));
+    EXPECT_FALSE(tree.contains(4));
+    EXPECT_TRUE(tree.remove(-7));
+    EXPECT_TRUE(tree.remove(1 << 20));
+    EXPECT_TRUE(tree.isEmpty());
+    EXPECT_THROW(tree.findMin(), std::runtime_error);
+}
+
+TEST(RadixTree, MinMax)
+{
+    RadixTree<int64_t> tree;
+    for (int64_t key : { int64_t(5), int64_t(-3), INT64_MAX, INT64_MIN, int64_t(0) })
+        tree.insert(key);
+    EXPECT_EQ(tree.findMin(), INT64_MIN);
+    EXPECT_EQ(tree.findMax(), INT64_MAX);
+
+    tree.remove(INT64_MIN);
+    tree.remove(INT64_MAX);
+    EXPECT_EQ(tree.findMin(), -3);
+    EXPECT_EQ(tree.findMax(), 5);
+}
+
+// Random inserts and removes against std::set, dense enough in the low bytes
+// for every node size to grow and shrink again.
+template <typename Key>
+static void check_against_set(uint64_t mask)
+{
+    RadixTree<Key> tree;
+    std::set<Key> set;
+    std::mt19937_64 random(7);
+    for (int i = 0; i < 200000; i++) {
+        Key key = Key(random() & mask);
+        if (random() % 3 == 0)
+            ASSERT_EQ(tree.remove(key), set.erase(key) == 1);
+        else
+            ASSERT_EQ(tree.insert(key), set.insert(key).second);
+    }
+    ASSERT_EQ(tree.size(), set.size());
+    EXPECT_EQ(tree.findMin(), *set.begin());
+    EXPECT_EQ(tree.findMax(), *set.rbegin());
+
+    for (int i = 0; i < 100; i++) {
+        Key low = Key(random() & mask);
+        Key high = Key(random() & mask);
+        if (high < low)
+            std::swap(low, high);
+        std::vector<Key> keys;
+        tree.forRange(low, high, [&](Key key) { keys.push_back(key); });
+        ASSERT_EQ(keys, std::vector<Key>(set.lower_bound(low), set.lower_bound(high)));
+    }
+
+    for (Key key : std::set<Key>(set))
+        ASSERT_TRUE(tree.remove(key));
+    EXPECT_TRUE(tree.isEmpty());
+}
+
+TEST(RadixTree, RandomInt)
+{
+    check_against_set<int>(0x80000fff);
+}
+
+TEST(RadixTree, RandomUint64)
+{
+    check_against_set<uint64_t>(0xff000000000fff0fULL);
+}
+
+TEST(RadixTree, RandomInt64)
+{
+    check_against_set<int64_t>(0x8000ff00000003ffULL);
+}
+
+TEST(RadixTree, Range)
+{
+    RadixTree<int> tree;
+    for (int key = -1000; key < 1000; key += 3)
+        tree.insert(key);
+
+    std::vector<int> keys;
+    tree.forRange(-10, 11, [&](int key) { keys.push_back(key); });
+    EXPECT_EQ(keys, (std::vector<int> { -10, -7, -4, -1, 2, 5, 8 }));
+
+    keys.clear();
+    tree.forRange(3, 5, [&](int key) { keys.push_back(key); });
+    EXPECT_TRUE(keys.empty());
+
+    int count = 0;
+    tree.forRange(INT_MIN, INT_MAX, [&](int) { count++; });
+    EXPECT_EQ(count, tree.size());
+}
+
+// Keys that are prefixes of others end at inner nodes, long shared prefixes
+// chain nodes.
+TEST(RadixTree, Strings)
+{
+    RadixTree<std::string> tree;
+    std::string shared(40, 'x');
+    std::vector<std::string> words = { "", "a", "ab", "abc", "abd", "b", shared, shared + "a", shared + "b",
+        shared.substr(0, 20) };
+    for (const std::string& word : words)
+        EXPECT_TRUE(tree.insert(word));
+    EXPECT_FALSE(tree.insert("ab"));
+    for (const std::string& word : words)
+        EXPECT_TRUE(tree.contains(word));
+    EXPECT_FALSE(tree.contains("abcd"));
+    EXPECT_FALSE(tree.contains(shared.substr(0, 30)));
+    EXPECT_EQ(tree.findMin(), "");
+    EXPECT_EQ(tree.findMax(), shared + "b");
+
+    std::vector<std::string> range;
+    tree.forRange("a", "abd", [&](std::string_view word) { range.emplace_back(word); });
+    EXPECT_EQ(range, (std::vector<std::string> { "a", "ab", "abc" }));
+
+    EXPECT_TRUE(tree.remove("ab"));
+    EXPECT_TRUE(tree.remove(shared));
+    EXPECT_FALSE(tree.remove(shared));
+    EXPECT_TRUE(tree.contains("abc"));
+    EXPECT_TRUE(tree.contains(shared + "a"));
+    EXPECT_EQ(tree.size(), words.size() - 2);
+}
+
+TEST(RadixTree, RandomStrings)
+{
+    RadixTree<std::string> tree;
+    std::set<std::string> set;
+    std::mt19937_64 random(11);
+    for (int i = 0; i < 50000; i++) {
+        std::string key(random() % 6, 'a');
+        for (char& c : key)
+            c = char('a' + random() % 4);
+        if (random() % 3 == 0)
+            ASSERT_EQ(tree.remove(key), set.erase(key) == 1);
+        else
+            ASSERT_EQ(tree.insert(key), set.insert(key).second);
+    }
+    ASSERT_EQ(tree.size(), set.size());
+
+    std::vector<std::string> keys;
+    tree.forRange("", "zz", [&](std::string_view key) { keys.emplace_back(key); });
+    EXPECT_EQ(keys, std::vector<std::string>(set.begin(), set.end()));
+}
+
+// Integer keys live in the child slots, so a dense range costs about one
+// slot per key.
+TEST(RadixTree, MemoryUsage)
+{
+    RadixTree<int> tree;
+    for (int key = 0; key < 1 << 16; key++)
+        tree.insert(key);
+
+    MemoryUsage usage = tree.memoryUsage();
+    EXPECT_EQ(usage.m_elements, 1 << 16);
+    EXPECT_EQ(usage.m_payload, (1 << 16) * sizeof(int));
+    EXPECT_LT(usage.bytes_per_element(), 12);
+}
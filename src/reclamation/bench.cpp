@@ -0,0 +1,114 @@
+#include "epoch-reclamation.hpp"
+#include "hazard-pointers.hpp"
+#include <benchmark/benchmark.h>
+
+// Read side overhead: one pass over a shared linked list of 1024 nodes
+// without protection, inside one epoch guard, and with a hazard pointer
+// published hand over hand for every node.
+
+struct Node {
+    std::atomic<Node*> m_next;
+    int64_t m_value;
+};
+
+static constexpr int LENGTH = 1024;
+
+static std::atomic<Node*>& list()
+{
+    static std::atomic<Node*> head = []() {
+        Node* head = nullptr;
+        for (int i = 0; i < LENGTH; i++)
+            head = new Node { head, i };
+        return head;
+    }();
+    return head;
+}
+
+static void BM_TraverseUnprotected(benchmark::State& state)
+{
+    std::atomic<Node*>& head = list();
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (Node* node = head.load(std::memory_order_acquire); node != nullptr;
+             node = node->m_next.load(std::memory_order_acquire))
+            sum += node->m_value;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * LENGTH);
+}
+BENCHMARK(BM_TraverseUnprotected)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_TraverseEpoch(benchmark::State& state)
+{
+    std::atomic<Node*>& head = list();
+    for (auto _ : state) {
+        EpochReclamation::Guard guard;
+        int64_t sum = 0;
+        for (Node* node = head.load(std::memory_order_acquire); node != nullptr;
+             node = node->m_next.load(std::memory_order_acquire))
+            sum += node->m_value;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * LENGTH);
+}
+BENCHMARK(BM_TraverseEpoch)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_TraverseHazard(benchmark::State& state)
+{
+    std::atomic<Node*>& head = list();
+    for (auto _ : state) {
+        int64_t sum = 0;
+        int slot = 0;
+        for (Node* node = HazardPointers::protect(slot, head); node != nullptr;) {
+            sum += node->m_value;
+            slot ^= 1;
+            node = HazardPointers::protect(slot, node->m_next);
+        }
+        HazardPointers::clear();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * LENGTH);
+}
+BENCHMARK(BM_TraverseHazard)->ThreadRange(1, 64)->UseRealTime();
+
+// A point lookup touches a handful of nodes, so entering and leaving the
+// guard is most of what it pays.
+static void BM_EpochGuard(benchmark::State& state)
+{
+    for (auto _ : state) {
+        EpochReclamation::Guard guard;
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_EpochGuard)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_HazardProtect(benchmark::State& state)
+{
+    std::atomic<Node*>& head = list();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HazardPointers::protect(0, head));
+        HazardPointers::clear();
+    }
+}
+BENCHMARK(BM_HazardProtect)->ThreadRange(1, 64)->UseRealTime();
+
+// Write side: allocate a node and retire it, frees are batched by both.
+// pending is what a thread still holds at the end, per thread.
+static void BM_EpochRetire(benchmark::State& state)
+{
+    for (auto _ : state) {
+        EpochReclamation::Guard guard;
+        EpochReclamation::retire(new Node { nullptr, 0 });
+    }
+    state.counters["pending"] = benchmark::Counter(EpochReclamation::pending(), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_EpochRetire)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_HazardRetire(benchmark::State& state)
+{
+    for (auto _ : state) {
+        HazardPointers::retire(new Node { nullptr, 0 });
+    }
+    state.counters["pending"] = benchmark::Counter(HazardPointers::pending(), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_HazardRetire)->ThreadRange(1, 64)->UseRealTime();
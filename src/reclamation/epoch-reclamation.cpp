@@ -0,0 +1,93 @@
+#include "epoch-reclamation.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+struct Tracked {
+    static inline std::atomic<int> s_freed { 0 };
+    ~Tracked() { s_freed++; }
+};
+
+TEST(EpochReclamation, FreedAfterFlush)
+{
+    EpochReclamation::flush();
+    int freed = Tracked::s_freed;
+    EpochReclamation::retire(new Tracked);
+    EXPECT_EQ(EpochReclamation::pending(), 1);
+    EXPECT_EQ(Tracked::s_freed, freed);
+
+    EpochReclamation::flush();
+    EXPECT_EQ(EpochReclamation::pending(), 0);
+    EXPECT_EQ(Tracked::s_freed, freed + 1);
+}
+
+// Nested guards only leave the epoch when the outermost one goes.
+TEST(EpochReclamation, OwnGuardKeepsMemory)
+{
+    int freed = Tracked::s_freed;
+    {
+        EpochReclamation::Guard outer;
+        {
+            EpochReclamation::Guard inner;
+            EpochReclamation::retire(new Tracked);
+        }
+        EpochReclamation::flush();
+        EpochReclamation::flush();
+        EXPECT_EQ(Tracked::s_freed, freed);
+    }
+    EpochReclamation::flush();
+    EXPECT_EQ(Tracked::s_freed, freed + 1);
+}
+
+TEST(EpochReclamation, OtherGuardKeepsMemory)
+{
+    std::atomic<bool> entered = false;
+    std::atomic<bool> done = false;
+    std::thread reader([&]() {
+        EpochReclamation::Guard guard;
+        entered = true;
+        while (!done)
+            std::this_thread::yield();
+    });
+    while (!entered)
+        std::this_thread::yield();
+
+    int freed = Tracked::s_freed;
+    EpochReclamation::retire(new Tracked);
+    for (int i = 0; i < 4; i++)
+        EpochReclamation::flush();
+    EXPECT_EQ(Tracked::s_freed, freed);
+
+    done = true;
+    reader.join();
+    EpochReclamation::flush();
+    EXPECT_EQ(Tracked::s_freed, freed + 1);
+}
+
+TEST(EpochReclamation, BoundedGarbage)
+{
+    size_t most = 0;
+    for (int i = 0; i < 100000; i++) {
+        EpochReclamation::Guard guard;
+        EpochReclamation::retire(new Tracked);
+        most = std::max(most, EpochReclamation::pending());
+    }
+    EXPECT_LT(most, 4096);
+}
+
+// What an exiting thread could not free yet is left to the others.
+TEST(EpochReclamation, ExitedThreadGarbage)
+{
+    EpochReclamation::flush();
+    EpochReclamation::Guard* guard = new EpochReclamation::Guard;
+    int freed = Tracked::s_freed;
+    std::thread([]() {
+        for (int i = 0; i < 10; i++)
+            EpochReclamation::retire(new Tracked);
+    }).join();
+    EXPECT_LT(Tracked::s_freed, freed + 10);
+
+    delete guard;
+    EpochReclamation::flush();
+    EXPECT_EQ(Tracked::s_freed, freed + 10);
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Epoch based reclamation. Threads announce the global epoch while they hold
+// a Guard. Memory retired during epoch e can only be reached by threads that
+// were already inside a guard, and the epoch only moves on once every thread
+// in a guard has seen the current one, so by epoch e + 2 nobody can still
+// hold a pointer to it and it is freed.
+//
+// Reads only pay for entering and leaving the guard, however many nodes they
+// visit. The price is that one thread stalled inside a guard keeps the epoch
+// from moving and nothing retired after it can be freed; HazardPointers
+// bound the garbage instead.
+class EpochReclamation {
+public:
+    class Guard {
+    public:
+        Guard() { enter(); }
+        ~Guard() { leave(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // Frees ptr with deleter once no guard can still see it. Retired memory
+    // waits in one of three per thread limbo bags, one per epoch, and a bag
+    // is freed as a batch. Every COLLECT_EVERY retires the thread tries to
+    // move the epoch on, every retire once it holds more than MAX_PENDING,
+    // so garbage stays bounded unless a thread stalls inside a guard.
+    static void retire(void* ptr, void (*deleter)(void*))
+    {
+        ThreadState& thread = state();
+        uint64_t epoch = s_epoch.load(std::memory_order_acquire);
+        Limbo& limbo = thread.m_limbo[epoch % 3];
+        // The bag last held epoch - 3 or older, which is safe by now.
+        if (limbo.m_epoch != epoch) {
+            free(thread, limbo);
+            limbo.m_epoch = epoch;
+        }
+        limbo.m_retired.push_back({ ptr, deleter });
+        thread.m_pending++;
+        if (++thread.m_since_collect >= COLLECT_EVERY || thread.m_pending > MAX_PENDING) {
+            thread.m_since_collect = 0;
+            collect(thread);
+        }
+    }
+
+    template <typename N>
+    static void retire(N* ptr)
+    {
+        retire(ptr, [](void* p) { delete static_cast<N*>(p); });
+    }
+
+    // Moves the epoch on as far as the other threads allow and frees what
+    // this thread retired before that.
+    static void flush()
+    {
+        ThreadState& thread = state();
+        collect(thread);
+        collect(thread);
+    }
+
+    // Memory this thread retired that is not freed yet.
+    static size_t pending()
+    {
+        return state().m_pending;
+    }
+
+private:
+    static constexpr uint64_t ACTIVE = 1;
+    static constexpr int COLLECT_EVERY = 64;
+    static constexpr size_t MAX_PENDING = 4096;
+
+    struct alignas(64) Record {
+        // Epoch << 1 | ACTIVE while the thread is inside a guard.
+        std::atomic<uint64_t> m_state;
+        std::atomic<bool> m_used;
+        Record* m_next;
+    };
+
+    struct Retired {
+        void* m_ptr;
+        void (*m_deleter)(void*);
+    };
+
+    struct Limbo {
+        uint64_t m_epoch = 0;
+        std::vector<Retired> m_retired;
+    };
+
+    // Memory retired by threads that exited before it was safe to free.
+    struct Orphans {
+        std::mutex m_mutex;
+        std::vector<std::pair<uint64_t, Retired>> m_retired;
+
+        ~Orphans()
+        {
+            for (auto& [epoch, retired] : m_retired) {
+                retired.m_deleter(retired.m_ptr);
+            }
+        }
+    };
+
+    struct ThreadState {
+        Record* m_record;
+        unsigned int m_depth = 0;
+        int m_since_collect = 0;
+        size_t m_pending = 0;
+        Limbo m_limbo[3];
+
+        ThreadState()
+            : m_record(acquire_record()) {};
+
+        ~ThreadState()
+        {
+            collect(*this);
+            std::lock_guard<std::mutex> lock(s_orphans.m_mutex);
+            for (Limbo& limbo : m_limbo) {
+                for (Retired& retired : limbo.m_retired) {
+                    s_orphans.m_retired.push_back({ limbo.m_epoch, retired });
+                }
+            }
+            m_record->m_used.store(false, std::memory_order_release);
+        }
+    };
+
+    static inline std::atomic<uint64_t> s_epoch { 0 };
+    static inline std::atomic<Record*> s_records { nullptr };
+    static inline Orphans s_orphans;
+
+    static ThreadState& state()
+    {
+        thread_local ThreadState thread;
+        return thread;
+    }
+
+    // Guards nest, only the outermost one announces an epoch. The epoch is
+    // read again after the announcement is visible, so a thread never runs
+    // on an epoch that moved on before the others could see it. Seq_cst
+    // accesses order the store before the load rather than a fence, which
+    // TSan does not model.
+    static void enter()
+    {
+        ThreadState& thread = state();
+        if (thread.m_depth++ != 0)
+            return;
+        uint64_t epoch = s_epoch.load(std::memory_order_relaxed);
+        for (;;) {
+            thread.m_record->m_state.store(epoch << 1 | ACTIVE, std::memory_order_seq_cst);
+            uint64_t current = s_epoch.load(std::memory_order_seq_cst);
+            if (current == epoch)
+                return;
+            epoch = current;
+        }
+    }
+
+    static void leave()
+    {
+        ThreadState& thread = state();
+        if (--thread.m_depth != 0)
+            return;
+        thread.m_record->m_state.store(0, std::memory_order_release);
+    }
+
+    // Moves the epoch on if every thread inside a guard is in it already.
+    static uint64_t try_advance()
+    {
+        uint64_t epoch = s_epoch.load(std::memory_order_seq_cst);
+        for (Record* record = s_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+            uint64_t state = record->m_state.load(std::memory_order_seq_cst);
+            if ((state & ACTIVE) != 0 && (state >> 1) != epoch)
+                return epoch;
+        }
+        if (s_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel))
+            return epoch + 1;
+        return epoch;
+    }
+
+    static void free(ThreadState& thread, Limbo& limbo)
+    {
+        for (Retired& node : limbo.m_retired) {
+            node.m_deleter(node.m_ptr);
+        }
+        thread.m_pending -= limbo.m_retired.size();
+        limbo.m_retired.clear();
+    }
+
+    static void collect(ThreadState& thread)
+    {
+        uint64_t epoch = try_advance();
+        for (Limbo& limbo : thread.m_limbo) {
+            if (limbo.m_epoch + 2 <= epoch)
+                free(thread, limbo);
+        }
+
+        std::unique_lock<std::mutex> lock(s_orphans.m_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return;
+        size_t kept = 0;
+        for (auto& orphan : s_orphans.m_retired) {
+            if (orphan.first + 2 <= epoch)
+                orphan.second.m_deleter(orphan.second.m_ptr);
+            else
+                s_orphans.m_retired[kept++] = orphan;
+        }
+        s_orphans.m_retired.resize(kept);
+    }
+
+    // Reuses the record of a thread that exited, or links a new one.
+    static Record* acquire_record()
+    {
+        for (Record* record = s_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+            bool used = false;
+            if (record->m_used.compare_exchange_strong(used, true, std::memory_order_acq_rel))
+                return record;
+        }
+
+        Record* record = new Record;
+        record->m_state.store(0, std::memory_order_relaxed);
+        record->m_used.store(true, std::memory_order_relaxed);
+        record->m_next = s_records.load(std::memory_order_relaxed);
+        while (!s_records.compare_exchange_weak(record->m_next, record, std::memory_order_release)) { }
+        return record;
+    }
+};
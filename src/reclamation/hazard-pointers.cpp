@@ -0,0 +1,64 @@
+#include "hazard-pointers.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+struct Tracked {
+    static inline std::atomic<int> s_freed { 0 };
+    ~Tracked() { s_freed++; }
+};
+
+TEST(HazardPointers, ProtectedSurvivesFlush)
+{
+    HazardPointers::flush();
+    int freed = Tracked::s_freed;
+    std::atomic<Tracked*> shared = new Tracked;
+    Tracked* node = HazardPointers::protect(0, shared);
+    shared = nullptr;
+    HazardPointers::retire(node);
+
+    HazardPointers::flush();
+    EXPECT_EQ(Tracked::s_freed, freed);
+    EXPECT_EQ(HazardPointers::pending(), 1);
+
+    HazardPointers::clear();
+    HazardPointers::flush();
+    EXPECT_EQ(Tracked::s_freed, freed + 1);
+    EXPECT_EQ(HazardPointers::pending(), 0);
+}
+
+TEST(HazardPointers, ProtectedByOtherThread)
+{
+    std::atomic<Tracked*> shared = new Tracked;
+    std::atomic<bool> protecting = false;
+    std::atomic<bool> done = false;
+    std::thread reader([&]() {
+        HazardPointers::protect(1, shared);
+        protecting = true;
+        while (!done)
+            std::this_thread::yield();
+        HazardPointers::clear();
+    });
+    while (!protecting)
+        std::this_thread::yield();
+
+    int freed = Tracked::s_freed;
+    HazardPointers::retire(shared.exchange(nullptr));
+    HazardPointers::flush();
+    EXPECT_EQ(Tracked::s_freed, freed);
+
+    done = true;
+    reader.join();
+    HazardPointers::flush();
+    EXPECT_EQ(Tracked::s_freed, freed + 1);
+}
+
+TEST(HazardPointers, BoundedGarbage)
+{
+    size_t most = 0;
+    for (int i = 0; i < 100000; i++) {
+        HazardPointers::retire(new Tracked);
+        most = std::max(most, HazardPointers::pending());
+    }
+    EXPECT_LT(most, 256);
+}
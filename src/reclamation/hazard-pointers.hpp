@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Hazard pointers. Before dereferencing a node a thread publishes it in one
+// of its slots; removed nodes are retired to a per thread list and only
+// deleted once no slot points at them. Every read pays a store and a full
+// fence per node, but garbage stays bounded by the number of slots even if
+// a thread stalls, which EpochReclamation can not promise.
+class HazardPointers {
+public:
+    static constexpr int SLOTS = 2;
+
+    struct alignas(64) Record {
+        std::atomic<void*> m_hazard[SLOTS];
+        std::atomic<bool> m_active;
+        Record* m_next;
+    };
+
+    // Publishes the pointer currently in src in slot and returns it, once it
+    // is sure src did not change in between.
+    template <typename N>
+    static N* protect(int slot, const std::atomic<N*>& src)
+    {
+        std::atomic<void*>& hazard = state().m_record->m_hazard[slot];
+        N* ptr = src.load(std::memory_order_relaxed);
+        for (;;) {
+            hazard.store(ptr, std::memory_order_seq_cst);
+            N* curr = src.load(std::memory_order_seq_cst);
+            if (curr == ptr)
+                return ptr;
+            ptr = curr;
+        }
+    }
+
+    static void clear()
+    {
+        Record* record = state().m_record;
+        for (int i = 0; i < SLOTS; i++) {
+            record->m_hazard[i].store(nullptr, std::memory_order_release);
+        }
+    }
+
+    // Frees ptr with deleter once no slot points at it. A scan runs once a
+    // thread holds more retired nodes than there are slots, so at most
+    // 2 * SLOTS * threads + 64 of them wait per thread.
+    static void retire(void* ptr, void (*deleter)(void*))
+    {
+        ThreadState& thread = state();
+        thread.m_retired.push_back({ ptr, deleter });
+        if (thread.m_retired.size() >= 2 * SLOTS * static_cast<size_t>(s_count.load(std::memory_order_relaxed)) + 64)
+            scan(thread.m_retired);
+    }
+
+    template <typename N>
+    static void retire(N* ptr)
+    {
+        retire(ptr, [](void* p) { delete static_cast<N*>(p); });
+    }
+
+    // Frees every node of this thread that is not protected right now.
+    static void flush()
+    {
+        scan(state().m_retired);
+    }
+
+    // Nodes this thread retired that are not freed yet.
+    static size_t pending()
+    {
+        return state().m_retired.size();
+    }
+
+private:
+    struct Retired {
+        void* m_ptr;
+        void (*m_deleter)(void*);
+    };
+
+    // Nodes retired by threads that exited while they were still protected.
+    struct Orphans {
+        std::mutex m_mutex;
+        std::vector<Retired> m_retired;
+
+        ~Orphans()
+        {
+            for (Retired& retired : m_retired) {
+                retired.m_deleter(retired.m_ptr);
+            }
+        }
+    };
+
+    struct ThreadState {
+        Record* m_record;
+        std::vector<Retired> m_retired;
+
+        ThreadState()
+            : m_record(acquire_record()) {};
+
+        ~ThreadState()
+        {
+            for (int i = 0; i < SLOTS; i++) {
+                m_record->m_hazard[i].store(nullptr, std::memory_order_release);
+            }
+            scan(m_retired);
+            if (!m_retired.empty()) {
+                std::lock_guard<std::mutex> lock(s_orphans.m_mutex);
+                s_orphans.m_retired.insert(s_orphans.m_retired.end(), m_retired.begin(), m_retired.end());
+            }
+            m_record->m_active.store(false, std::memory_order_release);
+        }
+    };
+
+    static inline std::atomic<Record*> s_records { nullptr };
+    static inline std::atomic<int> s_count { 0 };
+    static inline Orphans s_orphans;
+
+    static ThreadState& state()
+    {
+        thread_local ThreadState thread;
+        return thread;
+    }
+
+    // Reuses the record of a thread that exited, or links a new one.
+    static Record* acquire_record()
+    {
+        for (Record* record = s_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+            bool active = false;
+            if (record->m_active.compare_exchange_strong(active, true, std::memory_order_acq_rel))
+                return record;
+        }
+
+        Record* record = new Record;
+        for (int i = 0; i < SLOTS; i++) {
+            record->m_hazard[i].store(nullptr, std::memory_order_relaxed);
+        }
+        record->m_active.store(true, std::memory_order_relaxed);
+        record->m_next = s_records.load(std::memory_order_relaxed);
+        while (!s_records.compare_exchange_weak(record->m_next, record, std::memory_order_release)) { }
+        s_count.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    static void scan(std::vector<Retired>& retired)
+    {
+        std::unique_lock<std::mutex> lock(s_orphans.m_mutex, std::try_to_lock);
+        if (lock.owns_lock() && !s_orphans.m_retired.empty()) {
+            retired.insert(retired.end(), s_orphans.m_retired.begin(), s_orphans.m_retired.end());
+            s_orphans.m_retired.clear();
+        }
+        if (lock.owns_lock())
+            lock.unlock();
+
+        std::vector<void*> hazards;
+        for (Record* record = s_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+            for (int i = 0; i < SLOTS; i++) {
+                void* hazard = record->m_hazard[i].load(std::memory_order_seq_cst);
+                if (hazard != nullptr)
+                    hazards.push_back(hazard);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        size_t kept = 0;
+        for (Retired& node : retired) {
+            if (std::binary_search(hazards.begin(), hazards.end(), node.m_ptr)) {
+                retired[kept++] = node;
+            } else {
+                node.m_deleter(node.m_ptr);
+            }
+        }
+        retired.resize(kept);
+    }
+};
@@ -0,0 +1,97 @@
+#include "../avl-tree/avl-tree.hpp"
+#include "concurrent-skip-list.hpp"
+#include "skip-list.hpp"
+#include <benchmark/benchmark.h>
+#include <mutex>
+
+// One mutex around a sequential set, the baseline the lock-free list has to
+// beat once there is more than one thread.
+template <typename Set>
+class Locked {
+private:
+    std::mutex m_mutex;
+    Set m_set;
+
+public:
+    bool contains(int value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_set.contains(value);
+    }
+
+    void insert(int value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_set.insert(value);
+    }
+
+    // AVLTree::remove expects the value to be there.
+    void remove(int value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_set.contains(value))
+            m_set.remove(value);
+    }
+};
+
+static constexpr int KEYS = 1 << 16;
+
+// Shared by every run of a benchmark, half of the keys are in. Inserts and
+// removes are equally likely, so it stays about half full.
+template <typename Set>
+static Set& prefilled()
+{
+    static Set set;
+    static bool filled = []() {
+        for (int key = 0; key < KEYS; key += 2)
+            set.insert(key);
+        return true;
+    }();
+    benchmark::DoNotOptimize(filled);
+    return set;
+}
+
+// state.range(0) percent of the operations are lookups, the rest split
+// evenly between inserts and removes of random keys.
+template <typename Set>
+static void BM_Mixed(benchmark::State& state)
+{
+    Set& set = prefilled<Set>();
+    const uint64_t reads = state.range(0);
+    const uint64_t inserts = reads + (100 - reads) / 2;
+    uint64_t random = 0x9e3779b97f4a7c15ULL * (state.thread_index() + 1);
+    for (auto _ : state) {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        int key = random % KEYS;
+        uint64_t operation = (random >> 32) % 100;
+        if (operation < reads)
+            benchmark::DoNotOptimize(set.contains(key));
+        else if (operation < inserts)
+            set.insert(key);
+        else
+            set.remove(key);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mixed<ConcurrentSkipList<int>>)->Arg(90)->Arg(50)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Mixed<Locked<SkipList<int>>>)->Arg(90)->Arg(50)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Mixed<Locked<AVLTree<int>>>)->Arg(90)->Arg(50)->ThreadRange(1, 64)->UseRealTime();
+
+// Sum over a range of 256 keys, the ordered query a hash table can not do.
+template <typename Set>
+static void BM_Range(benchmark::State& state)
+{
+    Set& set = prefilled<Set>();
+    int low = 0;
+    for (auto _ : state) {
+        int64_t sum = 0;
+        set.for_range(low, low + 256, [&](int value) { sum += value; });
+        benchmark::DoNotOptimize(sum);
+        low = (low + 4099) % (KEYS - 256);
+    }
+    state.SetItemsProcessed(state.iterations() * 128);
+}
+BENCHMARK(BM_Range<ConcurrentSkipList<int>>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Range<SkipList<int>>);
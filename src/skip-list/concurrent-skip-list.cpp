@@ -0,0 +1,129 @@
+#include "concurrent-skip-list.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentSkipList, SingleThread)
+{
+    ConcurrentSkipList<int> list;
+    std::set<int> expected;
+    std::mt19937 random(13);
+    for (int i = 0; i < 50000; i++) {
+        int value = random() % 5000;
+        if (random() % 3 == 0)
+            EXPECT_EQ(list.remove(value), expected.erase(value) == 1);
+        else
+            EXPECT_EQ(list.insert(value), expected.insert(value).second);
+    }
+    EXPECT_EQ(list.size(), expected.size());
+    for (int value = 0; value < 5000; value++)
+        EXPECT_EQ(list.contains(value), expected.count(value) == 1) << value;
+
+    std::vector<int> values;
+    list.for_range(0, 5000, [&](int value) { values.push_back(value); });
+    EXPECT_TRUE(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+}
+
+// Every thread owns the keys congruent to its index, so each one knows what
+// its keys should look like at the end while all of them share the levels.
+TEST(ConcurrentSkipList, DisjointWriters)
+{
+    constexpr int THREADS = 4;
+    constexpr int KEYS = 4000;
+    ConcurrentSkipList<int> list;
+    std::vector<std::set<int>> expected(THREADS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 random(t);
+            for (int i = 0; i < 40000; i++) {
+                int value = random() % (KEYS / THREADS) * THREADS + t;
+                if (random() % 2 == 0)
+                    EXPECT_EQ(list.remove(value), expected[t].erase(value) == 1);
+                else
+                    EXPECT_EQ(list.insert(value), expected[t].insert(value).second);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    std::set<int> all;
+    for (const std::set<int>& keys : expected)
+        all.insert(keys.begin(), keys.end());
+    std::vector<int> values;
+    list.for_range(0, KEYS, [&](int value) { values.push_back(value); });
+    EXPECT_TRUE(std::equal(values.begin(), values.end(), all.begin(), all.end()));
+}
+
+// All threads fight over the same few keys. A key ends up in the list
+// exactly when its successful inserts outnumber its successful removes.
+TEST(ConcurrentSkipList, ContendedKeys)
+{
+    constexpr int THREADS = 4;
+    constexpr int KEYS = 32;
+    ConcurrentSkipList<int> list;
+    std::atomic<int> balance[KEYS] = {};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 random(100 + t);
+            for (int i = 0; i < 100000; i++) {
+                int value = random() % KEYS;
+                if (random() % 2 == 0) {
+                    if (list.insert(value))
+                        balance[value]++;
+                } else if (list.remove(value)) {
+                    balance[value]--;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (int value = 0; value < KEYS; value++) {
+        ASSERT_GE(balance[value], 0);
+        ASSERT_LE(balance[value], 1);
+        EXPECT_EQ(list.contains(value), balance[value] == 1) << value;
+    }
+}
+
+struct Counted {
+    static inline std::atomic<int> s_alive { 0 };
+    int m_value;
+
+    Counted(int value)
+        : m_value(value)
+    {
+        s_alive++;
+    }
+    Counted(const Counted& other)
+        : m_value(other.m_value)
+    {
+        s_alive++;
+    }
+    ~Counted() { s_alive--; }
+
+    bool operator<(const Counted& other) const { return m_value < other.m_value; }
+};
+
+// Removed nodes go through the epochs and are freed while the list is in
+// use, not all at the end.
+TEST(ConcurrentSkipList, RetiredNodesAreFreed)
+{
+    int before = Counted::s_alive;
+    {
+        ConcurrentSkipList<Counted> list;
+        for (int i = 0; i < 100000; i++) {
+            list.insert(Counted(i));
+            list.remove(Counted(i));
+        }
+        EXPECT_LT(Counted::s_alive - before, 1000);
+    }
+}
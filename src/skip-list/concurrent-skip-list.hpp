@@ -0,0 +1,297 @@
+#pragma once
+
+#include "../reclamation/epoch-reclamation.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+
+// Lock-free ordered set (Herlihy and Shavit's skip list, after Fraser). Every
+// level is a sorted singly linked list whose links carry a mark bit: a node
+// is removed by marking its links from the top level down, and whoever marks
+// the bottom link owns the removal. Searches unlink marked nodes they walk
+// past with a CAS on the predecessor, so a marked link is never extended.
+//
+// A node is linked bottom up after it is in the bottom level, and can be
+// removed while that is still going on. The last of its inserter and its
+// remover to finish re-runs the unlinking search and then retires it to
+// EpochReclamation.
+template <typename T, typename Compare = std::less<T>>
+class ConcurrentSkipList {
+public:
+    static constexpr int MAX_HEIGHT = 16;
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    using Link = std::atomic<uintptr_t>;
+
+    struct Node {
+        T m_value;
+        std::atomic<int> m_owners;
+        size_t m_height;
+
+        Node(const T& value, size_t height)
+            : m_value(value)
+            , m_owners(2)
+            , m_height(height)
+        {
+        }
+
+        // The m_height links are allocated right after the node.
+        Link* next() { return reinterpret_cast<Link*>(this + 1); }
+    };
+
+    alignas(CACHE_LINE) Link m_head[MAX_HEIGHT];
+    [[no_unique_address]] Compare m_compare;
+
+    static Node* pointer(uintptr_t link) { return reinterpret_cast<Node*>(link & ~uintptr_t(1)); }
+    static bool marked(uintptr_t link) { return (link & 1) != 0; }
+
+    static int random_height()
+    {
+        thread_local uint64_t random = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        int height = 1 + __builtin_ctzll(random | (uint64_t(1) << 62)) / 2;
+        return height < MAX_HEIGHT ? height : MAX_HEIGHT;
+    }
+
+    static Node* make_node(const T& value, int height)
+    {
+        void* memory = ::operator new(sizeof(Node) + height * sizeof(Link));
+        Node* node = ::new (memory) Node(value, height);
+        for (int level = 0; level < height; level++)
+            ::new (node->next() + level) Link(0);
+        return node;
+    }
+
+    static void destroy(void* memory)
+    {
+        Node* node = static_cast<Node*>(memory);
+        node->~Node();
+        ::operator delete(memory);
+    }
+
+    bool find(const T& value, Link** preds, Node** succs);
+
+    // The owner count is an acq_rel RMW, so the last owner sees every link
+    // and mark the other one made before letting go. Its search then
+    // unlinks the node from every level it reached, which a plain recheck
+    // of the bottom mark can not promise: the link CAS and the mark CAS are
+    // on different words and either side may read the other's old value.
+    void release(Node* node)
+    {
+        if (node->m_owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        Link* preds[MAX_HEIGHT];
+        Node* succs[MAX_HEIGHT];
+        find(node->m_value, preds, succs);
+        EpochReclamation::retire(node, destroy);
+    }
+
+    // First unmarked node not less than value, without unlinking anything.
+    Node* lower_bound_node(const T& value);
+
+public:
+    ConcurrentSkipList(Compare compare = Compare())
+        : m_compare(compare)
+    {
+        for (int level = 0; level < MAX_HEIGHT; level++)
+            m_head[level].store(0, std::memory_order_relaxed);
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+    ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+    // No other thread may be using the list.
+    ~ConcurrentSkipList()
+    {
+        Node* curr = pointer(m_head[0].load(std::memory_order_relaxed));
+        while (curr != nullptr) {
+            Node* next = pointer(curr->next()[0].load(std::memory_order_relaxed));
+            destroy(curr);
+            curr = next;
+        }
+    }
+
+    // Returns whether value was not in the list yet.
+    bool insert(const T& value);
+    // Returns whether this call removed value.
+    bool remove(const T& value);
+    bool contains(const T& value);
+
+    // Calls fn(value) for every value in [low, high), in order. Values
+    // inserted or removed meanwhile may or may not be seen.
+    template <typename Fn>
+    void for_range(const T& low, const T& high, Fn&& fn);
+
+    // Walks the bottom level, only a snapshot while other threads are
+    // running.
+    size_t size();
+};
+
+// Fills preds with the links of the last node before value on every level
+// and succs with the node after it, unlinking marked nodes on the way.
+// Starts over when a predecessor turns out to be marked itself.
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::find(const T& value, Link** preds, Node** succs)
+{
+retry:
+    Link* links = m_head;
+    for (int level = MAX_HEIGHT - 1; level >= 0; level--) {
+        Node* curr = pointer(links[level].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            uintptr_t next = curr->next()[level].load(std::memory_order_acquire);
+            if (marked(next)) {
+                uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+                if (!links[level].compare_exchange_strong(expected, next & ~uintptr_t(1), std::memory_order_acq_rel, std::memory_order_relaxed))
+                    goto retry;
+                curr = pointer(next);
+                continue;
+            }
+            if (!m_compare(curr->m_value, value))
+                break;
+            links = curr->next();
+            curr = pointer(next);
+        }
+        preds[level] = links;
+        succs[level] = curr;
+    }
+    return succs[0] != nullptr && !m_compare(value, succs[0]->m_value);
+}
+
+template <typename T, typename Compare>
+auto ConcurrentSkipList<T, Compare>::lower_bound_node(const T& value) -> Node*
+{
+    Link* links = m_head;
+    Node* curr = nullptr;
+    for (int level = MAX_HEIGHT - 1; level >= 0; level--) {
+        curr = pointer(links[level].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            uintptr_t next = curr->next()[level].load(std::memory_order_acquire);
+            if (!marked(next)) {
+                if (!m_compare(curr->m_value, value))
+                    break;
+                links = curr->next();
+            }
+            curr = pointer(next);
+        }
+    }
+    return curr;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::insert(const T& value)
+{
+    EpochReclamation::Guard guard;
+    Link* preds[MAX_HEIGHT];
+    Node* succs[MAX_HEIGHT];
+    int height = random_height();
+    Node* node = nullptr;
+
+    for (;;) {
+        if (find(value, preds, succs)) {
+            if (node != nullptr)
+                destroy(node);
+            return false;
+        }
+        if (node == nullptr)
+            node = make_node(value, height);
+        for (int level = 0; level < height; level++)
+            node->next()[level].store(reinterpret_cast<uintptr_t>(succs[level]), std::memory_order_relaxed);
+        uintptr_t expected = reinterpret_cast<uintptr_t>(succs[0]);
+        if (preds[0][0].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(node), std::memory_order_release, std::memory_order_relaxed))
+            break;
+    }
+
+    // In the set now. Linking the upper levels stops as soon as the node is
+    // being removed.
+    for (int level = 1; level < height; level++) {
+        for (;;) {
+            uintptr_t next = node->next()[level].load(std::memory_order_acquire);
+            uintptr_t succ = reinterpret_cast<uintptr_t>(succs[level]);
+            if (marked(next))
+                goto linked;
+            if (next != succ && !node->next()[level].compare_exchange_strong(next, succ, std::memory_order_acq_rel))
+                goto linked;
+            if (preds[level][level].compare_exchange_strong(succ, reinterpret_cast<uintptr_t>(node), std::memory_order_release, std::memory_order_relaxed))
+                break;
+            find(value, preds, succs);
+            if (succs[0] != node)
+                goto linked;
+        }
+    }
+
+linked:
+    release(node);
+    return true;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::remove(const T& value)
+{
+    EpochReclamation::Guard guard;
+    Link* preds[MAX_HEIGHT];
+    Node* succs[MAX_HEIGHT];
+    if (!find(value, preds, succs))
+        return false;
+
+    Node* node = succs[0];
+    for (int level = node->m_height - 1; level >= 1; level--) {
+        uintptr_t next = node->next()[level].load(std::memory_order_relaxed);
+        while (!marked(next))
+            node->next()[level].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    uintptr_t next = node->next()[0].load(std::memory_order_relaxed);
+    for (;;) {
+        if (marked(next))
+            return false;
+        if (node->next()[0].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+            break;
+    }
+    release(node);
+    return true;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::contains(const T& value)
+{
+    EpochReclamation::Guard guard;
+    Node* node = lower_bound_node(value);
+    return node != nullptr && !m_compare(value, node->m_value);
+}
+
+template <typename T, typename Compare>
+template <typename Fn>
+void ConcurrentSkipList<T, Compare>::for_range(const T& low, const T& high, Fn&& fn)
+{
+    EpochReclamation::Guard guard;
+    for (Node* curr = lower_bound_node(low); curr != nullptr;) {
+        uintptr_t next = curr->next()[0].load(std::memory_order_acquire);
+        if (!marked(next)) {
+            if (!m_compare(curr->m_value, high))
+                break;
+            fn(curr->m_value);
+        }
+        curr = pointer(next);
+    }
+}
+
+template <typename T, typename Compare>
+size_t ConcurrentSkipList<T, Compare>::size()
+{
+    EpochReclamation::Guard guard;
+    size_t size = 0;
+    uintptr_t link = m_head[0].load(std::memory_order_acquire);
+    for (Node* curr = pointer(link); curr != nullptr; curr = pointer(link)) {
+        link = curr->next()[0].load(std::memory_order_acquire);
+        if (!marked(link))
+            size++;
+    }
+    return size;
+}
@@ -0,0 +1,96 @@
+#include "skip-list.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+TEST(SkipList, InsertContainsRemove)
+{
+    SkipList<int> list;
+    EXPECT_TRUE(list.is_empty());
+    EXPECT_FALSE(list.contains(7));
+    EXPECT_FALSE(list.remove(7));
+
+    EXPECT_TRUE(list.insert(7));
+    EXPECT_FALSE(list.insert(7));
+    EXPECT_TRUE(list.insert(3));
+    EXPECT_TRUE(list.insert(11));
+    EXPECT_EQ(list.size(), 3);
+    EXPECT_TRUE(list.contains(3));
+    EXPECT_FALSE(list.contains(5));
+
+    EXPECT_TRUE(list.remove(7));
+    EXPECT_FALSE(list.contains(7));
+    EXPECT_EQ(list.size(), 2);
+}
+
+TEST(SkipList, FrontBack)
+{
+    SkipList<int> list;
+    EXPECT_THROW(list.front(), std::runtime_error);
+    EXPECT_THROW(list.back(), std::runtime_error);
+    for (int value : { 5, 1, 9, 3 })
+        list.insert(value);
+    EXPECT_EQ(list.front(), 1);
+    EXPECT_EQ(list.back(), 9);
+    list.remove(9);
+    list.remove(1);
+    EXPECT_EQ(list.front(), 3);
+    EXPECT_EQ(list.back(), 5);
+}
+
+TEST(SkipList, MatchesStdSet)
+{
+    SkipList<int> list;
+    std::set<int> expected;
+    std::mt19937 random(11);
+    for (int i = 0; i < 100000; i++) {
+        int value = random() % 10000;
+        if (random() % 3 == 0)
+            EXPECT_EQ(list.remove(value), expected.erase(value) == 1);
+        else
+            EXPECT_EQ(list.insert(value), expected.insert(value).second);
+    }
+    ASSERT_EQ(list.size(), expected.size());
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    EXPECT_TRUE(std::equal(std::make_reverse_iterator(list.end()), std::make_reverse_iterator(list.begin()),
+        expected.rbegin(), expected.rend()));
+}
+
+TEST(SkipList, Range)
+{
+    SkipList<int> list;
+    for (int i = 0; i < 100; i += 2)
+        list.insert(i);
+
+    std::vector<int> values;
+    list.for_range(11, 21, [&](int value) { values.push_back(value); });
+    EXPECT_EQ(values, std::vector<int>({ 12, 14, 16, 18, 20 }));
+
+    EXPECT_EQ(*list.lower_bound(13), 14);
+    EXPECT_EQ(*list.lower_bound(14), 14);
+    EXPECT_EQ(list.lower_bound(99), list.end());
+}
+
+TEST(SkipList, CustomCompare)
+{
+    SkipList<std::string, std::greater<std::string>> list;
+    for (const char* word : { "pear", "apple", "fig" })
+        list.insert(word);
+    std::vector<std::string> words(list.begin(), list.end());
+    EXPECT_EQ(words, std::vector<std::string>({ "pear", "fig", "apple" }));
+}
+
+TEST(SkipList, Clear)
+{
+    SkipList<int> list;
+    for (int i = 0; i < 1000; i++)
+        list.insert(i);
+    list.clear();
+    EXPECT_TRUE(list.is_empty());
+    EXPECT_EQ(list.begin(), list.end());
+    list.insert(4);
+    EXPECT_EQ(list.front(), 4);
+    EXPECT_EQ(list.back(), 4);
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// Ordered set kept as a stack of sorted linked lists. The bottom level is a
+// doubly linked list like LinkedList's, every node also appears in the
+// levels above it with probability 1/4 per level, so a search drops down
+// O(log n) levels skipping most of the nodes below. Nodes are one allocation
+// each: the value, the back link and the node's tower of forward links.
+template <typename T, typename Compare = std::less<T>>
+class SkipList {
+public:
+    static constexpr int MAX_HEIGHT = 16;
+
+private:
+    struct Node {
+        T m_value;
+        Node* m_prev;
+        size_t m_height;
+
+        template <typename Value>
+        Node(Value&& value, size_t height)
+            : m_value(std::forward<Value>(value))
+            , m_prev(nullptr)
+            , m_height(height)
+        {
+        }
+
+        // The m_height forward links are allocated right after the node.
+        Node** next() { return reinterpret_cast<Node**>(this + 1); }
+    };
+
+    Node* m_head[MAX_HEIGHT];
+    Node* m_tail;
+    int m_height;
+    size_t m_size;
+    uint64_t m_random;
+    Compare m_compare;
+    [[no_unique_address]] mutable StatsRecorder m_stats;
+
+    bool less(const T& left, const T& right) const
+    {
+        m_stats.comparison();
+        return m_compare(left, right);
+    }
+
+    // Geometric with p = 1/4: two random bits per extra level.
+    int random_height()
+    {
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 7;
+        m_random ^= m_random << 17;
+        int height = 1 + __builtin_ctzll(m_random | (uint64_t(1) << 62)) / 2;
+        return height < MAX_HEIGHT ? height : MAX_HEIGHT;
+    }
+
+    // Forward links of the node before the first one not less than value at
+    // every level, m_head where there is none.
+    void find(const T& value, Node*** preds);
+
+    // First node not less than value, nullptr if there is none.
+    Node* lower_bound_node(const T& value) const;
+
+    template <typename Value>
+    bool insert_value(Value&& value);
+
+    static void destroy(Node* node);
+
+public:
+    SkipList(Compare compare = Compare())
+        : m_tail(nullptr)
+        , m_height(1)
+        , m_size(0)
+        , m_random(0x9e3779b97f4a7c15ULL)
+        , m_compare(compare)
+    {
+        for (int level = 0; level < MAX_HEIGHT; level++)
+            m_head[level] = nullptr;
+    }
+
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+    ~SkipList() { clear(); }
+
+    // Returns whether value was not in the list yet.
+    bool insert(const T& value) { return insert_value(value); }
+    bool insert(T&& value) { return insert_value(std::move(value)); }
+
+    // Returns whether value was in the list.
+    bool remove(const T& value);
+    bool contains(const T& value) const;
+
+    size_t size() const { return m_size; }
+    bool is_empty() const { return m_size == 0; }
+    void clear();
+
+    const T& front() const;
+    const T& back() const;
+
+    // Calls fn(value) for every value in [low, high), in order.
+    template <typename Fn>
+    void for_range(const T& low, const T& high, Fn&& fn) const;
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp. Visits are
+    // nodes looked at while searching.
+    ContainerStats stats() const { return m_stats.stats(); }
+    void reset_stats() { m_stats.reset(); }
+
+    // The back link, height and forward links of every node are overhead.
+    MemoryUsage memory_usage() const;
+
+    struct Iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator(Node* node, const SkipList* list)
+            : m_node(node)
+            , m_list(list)
+        {
+        }
+
+        reference operator*() const { return m_node->m_value; }
+        pointer operator->() const { return &m_node->m_value; }
+
+        Iterator& operator++()
+        {
+            m_node = m_node->next()[0];
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        // Stepping back from end() lands on the last node.
+        Iterator& operator--()
+        {
+            m_node = m_node == nullptr ? m_list->m_tail : m_node->m_prev;
+            return *this;
+        }
+
+        Iterator operator--(int)
+        {
+            Iterator tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_node == b.m_node; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_node != b.m_node; }
+
+    private:
+        Node* m_node;
+        const SkipList* m_list;
+    };
+
+    Iterator begin() const { return Iterator(m_head[0], this); }
+    Iterator end() const { return Iterator(nullptr, this); }
+
+    // First value not less than value.
+    Iterator lower_bound(const T& value) const { return Iterator(lower_bound_node(value), this); }
+};
+
+template <typename T, typename Compare>
+void SkipList<T, Compare>::find(const T& value, Node*** preds)
+{
+    Node** links = m_head;
+    for (int level = m_height - 1; level >= 0; level--) {
+        for (Node* curr = links[level]; curr != nullptr && less(curr->m_value, value); curr = links[level]) {
+            m_stats.visit();
+            links = curr->next();
+        }
+        preds[level] = links;
+    }
+}
+
+template <typename T, typename Compare>
+auto SkipList<T, Compare>::lower_bound_node(const T& value) const -> Node*
+{
+    Node* const* links = m_head;
+    Node* curr = nullptr;
+    for (int level = m_height - 1; level >= 0; level--) {
+        for (curr = links[level]; curr != nullptr && less(curr->m_value, value); curr = links[level]) {
+            m_stats.visit();
+            links = curr->next();
+        }
+    }
+    return curr;
+}
+
+template <typename T, typename Compare>
+template <typename Value>
+bool SkipList<T, Compare>::insert_value(Value&& value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    Node** preds[MAX_HEIGHT] {};
+    find(value, preds);
+    Node* next = preds[0][0];
+    if (next != nullptr && !less(value, next->m_value))
+        return false;
+
+    int height = random_height();
+    for (; m_height < height; m_height++)
+        preds[m_height] = m_head;
+
+    void* memory = ::operator new(sizeof(Node) + height * sizeof(Node*));
+    m_stats.allocation();
+    Node* node = ::new (memory) Node(std::forward<Value>(value), height);
+    for (int level = 0; level < height; level++) {
+        node->next()[level] = preds[level][level];
+        preds[level][level] = node;
+    }
+
+    // preds[0] is the head or the forward links of the node before.
+    if (preds[0] != m_head)
+        node->m_prev = reinterpret_cast<Node*>(preds[0]) - 1;
+    if (next != nullptr)
+        next->m_prev = node;
+    else
+        m_tail = node;
+    m_size++;
+    return true;
+}
+
+template <typename T, typename Compare>
+bool SkipList<T, Compare>::remove(const T& value)
+{
+    auto timer = m_stats.time(Operation::Remove);
+    Node** preds[MAX_HEIGHT] {};
+    find(value, preds);
+    Node* node = preds[0][0];
+    if (node == nullptr || less(value, node->m_value))
+        return false;
+
+    for (size_t level = 0; level < node->m_height; level++)
+        preds[level][level] = node->next()[level];
+    Node* next = node->next()[0];
+    if (next != nullptr)
+        next->m_prev = node->m_prev;
+    else
+        m_tail = node->m_prev;
+    while (m_height > 1 && m_head[m_height - 1] == nullptr)
+        m_height--;
+
+    destroy(node);
+    m_stats.deallocation();
+    m_size--;
+    return true;
+}
+
+template <typename T, typename Compare>
+bool SkipList<T, Compare>::contains(const T& value) const
+{
+    auto timer = m_stats.time(Operation::Lookup);
+    Node* node = lower_bound_node(value);
+    return node != nullptr && !less(value, node->m_value);
+}
+
+template <typename T, typename Compare>
+void SkipList<T, Compare>::destroy(Node* node)
+{
+    node->~Node();
+    ::operator delete(node);
+}
+
+template <typename T, typename Compare>
+void SkipList<T, Compare>::clear()
+{
+    Node* curr = m_head[0];
+    while (curr != nullptr) {
+        Node* next = curr->next()[0];
+        destroy(curr);
+        m_stats.deallocation();
+        curr = next;
+    }
+    for (int level = 0; level < MAX_HEIGHT; level++)
+        m_head[level] = nullptr;
+    m_tail = nullptr;
+    m_height = 1;
+    m_size = 0;
+}
+
+template <typename T, typename Compare>
+const T& SkipList<T, Compare>::front() const
+{
+    if (m_head[0] == nullptr)
+        throw std::runtime_error("front of an empty skip list");
+    return m_head[0]->m_value;
+}
+
+template <typename T, typename Compare>
+const T& SkipList<T, Compare>::back() const
+{
+    if (m_tail == nullptr)
+        throw std::runtime_error("back of an empty skip list");
+    return m_tail->m_value;
+}
+
+template <typename T, typename Compare>
+template <typename Fn>
+void SkipList<T, Compare>::for_range(const T& low, const T& high, Fn&& fn) const
+{
+    for (Node* curr = lower_bound_node(low); curr != nullptr && less(curr->m_value, high); curr = curr->next()[0])
+        fn(curr->m_value);
+}
+
+// Walks the bottom level, the tower heights decide the link overhead.
+template <typename T, typename Compare>
+MemoryUsage SkipList<T, Compare>::memory_usage() const
+{
+    MemoryUsage usage;
+    usage.m_elements = m_size;
+    usage.m_payload = m_size * sizeof(T);
+    usage.m_overhead = sizeof(*this);
+    for (Node* curr = m_head[0]; curr != nullptr; curr = curr->next()[0]) {
+        uint64_t bytes = sizeof(Node) + curr->m_height * sizeof(Node*);
+        usage.m_overhead += bytes - sizeof(T);
+        usage.allocations(bytes);
+    }
+    return usage;
+}
@@ -0,0 +1,484 @@
+#include "../linked-list/linked-list.hpp"
+#include "coo-builder.hpp"
+#include "csr-matrix.hpp"
+#include "csr-ops.hpp"
+#include "matrix-io.hpp"
+#include "spmv.hpp"
+#include "sparse-matrix.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Square matrix with state.range(0) lines and state.range(1) nonzeros per
+// line, then lookups and updates at random (line, col) pairs, half of
+// which hit a nonzero.
+static const unsigned int lines = 1024;
+
+struct Access {
+    unsigned int m_line;
+    unsigned int m_col;
+};
+
+static std::vector<Access> accesses(unsigned int per_line, unsigned int count)
+{
+    std::vector<Access> accesses(count);
+    std::mt19937 random(42);
+    for (auto& access : accesses) {
+        access.m_line = random() % lines;
+        access.m_col = random() % (per_line * 2);
+    }
+    return accesses;
+}
+
+// The old layout: one LinkedList per line, scanned linearly.
+template <typename T>
+class ListRows {
+    struct Entry {
+        T m_value;
+        unsigned int m_col;
+    };
+    std::vector<LinkedList<Entry>> m_rows;
+
+public:
+    ListRows(unsigned int lines)
+        : m_rows(lines)
+    {
+    }
+
+    void insert(unsigned int line, unsigned int col, T value)
+    {
+        for (auto& node : m_rows[line]) {
+            if (node.m_value.m_col == col) {
+                node.m_value.m_value = value;
+                return;
+            }
+        }
+        m_rows[line].push_front({ value, col });
+    }
+
+    T get(unsigned int line, unsigned int col)
+    {
+        for (auto& node : m_rows[line]) {
+            if (node.m_value.m_col == col)
+                return node.m_value.m_value;
+        }
+        return T {};
+    }
+};
+
+template <typename Matrix>
+static void fill(Matrix& matrix, unsigned int per_line)
+{
+    for (unsigned int line = 0; line < lines; line++) {
+        for (unsigned int col = 0; col < per_line * 2; col += 2)
+            matrix.insert(line, col, int(line + col + 1));
+    }
+}
+
+template <typename Matrix>
+static void random_get(benchmark::State& state, Matrix& matrix)
+{
+    std::vector<Access> pattern = accesses(state.range(0), 1 << 16);
+    for (auto _ : state) {
+        for (auto& access : pattern)
+            benchmark::DoNotOptimize(matrix.get(access.m_line, access.m_col));
+    }
+    state.SetItemsProcessed(state.iterations() * pattern.size());
+}
+
+template <typename Matrix>
+static void random_insert(benchmark::State& state, Matrix& matrix)
+{
+    fill(matrix, state.range(0));
+    std::vector<Access> pattern = accesses(state.range(0), 1 << 16);
+    int value = 1;
+    for (auto _ : state) {
+        for (auto& access : pattern)
+            matrix.insert(access.m_line, access.m_col, value);
+        value++;
+    }
+    state.SetItemsProcessed(state.iterations() * pattern.size());
+}
+
+static void BM_HashGet(benchmark::State& state)
+{
+    SparceMatrix<int> matrix(0, lines);
+    fill(matrix, state.range(0));
+    random_get(state, matrix);
+}
+BENCHMARK(BM_HashGet)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_ListGet(benchmark::State& state)
+{
+    ListRows<int> matrix(lines);
+    fill(matrix, state.range(0));
+    random_get(state, matrix);
+}
+BENCHMARK(BM_ListGet)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_CsrGet(benchmark::State& state)
+{
+    SparceMatrix<int> matrix(0, lines, state.range(0) * 2);
+    fill(matrix, state.range(0));
+    CSRMatrix<int> csr = to_csr(matrix);
+    random_get(state, csr);
+}
+BENCHMARK(BM_CsrGet)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_HashInsert(benchmark::State& state)
+{
+    SparceMatrix<int> matrix(0, lines);
+    random_insert(state, matrix);
+}
+BENCHMARK(BM_HashInsert)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_ListInsert(benchmark::State& state)
+{
+    ListRows<int> matrix(lines);
+    random_insert(state, matrix);
+}
+BENCHMARK(BM_ListInsert)->RangeMultiplier(4)->Range(4, 1024);
+
+// Same workload on std::unordered_map keyed by the packed pair.
+static void BM_StdUnorderedMapGet(benchmark::State& state)
+{
+    std::unordered_map<uint64_t, int> matrix;
+    for (unsigned int line = 0; line < lines; line++) {
+        for (unsigned int col = 0; col < state.range(0) * 2; col += 2)
+            matrix[(uint64_t(line) << 32) | col] = line + col + 1;
+    }
+    std::vector<Access> pattern = accesses(state.range(0), 1 << 16);
+    for (auto _ : state) {
+        for (auto& access : pattern) {
+            auto it = matrix.find((uint64_t(access.m_line) << 32) | access.m_col);
+            benchmark::DoNotOptimize(it == matrix.end() ? 0 : it->second);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * pattern.size());
+}
+BENCHMARK(BM_StdUnorderedMapGet)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_ToCsr(benchmark::State& state)
+{
+    SparceMatrix<int> matrix(0, lines, state.range(0) * 2);
+    fill(matrix, state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(to_csr(matrix).nonzeros());
+    state.SetItemsProcessed(state.iterations() * matrix.nonzeros());
+}
+BENCHMARK(BM_ToCsr)->RangeMultiplier(4)->Range(4, 1024);
+
+// SpMV on a square matrix with state.range(0) lines and 16 random columns
+// per line, built straight into CSR so the hash table never holds 10M+
+// entries. The byte count is the least the kernel must move: values and
+// indices once, row pointers, x and y.
+static CSRMatrix<double> random_csr(unsigned int size, unsigned int per_line)
+{
+    std::mt19937 random(42);
+    std::vector<uint64_t> pointers(size + 1);
+    std::vector<unsigned int> indices(uint64_t(size) * per_line);
+    std::vector<double> values(indices.size());
+    for (unsigned int line = 0; line < size; line++) {
+        pointers[line + 1] = pointers[line] + per_line;
+        auto begin = indices.begin() + pointers[line];
+        for (unsigned int i = 0; i < per_line; i++)
+            begin[i] = random() % size;
+        std::sort(begin, begin + per_line);
+    }
+    for (auto& value : values)
+        value = double(random() % 100) / 10;
+    return { 0.0, size, size, std::move(pointers), std::move(indices), std::move(values) };
+}
+
+static void spmv_counters(benchmark::State& state, uint64_t nonzeros, uint64_t size)
+{
+    state.counters["flops"] = benchmark::Counter(2.0 * nonzeros, benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(state.iterations()
+        * (nonzeros * (sizeof(double) + sizeof(unsigned int)) + (size + 1) * sizeof(uint64_t) + 2 * size * sizeof(double)));
+}
+
+static void BM_SpmvScalar(benchmark::State& state)
+{
+    CSRMatrix<double> matrix = random_csr(state.range(0), 16);
+    std::vector<double> x(matrix.cols(), 1.0), y(matrix.lines());
+    for (auto _ : state) {
+        spmv_rows_scalar(matrix.pointers().data(), matrix.indices().data(), matrix.values().data(),
+            x.data(), y.data(), 0, matrix.lines());
+        benchmark::ClobberMemory();
+    }
+    spmv_counters(state, matrix.nonzeros(), matrix.lines());
+}
+BENCHMARK(BM_SpmvScalar)->RangeMultiplier(8)->Range(1 << 12, 1 << 21)->Unit(benchmark::kMillisecond);
+
+static void BM_Spmv(benchmark::State& state)
+{
+    CSRMatrix<double> matrix = random_csr(state.range(0), 16);
+    std::vector<double> x(matrix.cols(), 1.0), y(matrix.lines());
+    for (auto _ : state) {
+        spmv(matrix, x.data(), y.data());
+        benchmark::ClobberMemory();
+    }
+    spmv_counters(state, matrix.nonzeros(), matrix.lines());
+}
+BENCHMARK(BM_Spmv)->RangeMultiplier(8)->Range(1 << 12, 1 << 21)->Unit(benchmark::kMillisecond);
+
+// Pool sizes 1, 2, 4, ... up to the core count on the 32M nonzero matrix.
+static void BM_SpmvParallel(benchmark::State& state)
+{
+    static CSRMatrix<double> matrix = random_csr(1 << 21, 16);
+    ThreadPool pool(state.range(0));
+    std::vector<double> x(matrix.cols(), 1.0), y(matrix.lines());
+    for (auto _ : state) {
+        spmv(pool, matrix, x.data(), y.data());
+        benchmark::ClobberMemory();
+    }
+    spmv_counters(state, matrix.nonzeros(), matrix.lines());
+}
+BENCHMARK(BM_SpmvParallel)->Apply([](benchmark::internal::Benchmark* bench) {
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads < cores; threads *= 2)
+        bench->Arg(threads);
+    bench->Arg(cores);
+})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// The naive loop over the hash table, as SparceMatrix offered nothing better.
+static void BM_SpmvNaive(benchmark::State& state)
+{
+    CSRMatrix<double> csr = random_csr(state.range(0), 16);
+    SparceMatrix<double> matrix = to_sparce(csr);
+    std::vector<double> x(matrix.cols(), 1.0), y(matrix.lines());
+    for (auto _ : state) {
+        std::fill(y.begin(), y.end(), 0.0);
+        matrix.for_each([&](unsigned int line, unsigned int col, double value) {
+            y[line] += value * x[col];
+        });
+        benchmark::ClobberMemory();
+    }
+    spmv_counters(state, matrix.nonzeros(), matrix.lines());
+}
+BENCHMARK(BM_SpmvNaive)->RangeMultiplier(8)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+// Graph adjacency matrices with 1<<14 vertices and state.range(0) edges per
+// vertex on average. Uniform picks both ends at random, R-MAT recursively
+// picks a quadrant with probabilities 0.57, 0.19, 0.19, 0.05, giving the
+// skewed degrees of real graphs.
+static const unsigned int vertices = 1 << 14;
+
+static CSRMatrix<double> uniform_graph(unsigned int degree)
+{
+    SparceMatrix<double> matrix(0.0, vertices, vertices);
+    std::mt19937 random(42);
+    for (uint64_t i = 0; i < uint64_t(vertices) * degree; i++)
+        matrix.insert(random() % vertices, random() % vertices, 1.0);
+    return to_csr(matrix);
+}
+
+static CSRMatrix<double> rmat_graph(unsigned int degree)
+{
+    SparceMatrix<double> matrix(0.0, vertices, vertices);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> uniform;
+    for (uint64_t i = 0; i < uint64_t(vertices) * degree; i++) {
+        unsigned int line = 0, col = 0;
+        for (unsigned int bit = vertices >> 1; bit > 0; bit >>= 1) {
+            double p = uniform(random);
+            if (p >= 0.57 + 0.19 + 0.19) {
+                line |= bit;
+                col |= bit;
+            } else if (p >= 0.57 + 0.19) {
+                line |= bit;
+            } else if (p >= 0.57) {
+                col |= bit;
+            }
+        }
+        matrix.insert(line, col, 1.0);
+    }
+    return to_csr(matrix);
+}
+
+template <CSRMatrix<double> (*Graph)(unsigned int)>
+static void BM_Square(benchmark::State& state)
+{
+    CSRMatrix<double> a = Graph(state.range(0));
+    uint64_t multiplies = 0;
+    for (unsigned int line = 0; line < a.lines(); line++) {
+        for (uint64_t k = a.pointers()[line]; k < a.pointers()[line + 1]; k++)
+            multiplies += a.pointers()[a.indices()[k] + 1] - a.pointers()[a.indices()[k]];
+    }
+    ThreadPool pool;
+    uint64_t nonzeros = 0;
+    for (auto _ : state)
+        nonzeros = multiply(pool, a, a).nonzeros();
+    state.counters["flops"] = benchmark::Counter(2.0 * multiplies, benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["nnz_in"] = a.nonzeros();
+    state.counters["nnz_out"] = nonzeros;
+}
+BENCHMARK(BM_Square<uniform_graph>)->RangeMultiplier(4)->Range(2, 32)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Square<rmat_graph>)->RangeMultiplier(4)->Range(2, 32)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// A + A^T, the symmetrized graph.
+template <CSRMatrix<double> (*Graph)(unsigned int)>
+static void BM_Symmetrize(benchmark::State& state)
+{
+    CSRMatrix<double> a = Graph(state.range(0));
+    ThreadPool pool;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(add(pool, a, transpose(pool, a)).nonzeros());
+    state.SetItemsProcessed(state.iterations() * a.nonzeros());
+}
+BENCHMARK(BM_Symmetrize<uniform_graph>)->RangeMultiplier(4)->Range(2, 32)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Symmetrize<rmat_graph>)->RangeMultiplier(4)->Range(2, 32)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+template <CSRMatrix<double> (*Graph)(unsigned int)>
+static void BM_Transpose(benchmark::State& state)
+{
+    CSRMatrix<double> a = Graph(state.range(0));
+    ThreadPool pool;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(transpose(pool, a).nonzeros());
+    state.SetItemsProcessed(state.iterations() * a.nonzeros());
+}
+BENCHMARK(BM_Transpose<uniform_graph>)->RangeMultiplier(4)->Range(2, 32)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Transpose<rmat_graph>)->RangeMultiplier(4)->Range(2, 32)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Loading an 8M nonzero matrix, 512K lines of 16, written once to /tmp as
+// Matrix Market text and as binary CSR. The page cache is warm for all of
+// them, so this is parsing and building cost, not disk.
+static const std::string market_path = "/tmp/sparse-matrix-bench.mtx";
+static const std::string binary_path = "/tmp/sparse-matrix-bench.csr";
+
+static uint64_t write_bench_files()
+{
+    static uint64_t nonzeros = 0;
+    if (nonzeros != 0)
+        return nonzeros;
+    CSRMatrix<double> matrix = random_csr(1 << 19, 16);
+    std::ofstream market(market_path);
+    market << "%%MatrixMarket matrix coordinate real general\n"
+           << matrix.lines() << " " << matrix.cols() << " " << matrix.nonzeros() << "\n";
+    for (unsigned int line = 0; line < matrix.lines(); line++) {
+        for (uint64_t k = matrix.pointers()[line]; k < matrix.pointers()[line + 1]; k++)
+            market << line + 1 << " " << matrix.indices()[k] + 1 << " " << matrix.values()[k] << "\n";
+    }
+    write_binary(matrix, binary_path);
+    nonzeros = matrix.nonzeros();
+    return nonzeros;
+}
+
+// The old way: stream parsing and one SparceMatrix::insert per entry.
+static void BM_LoadInsert(benchmark::State& state)
+{
+    uint64_t nonzeros = write_bench_files();
+    for (auto _ : state) {
+        std::ifstream file(market_path);
+        std::string banner;
+        std::getline(file, banner);
+        unsigned int lines, cols, line, col;
+        uint64_t entries;
+        double value;
+        file >> lines >> cols >> entries;
+        SparceMatrix<double> matrix(0.0, lines, cols);
+        while (file >> line >> col >> value)
+            matrix.insert(line - 1, col - 1, value);
+        benchmark::DoNotOptimize(matrix.nonzeros());
+    }
+    state.SetItemsProcessed(state.iterations() * nonzeros);
+}
+BENCHMARK(BM_LoadInsert)->Unit(benchmark::kMillisecond)->Iterations(1);
+
+static void BM_LoadMatrixMarket(benchmark::State& state)
+{
+    uint64_t nonzeros = write_bench_files();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(read_matrix_market<double>(market_path).nonzeros());
+    state.SetItemsProcessed(state.iterations() * nonzeros);
+}
+BENCHMARK(BM_LoadMatrixMarket)->Unit(benchmark::kMillisecond);
+
+// Mapping alone is O(1), so this maps and runs one SpMV to touch every page.
+static void BM_MapBinarySpmv(benchmark::State& state)
+{
+    uint64_t nonzeros = write_bench_files();
+    std::vector<double> x(1 << 19, 1.0), y(1 << 19);
+    for (auto _ : state) {
+        MappedCSR<double> mapped(binary_path);
+        spmv(mapped.view(), x.data(), y.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * nonzeros);
+}
+BENCHMARK(BM_MapBinarySpmv)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadBinary(benchmark::State& state)
+{
+    uint64_t nonzeros = write_bench_files();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MappedCSR<double>(binary_path).load().nonzeros());
+    state.SetItemsProcessed(state.iterations() * nonzeros);
+}
+BENCHMARK(BM_LoadBinary)->Unit(benchmark::kMillisecond);
+
+// Building from state.range(0) random triples on a 1M x 1M matrix, about
+// 1% of them duplicates.
+struct Triple {
+    unsigned int m_line;
+    unsigned int m_col;
+    double m_value;
+};
+
+static std::vector<Triple> triples(uint64_t count)
+{
+    std::vector<Triple> triples(count);
+    std::mt19937 random(42);
+    for (auto& triple : triples)
+        triple = { unsigned(random() % (1 << 20)), unsigned(random() % (1 << 20)), double(random() % 100 + 1) };
+    for (uint64_t i = 0; i < count / 100; i++)
+        triples[random() % count] = triples[random() % count];
+    return triples;
+}
+
+static void BM_BuildInsert(benchmark::State& state)
+{
+    std::vector<Triple> input = triples(state.range(0));
+    for (auto _ : state) {
+        SparceMatrix<double> matrix(0.0, 1 << 20, 1 << 20);
+        for (auto& triple : input)
+            matrix.insert(triple.m_line, triple.m_col, triple.m_value);
+        benchmark::DoNotOptimize(to_csr(matrix).nonzeros());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_BuildInsert)->RangeMultiplier(8)->Range(1 << 17, 1 << 23)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildCOO(benchmark::State& state)
+{
+    std::vector<Triple> input = triples(state.range(0));
+    for (auto _ : state) {
+        COOBuilder<double> builder(0.0, 1 << 20, 1 << 20);
+        builder.reserve(input.size());
+        for (auto& triple : input)
+            builder.add(triple.m_line, triple.m_col, triple.m_value);
+        benchmark::DoNotOptimize(builder.build_csr().nonzeros());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_BuildCOO)->RangeMultiplier(8)->Range(1 << 17, 1 << 23)->Unit(benchmark::kMillisecond);
+
+// std::sort of the packed keys alone, the floor a comparison sort gives.
+static void BM_BuildStdSort(benchmark::State& state)
+{
+    std::vector<Triple> input = triples(state.range(0));
+    for (auto _ : state) {
+        std::vector<std::pair<uint64_t, double>> pairs(input.size());
+        for (size_t i = 0; i < input.size(); i++)
+            pairs[i] = { (uint64_t(input[i].m_line) << 20) | input[i].m_col, input[i].m_value };
+        std::stable_sort(pairs.begin(), pairs.end(),
+            [](const auto& left, const auto& right) { return left.first < right.first; });
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_BuildStdSort)->RangeMultiplier(8)->Range(1 << 17, 1 << 23)->Unit(benchmark::kMillisecond);
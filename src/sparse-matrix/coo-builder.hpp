@@ -0,0 +1,319 @@
+#pragma once
+#include "../thread-pool/thread-pool.hpp"
+#include "csr-matrix.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Runs fn(part, begin, end) over parts equal slices of [0, count).
+template <typename Fn>
+void for_each_chunk(ThreadPool* pool, uint64_t count, unsigned int parts, Fn&& fn)
+{
+    auto run = [&](int64_t first, int64_t last) {
+        for (int64_t part = first; part < last; part++)
+            fn(part, count * part / parts, count * (part + 1) / parts);
+    };
+    if (pool == nullptr)
+        run(0, parts);
+    else
+        pool->parallel_for(0, parts, 1, run);
+}
+
+// A coordinate packed into its key, with the value next to it so the sort
+// scatters one stream per bucket instead of two.
+template <typename T>
+struct COOEntry {
+    uint64_t m_key;
+    T m_value;
+};
+
+// Stable LSD radix sort on the low bits of the keys, 11 bits per pass. Every
+// part histograms its own slice, the offsets are laid out digit major over
+// the parts, and each part scatters its slice in order, which keeps the sort
+// stable. Passes whose digit is the same for every key are skipped.
+template <typename T>
+void radix_sort_entries(ThreadPool* pool, std::vector<COOEntry<T>>& entries, unsigned int bits)
+{
+    static constexpr unsigned int digit_bits = 11;
+    static constexpr uint64_t digits = 1 << digit_bits;
+    unsigned int parts = pool == nullptr ? 1 : pool->size();
+    std::vector<COOEntry<T>> scratch(entries.size());
+    std::vector<uint64_t> offsets(parts * digits);
+
+    for (unsigned int shift = 0; shift < bits; shift += digit_bits) {
+        for_each_chunk(pool, entries.size(), parts, [&](unsigned int part, uint64_t begin, uint64_t end) {
+            uint64_t* counts = offsets.data() + part * digits;
+            std::fill(counts, counts + digits, 0);
+            for (uint64_t i = begin; i < end; i++)
+                counts[(entries[i].m_key >> shift) & (digits - 1)]++;
+        });
+
+        uint64_t total = 0;
+        bool trivial = false;
+        for (uint64_t digit = 0; digit < digits; digit++) {
+            uint64_t count = 0;
+            for (unsigned int part = 0; part < parts; part++) {
+                uint64_t part_count = offsets[part * digits + digit];
+                offsets[part * digits + digit] = total;
+                total += part_count;
+                count += part_count;
+            }
+            trivial = trivial || count == entries.size();
+        }
+        if (trivial)
+            continue;
+
+        for_each_chunk(pool, entries.size(), parts, [&](unsigned int part, uint64_t begin, uint64_t end) {
+            uint64_t* next = offsets.data() + part * digits;
+            for (uint64_t i = begin; i < end; i++)
+                scratch[next[(entries[i].m_key >> shift) & (digits - 1)]++] = std::move(entries[i]);
+        });
+        entries.swap(scratch);
+    }
+}
+
+// N dimensional sparse tensor stored as sorted coordinates. The coordinates
+// are packed into one 64 bit key, each dimension in just enough bits for its
+// extent and the first dimension highest, so key order is lexicographic
+// coordinate order.
+template <typename T, size_t N>
+class SparseTensor {
+private:
+    T m_baseValue;
+    std::array<unsigned int, N> m_shape;
+    std::array<unsigned int, N> m_shifts;
+    std::vector<uint64_t> m_keys;
+    std::vector<T> m_values;
+
+public:
+    SparseTensor(T baseValue, std::array<unsigned int, N> shape)
+        : m_baseValue(baseValue)
+        , m_shape(shape)
+    {
+        unsigned int bits = 0;
+        for (size_t d = N; d-- > 0;) {
+            m_shifts[d] = bits;
+            bits += std::bit_width(std::max(shape[d], 1u) - 1);
+        }
+        if (bits > 64)
+            throw std::invalid_argument("tensor shape does not fit a 64 bit key");
+    }
+
+    auto shape() const -> const std::array<unsigned int, N>& { return m_shape; }
+    auto nonzeros() const -> uint64_t { return m_values.size(); }
+    auto base_value() const -> T { return m_baseValue; }
+    auto key_bits() const -> unsigned int
+    {
+        return m_shifts[0] + std::bit_width(std::max(m_shape[0], 1u) - 1);
+    }
+
+    auto keys() const -> const std::vector<uint64_t>& { return m_keys; }
+    auto values() const -> const std::vector<T>& { return m_values; }
+
+    auto key(const std::array<unsigned int, N>& coords) const -> uint64_t
+    {
+        uint64_t key = 0;
+        for (size_t d = 0; d < N; d++) {
+            if (coords[d] >= m_shape[d])
+                throw std::invalid_argument("index out of bounds");
+            key |= uint64_t(coords[d]) << m_shifts[d];
+        }
+        return key;
+    }
+
+    auto coords(uint64_t key) const -> std::array<unsigned int, N>
+    {
+        std::array<unsigned int, N> coords;
+        for (size_t d = 0; d < N; d++) {
+            unsigned int width = (d == 0 ? 64 : m_shifts[d - 1]) - m_shifts[d];
+            coords[d] = (key >> m_shifts[d]) & (width >= 32 ? ~0u : (1u << width) - 1);
+        }
+        return coords;
+    }
+
+    // One packed key per value, no pointers.
+    auto memory_usage() const -> MemoryUsage
+    {
+        MemoryUsage usage;
+        usage.m_elements = nonzeros();
+        usage.m_payload = m_values.size() * sizeof(T);
+        usage.m_overhead = m_keys.size() * sizeof(uint64_t) + sizeof(*this);
+        usage.m_slack = vector_slack(m_keys) + vector_slack(m_values);
+        return usage;
+    }
+
+    auto get(const std::array<unsigned int, N>& coords) const -> T
+    {
+        uint64_t target = key(coords);
+        auto it = std::lower_bound(m_keys.begin(), m_keys.end(), target);
+        if (it == m_keys.end() || *it != target)
+            return m_baseValue;
+        return m_values[it - m_keys.begin()];
+    }
+
+    // Calls fn(coords, value) in coordinate order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (size_t i = 0; i < m_keys.size(); i++)
+            fn(coords(m_keys[i]), m_values[i]);
+    }
+
+    // Takes keys sorted and unique, as COOBuilder produces them.
+    void assign(std::vector<uint64_t> keys, std::vector<T> values)
+    {
+        m_keys = std::move(keys);
+        m_values = std::move(values);
+    }
+
+    // Moves the values out for a conversion that drops the tensor, which is
+    // left empty.
+    auto take_values() -> std::vector<T>
+    {
+        m_keys.clear();
+        return std::move(m_values);
+    }
+};
+
+// Collects coordinate triples, or N-tuples, in any order and builds the
+// compressed form in one go: a parallel radix sort on the packed keys, then
+// a parallel pass dropping duplicates. As with SparceMatrix::insert the
+// last value added for a coordinate wins, and a base value erases it.
+template <typename T, size_t N = 2>
+class COOBuilder {
+private:
+    SparseTensor<T, N> m_tensor;
+    std::vector<COOEntry<T>> m_entries;
+
+public:
+    COOBuilder(T baseValue, std::array<unsigned int, N> shape)
+        : m_tensor(baseValue, shape)
+    {
+    }
+
+    COOBuilder(T baseValue, unsigned int lines, unsigned int cols)
+        requires(N == 2)
+        : m_tensor(baseValue, { lines, cols })
+    {
+    }
+
+    void reserve(uint64_t count)
+    {
+        m_entries.reserve(count);
+    }
+
+    auto size() const -> uint64_t { return m_entries.size(); }
+
+    void add(const std::array<unsigned int, N>& coords, T value)
+    {
+        m_entries.push_back({ m_tensor.key(coords), value });
+    }
+
+    void add(unsigned int line, unsigned int col, T value)
+        requires(N == 2)
+    {
+        add({ line, col }, value);
+    }
+
+    // Consumes the added entries.
+    auto build(ThreadPool* pool = nullptr) -> SparseTensor<T, N>
+    {
+        radix_sort_entries(pool, m_entries, m_tensor.key_bits());
+
+        // An entry survives when the next one has another key and it is not
+        // the base value. Count per part, then compact into place.
+        unsigned int parts = pool == nullptr ? 1 : pool->size();
+        T base = m_tensor.base_value();
+        auto kept = [&](uint64_t i) {
+            return (i + 1 == m_entries.size() || m_entries[i + 1].m_key != m_entries[i].m_key)
+                && !(m_entries[i].m_value == base);
+        };
+        std::vector<uint64_t> offsets(parts + 1, 0);
+        for_each_chunk(pool, m_entries.size(), parts, [&](unsigned int part, uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++)
+                offsets[part + 1] += kept(i);
+        });
+        for (unsigned int part = 0; part < parts; part++)
+            offsets[part + 1] += offsets[part];
+
+        std::vector<uint64_t> keys(offsets[parts]);
+        std::vector<T> values(offsets[parts]);
+        for_each_chunk(pool, m_entries.size(), parts, [&](unsigned int part, uint64_t begin, uint64_t end) {
+            uint64_t dest = offsets[part];
+            for (uint64_t i = begin; i < end; i++) {
+                if (kept(i)) {
+                    keys[dest] = m_entries[i].m_key;
+                    values[dest++] = std::move(m_entries[i].m_value);
+                }
+            }
+        });
+
+        m_entries.clear();
+        SparseTensor<T, N> tensor = m_tensor;
+        tensor.assign(std::move(keys), std::move(values));
+        return tensor;
+    }
+
+    auto build(ThreadPool& pool) -> SparseTensor<T, N>
+    {
+        return build(&pool);
+    }
+
+    auto build_csr(ThreadPool* pool = nullptr) -> CSRMatrix<T>
+        requires(N == 2)
+    {
+        return to_csr(build(pool));
+    }
+
+    auto build_csr(ThreadPool& pool) -> CSRMatrix<T>
+        requires(N == 2)
+    {
+        return build_csr(&pool);
+    }
+};
+
+namespace detail {
+
+// Keys are already in line major order, only the line starts are needed.
+template <typename T>
+void csr_structure(const SparseTensor<T, 2>& tensor, std::vector<uint64_t>& pointers, std::vector<unsigned int>& indices)
+{
+    unsigned int lines = tensor.shape()[0];
+    pointers.assign(uint64_t(lines) + 1, 0);
+    indices.resize(tensor.nonzeros());
+    for (uint64_t i = 0; i < tensor.nonzeros(); i++) {
+        auto coords = tensor.coords(tensor.keys()[i]);
+        pointers[coords[0] + 1]++;
+        indices[i] = coords[1];
+    }
+    for (unsigned int line = 0; line < lines; line++)
+        pointers[line + 1] += pointers[line];
+}
+
+}
+
+template <typename T>
+auto to_csr(const SparseTensor<T, 2>& tensor) -> CSRMatrix<T>
+{
+    std::vector<uint64_t> pointers;
+    std::vector<unsigned int> indices;
+    detail::csr_structure(tensor, pointers, indices);
+    return { tensor.base_value(), tensor.shape()[0], tensor.shape()[1], std::move(pointers), std::move(indices),
+        tensor.values() };
+}
+
+// Takes the values over instead of copying them, build_csr() converts the
+// tensor it just built this way.
+template <typename T>
+auto to_csr(SparseTensor<T, 2>&& tensor) -> CSRMatrix<T>
+{
+    std::vector<uint64_t> pointers;
+    std::vector<unsigned int> indices;
+    detail::csr_structure(tensor, pointers, indices);
+    return { tensor.base_value(), tensor.shape()[0], tensor.shape()[1], std::move(pointers), std::move(indices),
+        tensor.take_values() };
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include "sparse-matrix.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+enum class Major {
+    Row,
+    Col
+};
+
+// Non owning CSR arrays, from a CSRMatrix or straight from a mapped file.
+template <typename T>
+struct CSRView {
+    T m_baseValue;
+    unsigned int m_lines;
+    unsigned int m_cols;
+    uint64_t m_nonzeros;
+    const uint64_t* m_pointers;
+    const unsigned int* m_indices;
+    const T* m_values;
+};
+
+// Read only compressed storage of a SparceMatrix. The nonzeros of outer slice
+// i, a line for CSR and a column for CSC, are indices()/values() in
+// [pointers()[i], pointers()[i + 1]), sorted by their inner index.
+template <typename T, Major M>
+class CompressedMatrix {
+private:
+    T m_baseValue;
+    unsigned int m_lines;
+    unsigned int m_cols;
+    std::vector<uint64_t> m_pointers;
+    std::vector<unsigned int> m_indices;
+    std::vector<T> m_values;
+
+public:
+    CompressedMatrix(T baseValue, unsigned int lines, unsigned int cols)
+        : m_baseValue(baseValue)
+        , m_lines(lines)
+        , m_cols(cols)
+        , m_pointers(outer() + 1, 0)
+    {
+    }
+
+    CompressedMatrix(T baseValue, unsigned int lines, unsigned int cols,
+        std::vector<uint64_t> pointers, std::vector<unsigned int> indices, std::vector<T> values)
+        : m_baseValue(baseValue)
+        , m_lines(lines)
+        , m_cols(cols)
+        , m_pointers(std::move(pointers))
+        , m_indices(std::move(indices))
+        , m_values(std::move(values))
+    {
+        if (m_pointers.size() != uint64_t(outer()) + 1 || m_indices.size() != m_values.size()
+            || m_pointers.front() != 0 || m_pointers.back() != m_values.size())
+            throw std::invalid_argument("compressed arrays do not match the shape");
+    }
+
+    auto lines() const -> unsigned int { return m_lines; }
+    auto cols() const -> unsigned int { return m_cols; }
+    auto outer() const -> unsigned int { return M == Major::Row ? m_lines : m_cols; }
+    auto inner() const -> unsigned int { return M == Major::Row ? m_cols : m_lines; }
+    auto nonzeros() const -> uint64_t { return m_values.size(); }
+    auto base_value() const -> T { return m_baseValue; }
+
+    auto pointers() const -> const std::vector<uint64_t>& { return m_pointers; }
+    auto indices() const -> const std::vector<unsigned int>& { return m_indices; }
+    auto values() const -> const std::vector<T>& { return m_values; }
+
+    // The sparsity pattern is fixed, the stored values are not.
+    auto values() -> std::vector<T>& { return m_values; }
+
+    // Only meaningful for CSR, valid until the matrix is destroyed.
+    auto view() const -> CSRView<T>
+    {
+        static_assert(M == Major::Row, "a CSRView needs line major storage");
+        return { m_baseValue, m_lines, m_cols, nonzeros(), m_pointers.data(), m_indices.data(), m_values.data() };
+    }
+
+    // The values are the payload, the pointer and index arrays overhead.
+    auto memory_usage() const -> MemoryUsage
+    {
+        MemoryUsage usage;
+        usage.m_elements = nonzeros();
+        usage.m_payload = m_values.size() * sizeof(T);
+        usage.m_overhead = m_pointers.size() * sizeof(uint64_t) + m_indices.size() * sizeof(unsigned int) + sizeof(*this);
+        usage.m_slack = vector_slack(m_pointers) + vector_slack(m_indices) + vector_slack(m_values);
+        return usage;
+    }
+
+    // Binary search within the outer slice.
+    auto get(const unsigned int& line, const unsigned int& col) const -> T
+    {
+        if (line >= m_lines || col >= m_cols)
+            throw std::invalid_argument("index out of bounds");
+
+        unsigned int slice = M == Major::Row ? line : col;
+        unsigned int target = M == Major::Row ? col : line;
+        auto begin = m_indices.begin() + m_pointers[slice];
+        auto end = m_indices.begin() + m_pointers[slice + 1];
+        auto it = std::lower_bound(begin, end, target);
+        if (it == end || *it != target)
+            return m_baseValue;
+        return m_values[it - m_indices.begin()];
+    }
+};
+
+template <typename T>
+using CSRMatrix = CompressedMatrix<T, Major::Row>;
+
+template <typename T>
+using CSCMatrix = CompressedMatrix<T, Major::Col>;
+
+// Counting sort of the nonzeros by inner index. Slices are visited in order,
+// so the result comes out sorted even when the input slices were not.
+template <typename T, Major M>
+auto switch_major(const CompressedMatrix<T, M>& matrix)
+    -> CompressedMatrix<T, M == Major::Row ? Major::Col : Major::Row>
+{
+    const auto& pointers = matrix.pointers();
+    const auto& indices = matrix.indices();
+    const auto& values = matrix.values();
+
+    std::vector<uint64_t> out_pointers(uint64_t(matrix.inner()) + 1, 0);
+    for (unsigned int index : indices)
+        out_pointers[index + 1]++;
+    for (unsigned int i = 0; i < matrix.inner(); i++)
+        out_pointers[i + 1] += out_pointers[i];
+
+    std::vector<uint64_t> next(out_pointers.begin(), out_pointers.end() - 1);
+    std::vector<unsigned int> out_indices(indices.size());
+    std::vector<T> out_values(values.size());
+    for (unsigned int slice = 0; slice < matrix.outer(); slice++) {
+        for (uint64_t k = pointers[slice]; k < pointers[slice + 1]; k++) {
+            uint64_t dest = next[indices[k]]++;
+            out_indices[dest] = slice;
+            out_values[dest] = values[k];
+        }
+    }
+
+    return { matrix.base_value(), matrix.lines(), matrix.cols(),
+        std::move(out_pointers), std::move(out_indices), std::move(out_values) };
+}
+
+// Buckets the hash table by outer index only, slices come out unsorted.
+template <Major M, typename T>
+auto compress_unsorted(const SparceMatrix<T>& matrix) -> CompressedMatrix<T, M>
+{
+    unsigned int outer = M == Major::Row ? matrix.lines() : matrix.cols();
+    std::vector<uint64_t> pointers(uint64_t(outer) + 1, 0);
+    matrix.for_each([&](unsigned int line, unsigned int col, const T&) {
+        pointers[(M == Major::Row ? line : col) + 1]++;
+    });
+    for (unsigned int i = 0; i < outer; i++)
+        pointers[i + 1] += pointers[i];
+
+    std::vector<uint64_t> next(pointers.begin(), pointers.end() - 1);
+    std::vector<unsigned int> indices(matrix.nonzeros());
+    std::vector<T> values(matrix.nonzeros());
+    matrix.for_each([&](unsigned int line, unsigned int col, const T& value) {
+        uint64_t dest = next[M == Major::Row ? line : col]++;
+        indices[dest] = M == Major::Row ? col : line;
+        values[dest] = value;
+    });
+
+    return { matrix.base_value(), matrix.lines(), matrix.cols(),
+        std::move(pointers), std::move(indices), std::move(values) };
+}
+
+// Both conversions bucket into the other major order first and let
+// switch_major sort, two linear passes instead of a sort per slice.
+template <typename T>
+auto to_csr(const SparceMatrix<T>& matrix) -> CSRMatrix<T>
+{
+    return switch_major(compress_unsorted<Major::Col>(matrix));
+}
+
+template <typename T>
+auto to_csc(const SparceMatrix<T>& matrix) -> CSCMatrix<T>
+{
+    return switch_major(compress_unsorted<Major::Row>(matrix));
+}
+
+template <typename T>
+auto to_csr(const CSCMatrix<T>& matrix) -> CSRMatrix<T>
+{
+    return switch_major(matrix);
+}
+
+template <typename T>
+auto to_csc(const CSRMatrix<T>& matrix) -> CSCMatrix<T>
+{
+    return switch_major(matrix);
+}
+
+template <typename T, Major M>
+auto to_sparce(const CompressedMatrix<T, M>& matrix) -> SparceMatrix<T>
+{
+    SparceMatrix<T> sparce(matrix.base_value(), matrix.lines(), matrix.cols());
+    const auto& pointers = matrix.pointers();
+    for (unsigned int slice = 0; slice < matrix.outer(); slice++) {
+        for (uint64_t k = pointers[slice]; k < pointers[slice + 1]; k++) {
+            unsigned int index = matrix.indices()[k];
+            if (M == Major::Row)
+                sparce.insert(slice, index, matrix.values()[k]);
+            else
+                sparce.insert(index, slice, matrix.values()[k]);
+        }
+    }
+    return sparce;
+}
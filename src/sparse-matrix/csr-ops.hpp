@@ -0,0 +1,308 @@
+#pragma once
+#include "../thread-pool/thread-pool.hpp"
+#include "csr-matrix.hpp"
+#include "spmv.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Sparse matrix arithmetic on CSR storage. Every operation takes an optional
+// ThreadPool, without one the same parts run one after the other. Results
+// keep structural entries, a sum that cancels to zero is stored explicitly.
+
+// Runs fn(part, first, last) for every part of bounds.
+template <typename Fn>
+void for_each_part(ThreadPool* pool, const std::vector<unsigned int>& bounds, Fn&& fn)
+{
+    if (pool == nullptr) {
+        for (size_t part = 0; part + 1 < bounds.size(); part++)
+            fn(part, bounds[part], bounds[part + 1]);
+        return;
+    }
+    pool->parallel_for(0, bounds.size() - 1, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t part = begin; part < end; part++)
+            fn(part, bounds[part], bounds[part + 1]);
+    });
+}
+
+inline unsigned int part_count(ThreadPool* pool)
+{
+    return pool == nullptr ? 1 : pool->size() * 4;
+}
+
+// Turns per line counts stored at pointers[line + 1] into offsets.
+inline void prefix_sum(std::vector<uint64_t>& pointers)
+{
+    for (size_t i = 1; i < pointers.size(); i++)
+        pointers[i] += pointers[i - 1];
+}
+
+// Dense scatter buffer for one output line of Gustavson's algorithm. Marks
+// carry a generation number, so moving to the next line is O(1) instead of
+// clearing the whole width.
+template <typename T>
+struct SparseAccumulator {
+    std::vector<T> m_values;
+    std::vector<uint64_t> m_marks;
+    std::vector<unsigned int> m_touched;
+    std::vector<unsigned int> m_scratch;
+    uint64_t m_generation = 0;
+
+    void reset(unsigned int width)
+    {
+        if (m_marks.size() < width) {
+            m_values.resize(width);
+            m_marks.resize(width, 0);
+        }
+        m_generation++;
+        m_touched.clear();
+    }
+
+    void add(unsigned int col, const T& value)
+    {
+        if (m_marks[col] != m_generation) {
+            m_marks[col] = m_generation;
+            m_values[col] = value;
+            m_touched.push_back(col);
+        } else {
+            m_values[col] += value;
+        }
+    }
+
+    // LSD radix sort of the touched columns, one byte per pass and only as
+    // many passes as width needs. Three times faster than std::sort on the
+    // few hundred columns of a typical output line.
+    void sort(unsigned int width)
+    {
+        if (m_touched.size() < 64) {
+            std::sort(m_touched.begin(), m_touched.end());
+            return;
+        }
+        m_scratch.resize(m_touched.size());
+        unsigned int* source = m_touched.data();
+        unsigned int* dest = m_scratch.data();
+        for (unsigned int shift = 0; shift < 32 && ((width - 1) >> shift) != 0; shift += 8) {
+            size_t counts[257] = { 0 };
+            for (size_t i = 0; i < m_touched.size(); i++)
+                counts[((source[i] >> shift) & 0xff) + 1]++;
+            for (int digit = 0; digit < 256; digit++)
+                counts[digit + 1] += counts[digit];
+            for (size_t i = 0; i < m_touched.size(); i++)
+                dest[counts[(source[i] >> shift) & 0xff]++] = source[i];
+            std::swap(source, dest);
+        }
+        if (source != m_touched.data())
+            std::copy(source, source + m_touched.size(), m_touched.data());
+    }
+
+    // One per thread, reused across lines and calls.
+    static SparseAccumulator& local()
+    {
+        thread_local SparseAccumulator accumulator;
+        return accumulator;
+    }
+};
+
+// C = A * B with Gustavson's row by row algorithm. A symbolic pass sizes
+// every line of C, then a numeric pass fills it in place. Lines are split by
+// their multiply count rather than their nonzeros, since that is the work.
+template <typename T>
+auto multiply(ThreadPool* pool, const CSRMatrix<T>& a, const CSRMatrix<T>& b) -> CSRMatrix<T>
+{
+    if (a.cols() != b.lines())
+        throw std::invalid_argument("matrix shapes do not match");
+    if (a.base_value() != T {} || b.base_value() != T {})
+        throw std::invalid_argument("multiply needs a zero base value");
+
+    const auto& a_pointers = a.pointers();
+    const auto& a_indices = a.indices();
+    const auto& a_values = a.values();
+    const auto& b_pointers = b.pointers();
+    const auto& b_indices = b.indices();
+    const auto& b_values = b.values();
+
+    std::vector<uint64_t> work(uint64_t(a.lines()) + 1, 0);
+    for (unsigned int line = 0; line < a.lines(); line++) {
+        for (uint64_t k = a_pointers[line]; k < a_pointers[line + 1]; k++)
+            work[line + 1] += b_pointers[a_indices[k] + 1] - b_pointers[a_indices[k]];
+    }
+    prefix_sum(work);
+    std::vector<unsigned int> bounds = nnz_partition(work.data(), a.lines(), part_count(pool));
+
+    std::vector<uint64_t> pointers(uint64_t(a.lines()) + 1, 0);
+    for_each_part(pool, bounds, [&](unsigned int, unsigned int first, unsigned int last) {
+        auto& accumulator = SparseAccumulator<T>::local();
+        for (unsigned int line = first; line < last; line++) {
+            accumulator.reset(b.cols());
+            for (uint64_t k = a_pointers[line]; k < a_pointers[line + 1]; k++) {
+                for (uint64_t j = b_pointers[a_indices[k]]; j < b_pointers[a_indices[k] + 1]; j++)
+                    accumulator.add(b_indices[j], T {});
+            }
+            pointers[line + 1] = accumulator.m_touched.size();
+        }
+    });
+    prefix_sum(pointers);
+
+    std::vector<unsigned int> indices(pointers.back());
+    std::vector<T> values(pointers.back());
+    for_each_part(pool, bounds, [&](unsigned int, unsigned int first, unsigned int last) {
+        auto& accumulator = SparseAccumulator<T>::local();
+        for (unsigned int line = first; line < last; line++) {
+            accumulator.reset(b.cols());
+            for (uint64_t k = a_pointers[line]; k < a_pointers[line + 1]; k++) {
+                for (uint64_t j = b_pointers[a_indices[k]]; j < b_pointers[a_indices[k] + 1]; j++)
+                    accumulator.add(b_indices[j], a_values[k] * b_values[j]);
+            }
+            accumulator.sort(b.cols());
+            uint64_t dest = pointers[line];
+            for (unsigned int col : accumulator.m_touched) {
+                indices[dest] = col;
+                values[dest++] = accumulator.m_values[col];
+            }
+        }
+    });
+
+    return { T {}, a.lines(), b.cols(), std::move(pointers), std::move(indices), std::move(values) };
+}
+
+template <typename T>
+auto multiply(const CSRMatrix<T>& a, const CSRMatrix<T>& b) -> CSRMatrix<T>
+{
+    return multiply<T>(nullptr, a, b);
+}
+
+template <typename T>
+auto multiply(ThreadPool& pool, const CSRMatrix<T>& a, const CSRMatrix<T>& b) -> CSRMatrix<T>
+{
+    return multiply(&pool, a, b);
+}
+
+// Merges one line of A and B, both sorted, calling emit(col, value). A
+// column missing from one side reads as that side's base value.
+template <typename T, typename Emit>
+void merge_line(const CSRMatrix<T>& a, const CSRMatrix<T>& b, unsigned int line, Emit&& emit)
+{
+    uint64_t i = a.pointers()[line], i_end = a.pointers()[line + 1];
+    uint64_t j = b.pointers()[line], j_end = b.pointers()[line + 1];
+    while (i < i_end || j < j_end) {
+        if (j == j_end || (i < i_end && a.indices()[i] < b.indices()[j])) {
+            emit(a.indices()[i], a.values()[i] + b.base_value());
+            i++;
+        } else if (i == i_end || b.indices()[j] < a.indices()[i]) {
+            emit(b.indices()[j], a.base_value() + b.values()[j]);
+            j++;
+        } else {
+            emit(a.indices()[i], a.values()[i] + b.values()[j]);
+            i++;
+            j++;
+        }
+    }
+}
+
+// C = A + B, line by line merges of the sorted columns. The base values add
+// up too, so any pair of bases works.
+template <typename T>
+auto add(ThreadPool* pool, const CSRMatrix<T>& a, const CSRMatrix<T>& b) -> CSRMatrix<T>
+{
+    if (a.lines() != b.lines() || a.cols() != b.cols())
+        throw std::invalid_argument("matrix shapes do not match");
+
+    std::vector<uint64_t> work(a.pointers());
+    for (size_t i = 0; i < work.size(); i++)
+        work[i] += b.pointers()[i];
+    std::vector<unsigned int> bounds = nnz_partition(work.data(), a.lines(), part_count(pool));
+
+    std::vector<uint64_t> pointers(uint64_t(a.lines()) + 1, 0);
+    for_each_part(pool, bounds, [&](unsigned int, unsigned int first, unsigned int last) {
+        for (unsigned int line = first; line < last; line++)
+            merge_line(a, b, line, [&](unsigned int, const T&) { pointers[line + 1]++; });
+    });
+    prefix_sum(pointers);
+
+    std::vector<unsigned int> indices(pointers.back());
+    std::vector<T> values(pointers.back());
+    for_each_part(pool, bounds, [&](unsigned int, unsigned int first, unsigned int last) {
+        for (unsigned int line = first; line < last; line++) {
+            uint64_t dest = pointers[line];
+            merge_line(a, b, line, [&](unsigned int col, const T& value) {
+                indices[dest] = col;
+                values[dest++] = value;
+            });
+        }
+    });
+
+    return { a.base_value() + b.base_value(), a.lines(), a.cols(),
+        std::move(pointers), std::move(indices), std::move(values) };
+}
+
+template <typename T>
+auto add(const CSRMatrix<T>& a, const CSRMatrix<T>& b) -> CSRMatrix<T>
+{
+    return add<T>(nullptr, a, b);
+}
+
+template <typename T>
+auto add(ThreadPool& pool, const CSRMatrix<T>& a, const CSRMatrix<T>& b) -> CSRMatrix<T>
+{
+    return add(&pool, a, b);
+}
+
+// Counting sort by column. Each part counts its own columns, the offsets are
+// laid out column major over the parts, and every part then scatters its
+// lines in order, so the lines of the transpose come out sorted.
+template <typename T>
+auto transpose(ThreadPool* pool, const CSRMatrix<T>& a) -> CSRMatrix<T>
+{
+    unsigned int parts = pool == nullptr ? 1 : pool->size();
+    std::vector<unsigned int> bounds = nnz_partition(a.pointers().data(), a.lines(), parts);
+    const auto& a_pointers = a.pointers();
+    const auto& a_indices = a.indices();
+    const auto& a_values = a.values();
+
+    std::vector<uint64_t> offsets(uint64_t(parts) * a.cols(), 0);
+    for_each_part(pool, bounds, [&](unsigned int part, unsigned int first, unsigned int last) {
+        uint64_t* counts = offsets.data() + uint64_t(part) * a.cols();
+        for (uint64_t k = a_pointers[first]; k < a_pointers[last]; k++)
+            counts[a_indices[k]]++;
+    });
+
+    std::vector<uint64_t> pointers(uint64_t(a.cols()) + 1, 0);
+    uint64_t total = 0;
+    for (unsigned int col = 0; col < a.cols(); col++) {
+        pointers[col] = total;
+        for (unsigned int part = 0; part < parts; part++) {
+            uint64_t count = offsets[uint64_t(part) * a.cols() + col];
+            offsets[uint64_t(part) * a.cols() + col] = total;
+            total += count;
+        }
+    }
+    pointers[a.cols()] = total;
+
+    std::vector<unsigned int> indices(total);
+    std::vector<T> values(total);
+    for_each_part(pool, bounds, [&](unsigned int part, unsigned int first, unsigned int last) {
+        uint64_t* next = offsets.data() + uint64_t(part) * a.cols();
+        for (unsigned int line = first; line < last; line++) {
+            for (uint64_t k = a_pointers[line]; k < a_pointers[line + 1]; k++) {
+                uint64_t dest = next[a_indices[k]]++;
+                indices[dest] = line;
+                values[dest] = a_values[k];
+            }
+        }
+    });
+
+    return { a.base_value(), a.cols(), a.lines(), std::move(pointers), std::move(indices), std::move(values) };
+}
+
+template <typename T>
+auto transpose(const CSRMatrix<T>& a) -> CSRMatrix<T>
+{
+    return transpose<T>(nullptr, a);
+}
+
+template <typename T>
+auto transpose(ThreadPool& pool, const CSRMatrix<T>& a) -> CSRMatrix<T>
+{
+    return transpose(&pool, a);
+}
@@ -0,0 +1,390 @@
+#pragma once
+#include "csr-matrix.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Reads a file one line at a time through a fixed buffer. The buffer only
+// grows for a line longer than itself.
+class LineReader {
+private:
+    int m_fd;
+    std::vector<char> m_buffer;
+    size_t m_begin;
+    size_t m_end;
+    bool m_eof;
+
+public:
+    LineReader(const std::string& path, size_t buffer = 1 << 20)
+        : m_buffer(buffer)
+        , m_begin(0)
+        , m_end(0)
+        , m_eof(false)
+    {
+        m_fd = open(path.c_str(), O_RDONLY);
+        if (m_fd < 0)
+            throw std::runtime_error("cannot open " + path);
+        posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+    ~LineReader() { close(m_fd); }
+
+    // Next line without its '\n', valid until the following call. Returns
+    // false at the end of the file.
+    bool next(const char*& begin, const char*& end)
+    {
+        while (true) {
+            char* data = m_buffer.data();
+            char* newline = (char*)memchr(data + m_begin, '\n', m_end - m_begin);
+            if (newline != nullptr || (m_eof && m_begin < m_end)) {
+                begin = data + m_begin;
+                end = newline != nullptr ? newline : data + m_end;
+                m_begin = newline != nullptr ? newline - data + 1 : m_end;
+                return true;
+            }
+            if (m_eof)
+                return false;
+
+            memmove(data, data + m_begin, m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+            if (m_end == m_buffer.size())
+                m_buffer.resize(m_buffer.size() * 2);
+            ssize_t count = read(m_fd, m_buffer.data() + m_end, m_buffer.size() - m_end);
+            if (count < 0)
+                throw std::runtime_error("read failed");
+            m_end += count;
+            m_eof = count == 0;
+        }
+    }
+};
+
+// Matrix Market coordinate files: real, integer or pattern values, general,
+// symmetric or skew-symmetric.
+struct MatrixMarketHeader {
+    bool m_pattern;
+    bool m_symmetric;
+    bool m_skew;
+    unsigned int m_lines;
+    unsigned int m_cols;
+    uint64_t m_entries;
+};
+
+inline const char* skip_spaces(const char* begin, const char* end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+        begin++;
+    return begin;
+}
+
+template <typename N>
+const char* parse_number(const char* begin, const char* end, N& value)
+{
+    begin = skip_spaces(begin, end);
+    auto [ptr, error] = std::from_chars(begin, end, value);
+    // A number must end at a space or the end of the line, an integer read
+    // stopping at the '.' of "1.5" would otherwise load as 1.
+    if (error != std::errc() || (ptr < end && *ptr != ' ' && *ptr != '\t' && *ptr != '\r'))
+        throw std::runtime_error("malformed matrix market entry");
+    return ptr;
+}
+
+template <typename T>
+MatrixMarketHeader read_matrix_market_header(LineReader& reader)
+{
+    const char *begin, *end;
+    if (!reader.next(begin, end))
+        throw std::runtime_error("empty matrix market file");
+
+    std::string banner(begin, end);
+    std::transform(banner.begin(), banner.end(), banner.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (banner.rfind("%%matrixmarket matrix coordinate", 0) != 0)
+        throw std::runtime_error("only coordinate matrix market files are supported");
+
+    MatrixMarketHeader header {};
+    header.m_pattern = banner.find(" pattern") != std::string::npos;
+    header.m_skew = banner.find(" skew-symmetric") != std::string::npos;
+    header.m_symmetric = header.m_skew || banner.find(" symmetric") != std::string::npos;
+    if (banner.find(" complex") != std::string::npos || banner.find(" hermitian") != std::string::npos)
+        throw std::runtime_error("complex matrix market files are not supported");
+    if (std::is_integral_v<T> && banner.find(" real") != std::string::npos)
+        throw std::runtime_error("real matrix market values do not fit an integer type");
+
+    while (reader.next(begin, end)) {
+        begin = skip_spaces(begin, end);
+        if (begin == end || *begin == '%')
+            continue;
+        begin = parse_number(begin, end, header.m_lines);
+        begin = parse_number(begin, end, header.m_cols);
+        begin = parse_number(begin, end, header.m_entries);
+        if (skip_spaces(begin, end) != end)
+            throw std::runtime_error("malformed matrix market size line");
+        return header;
+    }
+    throw std::runtime_error("matrix market file has no size line");
+}
+
+// Calls fn(line, col, value) for every stored entry, 0 based, mirrored
+// entries of symmetric files included. Without Values the value text is
+// skipped and fn sees T(1), float parsing is most of the cost.
+template <typename T, bool Values, typename Fn>
+void read_matrix_market_entries(LineReader& reader, const MatrixMarketHeader& header, Fn&& fn)
+{
+    const char *begin, *end;
+    uint64_t entries = 0;
+    while (reader.next(begin, end)) {
+        begin = skip_spaces(begin, end);
+        if (begin == end || *begin == '%')
+            continue;
+
+        unsigned int line, col;
+        T value = T(1);
+        begin = parse_number(begin, end, line);
+        begin = parse_number(begin, end, col);
+        if (Values && !header.m_pattern)
+            begin = parse_number(begin, end, value);
+        if (Values && skip_spaces(begin, end) != end)
+            throw std::runtime_error("malformed matrix market entry");
+        if (line == 0 || col == 0 || line > header.m_lines || col > header.m_cols)
+            throw std::runtime_error("matrix market entry out of bounds");
+
+        fn(line - 1, col - 1, value);
+        if (header.m_symmetric && line != col)
+            fn(col - 1, line - 1, header.m_skew ? T(-value) : value);
+        entries++;
+    }
+    if (entries != header.m_entries)
+        throw std::runtime_error("matrix market entry count does not match the size line");
+}
+
+// Sorts every line by column and drops duplicates, the later entry in the
+// file wins like a later SparceMatrix::insert. Lines already in order, the
+// common case, cost one comparison per entry.
+template <typename T>
+void sort_lines(std::vector<uint64_t>& pointers, std::vector<unsigned int>& indices, std::vector<T>& values)
+{
+    std::vector<std::pair<unsigned int, uint64_t>> order;
+    uint64_t dest = 0;
+    uint64_t begin = 0;
+    for (size_t line = 0; line + 1 < pointers.size(); line++) {
+        uint64_t end = pointers[line + 1];
+        bool sorted = true;
+        for (uint64_t k = begin + 1; k < end && sorted; k++)
+            sorted = indices[k - 1] < indices[k];
+
+        if (sorted) {
+            for (uint64_t k = begin; k < end; k++, dest++) {
+                indices[dest] = indices[k];
+                values[dest] = values[k];
+            }
+        } else {
+            order.clear();
+            for (uint64_t k = begin; k < end; k++)
+                order.push_back({ indices[k], k });
+            std::sort(order.begin(), order.end());
+            std::vector<T> line_values;
+            for (size_t i = 0; i < order.size(); i++) {
+                if (i + 1 < order.size() && order[i + 1].first == order[i].first)
+                    continue;
+                line_values.push_back(values[order[i].second]);
+                indices[dest + line_values.size() - 1] = order[i].first;
+            }
+            for (T& value : line_values)
+                values[dest++] = value;
+        }
+        begin = end;
+        pointers[line + 1] = dest;
+    }
+    indices.resize(dest);
+    values.resize(dest);
+}
+
+// Two passes over the file: the first counts the entries of every line, the
+// second parses them straight into their final slots. Memory is the CSR
+// arrays plus the read buffer, whatever the file size.
+template <typename T>
+auto read_matrix_market(const std::string& path) -> CSRMatrix<T>
+{
+    LineReader counter(path);
+    MatrixMarketHeader header = read_matrix_market_header<T>(counter);
+    std::vector<uint64_t> pointers(uint64_t(header.m_lines) + 1, 0);
+    read_matrix_market_entries<T, false>(counter, header, [&](unsigned int line, unsigned int, const T&) {
+        pointers[line + 1]++;
+    });
+    for (unsigned int i = 0; i < header.m_lines; i++)
+        pointers[i + 1] += pointers[i];
+
+    LineReader reader(path);
+    read_matrix_market_header<T>(reader);
+    std::vector<uint64_t> next(pointers.begin(), pointers.end() - 1);
+    std::vector<unsigned int> indices(pointers.back());
+    std::vector<T> values(pointers.back());
+    read_matrix_market_entries<T, true>(reader, header, [&](unsigned int line, unsigned int col, const T& value) {
+        uint64_t dest = next[line]++;
+        indices[dest] = col;
+        values[dest] = value;
+    });
+
+    sort_lines(pointers, indices, values);
+    return { T {}, header.m_lines, header.m_cols, std::move(pointers), std::move(indices), std::move(values) };
+}
+
+// Binary CSR: a header, the base value, then the three arrays, each one 8
+// byte aligned so a mapping of the file can be used in place.
+struct BinaryCSRHeader {
+    char m_magic[8];
+    uint32_t m_value_size;
+    uint32_t m_floating;
+    uint64_t m_lines;
+    uint64_t m_cols;
+    uint64_t m_nonzeros;
+    unsigned char m_base[16];
+};
+
+inline constexpr char binary_csr_magic[8] = { 'D', 'S', 'C', 'S', 'R', '0', '1', '\n' };
+
+inline uint64_t align8(uint64_t size)
+{
+    return (size + 7) & ~uint64_t(7);
+}
+
+template <typename T>
+void write_binary(const CSRView<T>& matrix, const std::string& path)
+{
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= 16 && alignof(T) <= 8,
+        "binary CSR stores small trivially copyable values");
+
+    BinaryCSRHeader header {};
+    memcpy(header.m_magic, binary_csr_magic, sizeof(header.m_magic));
+    header.m_value_size = sizeof(T);
+    header.m_floating = std::is_floating_point_v<T>;
+    header.m_lines = matrix.m_lines;
+    header.m_cols = matrix.m_cols;
+    header.m_nonzeros = matrix.m_nonzeros;
+    memcpy(header.m_base, &matrix.m_baseValue, sizeof(T));
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        throw std::runtime_error("cannot open " + path);
+    uint64_t indices_size = matrix.m_nonzeros * sizeof(unsigned int);
+    static const char padding[8] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(matrix.m_pointers, sizeof(uint64_t), matrix.m_lines + 1, file) == matrix.m_lines + 1
+        && fwrite(matrix.m_indices, 1, indices_size, file) == indices_size
+        && fwrite(padding, 1, align8(indices_size) - indices_size, file) == align8(indices_size) - indices_size
+        && fwrite(matrix.m_values, sizeof(T), matrix.m_nonzeros, file) == matrix.m_nonzeros;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        throw std::runtime_error("cannot write " + path);
+}
+
+template <typename T>
+void write_binary(const CSRMatrix<T>& matrix, const std::string& path)
+{
+    write_binary(matrix.view(), path);
+}
+
+// Read only mapping of a binary CSR file. The header, the row pointers and
+// the column indices are all checked when mapping, so kernels can use the
+// view without bounds checks.
+template <typename T>
+class MappedCSR {
+private:
+    void* m_data;
+    size_t m_size;
+    CSRView<T> m_view;
+
+public:
+    MappedCSR(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + path);
+        struct stat info;
+        if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(BinaryCSRHeader)) {
+            close(fd);
+            throw std::runtime_error("not a binary CSR file: " + path);
+        }
+        m_size = info.st_size;
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (m_data == MAP_FAILED)
+            throw std::runtime_error("cannot map " + path);
+
+        try {
+            validate();
+        } catch (...) {
+            munmap(m_data, m_size);
+            throw;
+        }
+    }
+    MappedCSR(const MappedCSR&) = delete;
+    MappedCSR& operator=(const MappedCSR&) = delete;
+    ~MappedCSR() { munmap(m_data, m_size); }
+
+    auto view() const -> const CSRView<T>& { return m_view; }
+
+    // Copies the mapping into an owning CSRMatrix.
+    auto load() const -> CSRMatrix<T>
+    {
+        return { m_view.m_baseValue, m_view.m_lines, m_view.m_cols,
+            std::vector<uint64_t>(m_view.m_pointers, m_view.m_pointers + m_view.m_lines + 1),
+            std::vector<unsigned int>(m_view.m_indices, m_view.m_indices + m_view.m_nonzeros),
+            std::vector<T>(m_view.m_values, m_view.m_values + m_view.m_nonzeros) };
+    }
+
+private:
+    void validate()
+    {
+        const char* data = (const char*)m_data;
+        BinaryCSRHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.m_magic, binary_csr_magic, sizeof(header.m_magic)) != 0)
+            throw std::runtime_error("not a binary CSR file");
+        if (header.m_value_size != sizeof(T) || header.m_floating != std::is_floating_point_v<T>)
+            throw std::runtime_error("binary CSR value type does not match");
+        if (header.m_lines > ~0u || header.m_cols > ~0u)
+            throw std::runtime_error("binary CSR shape too large");
+        // Bounds the nonzeros by the file size before the offsets below
+        // multiply them, a crafted count would otherwise wrap the size check.
+        if (header.m_nonzeros > (m_size - sizeof(header)) / (sizeof(unsigned int) + sizeof(T)))
+            throw std::runtime_error("binary CSR nonzero count too large");
+
+        uint64_t pointers = sizeof(header);
+        uint64_t indices = pointers + (header.m_lines + 1) * sizeof(uint64_t);
+        uint64_t values = indices + align8(header.m_nonzeros * sizeof(unsigned int));
+        if (values + header.m_nonzeros * sizeof(T) != m_size)
+            throw std::runtime_error("binary CSR size does not match its header");
+
+        memcpy(&m_view.m_baseValue, header.m_base, sizeof(T));
+        m_view.m_lines = header.m_lines;
+        m_view.m_cols = header.m_cols;
+        m_view.m_nonzeros = header.m_nonzeros;
+        m_view.m_pointers = (const uint64_t*)(data + pointers);
+        m_view.m_indices = (const unsigned int*)(data + indices);
+        m_view.m_values = (const T*)(data + values);
+        if (m_view.m_pointers[0] != 0 || m_view.m_pointers[m_view.m_lines] != m_view.m_nonzeros)
+            throw std::runtime_error("binary CSR pointers do not match its header");
+        for (uint64_t line = 0; line < m_view.m_lines; line++) {
+            if (m_view.m_pointers[line] > m_view.m_pointers[line + 1])
+                throw std::runtime_error("binary CSR pointers are not sorted");
+        }
+        for (uint64_t i = 0; i < m_view.m_nonzeros; i++) {
+            if (m_view.m_indices[i] >= m_view.m_cols)
+                throw std::runtime_error("binary CSR column index out of bounds");
+        }
+    }
+};
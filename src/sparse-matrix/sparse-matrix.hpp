@@ -1,69 +1,253 @@
-#include "../array/array.hpp"
-#include "../linked_list/linked_list.hpp"
 #pragma once
+#include "../stats/memory-usage.hpp"
+#include "../stats/stats.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
 
+// Every non base value lives in one open addressing table keyed by the
+// packed (line, col) pair, so get, insert and erase are O(1) expected no
+// matter how many nonzeros a line has.
 template <typename T>
 class SparceMatrix {
 private:
     T m_baseValue;
     unsigned int m_lines;
+    unsigned int m_cols;
+    bool m_bounded;
 
-    struct m_Node {
+    struct m_Slot {
+        uint64_t m_key;
         T m_value;
-        unsigned int m_col;
     };
-    LinkedList<m_Node>* m_matrix;
+    m_Slot* m_slots;
+    uint64_t m_mask;
+    uint64_t m_size;
+    [[no_unique_address]] StatsRecorder m_stats;
+
+    // Lines are bounded by m_lines, so line ~0u never reaches the table.
+    static constexpr uint64_t m_empty = ~uint64_t(0);
+
+    static uint64_t key(const unsigned int& line, const unsigned int& col)
+    {
+        return (uint64_t(line) << 32) | col;
+    }
+
+    // Murmur3 finalizer, packed keys of one line differ only in the low bits.
+    static uint64_t hash(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    auto find(uint64_t key) -> uint64_t;
+    void remove_at(uint64_t index);
+    void rehash(uint64_t capacity);
 
 public:
-    SparceMatrix<T>(T baseValue, const unsigned int& lines);
-    ~SparceMatrix<T>();
+    // Without cols the width is unbounded and cols() reports one past the
+    // largest column ever inserted.
+    SparceMatrix(T baseValue, const unsigned int& lines, const unsigned int& cols = 0);
+    SparceMatrix(const SparceMatrix<T>&) = delete;
+    SparceMatrix<T>& operator=(const SparceMatrix<T>&) = delete;
+    SparceMatrix(SparceMatrix<T>&& other);
+    ~SparceMatrix();
     void insert(const unsigned int& line, const unsigned int& col, T value);
     auto get(const unsigned int& line, const unsigned int& col) -> T;
+    auto erase(const unsigned int& line, const unsigned int& col) -> bool;
+    auto lines() const -> unsigned int { return m_lines; }
+    auto cols() const -> unsigned int { return m_cols; }
+    auto nonzeros() const -> uint64_t { return m_size; }
+    auto base_value() const -> T { return m_baseValue; }
+
+    // Calls fn(line, col, value) for every non base value, in no order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const;
+
+    // Zeroed unless built with DS_ENABLE_STATS, see stats.hpp. Visits are
+    // probed slots, resizes are rehashes.
+    auto stats() const -> ContainerStats { return m_stats.stats(); }
+    void reset_stats() { m_stats.reset(); }
+
+    // The packed key of every slot is overhead, empty slots are slack.
+    auto memory_usage() const -> MemoryUsage;
 };
 
 template <typename T>
-SparceMatrix<T>::SparceMatrix(T baseValue, const unsigned int& lines)
+SparceMatrix<T>::SparceMatrix(T baseValue, const unsigned int& lines, const unsigned int& cols)
     : m_baseValue(baseValue)
     , m_lines(lines)
+    , m_cols(cols)
+    , m_bounded(cols != 0)
+    , m_mask(15)
+    , m_size(0)
+{
+    m_slots = new m_Slot[m_mask + 1];
+    m_stats.allocation();
+    for (uint64_t i = 0; i <= m_mask; i++)
+        m_slots[i].m_key = m_empty;
+}
+
+template <typename T>
+SparceMatrix<T>::SparceMatrix(SparceMatrix<T>&& other)
+    : m_baseValue(other.m_baseValue)
+    , m_lines(other.m_lines)
+    , m_cols(other.m_cols)
+    , m_bounded(other.m_bounded)
+    , m_slots(other.m_slots)
+    , m_mask(other.m_mask)
+    , m_size(other.m_size)
+    , m_stats(std::move(other.m_stats))
 {
-    m_matrix = new LinkedList<m_Node>[m_lines];
+    other.m_slots = new m_Slot[1] { { m_empty, m_baseValue } };
+    other.m_mask = 0;
+    other.m_size = 0;
 }
 
 template <typename T>
 SparceMatrix<T>::~SparceMatrix()
 {
-    //    for (int i = 0; i < m_lines; i++)
-    //        delete m_matrix[i];
-    //
-    delete[] m_matrix;
+    delete[] m_slots;
 }
 
+// Index of the slot holding key, or of the empty slot ending its probe run.
 template <typename T>
-void SparceMatrix<T>::insert(const unsigned int& line, const unsigned int& col, T value)
+auto SparceMatrix<T>::find(uint64_t key) -> uint64_t
+{
+    uint64_t index = hash(key) & m_mask;
+    m_stats.visit();
+    while (m_slots[index].m_key != m_empty && m_slots[index].m_key != key) {
+        index = (index + 1) & m_mask;
+        m_stats.visit();
+    }
+    return index;
+}
+
+// Backward shift deletion: pull later entries of the probe run into the hole
+// unless that would move them before their home slot, so no tombstones.
+template <typename T>
+void SparceMatrix<T>::remove_at(uint64_t index)
 {
-    for (auto it : m_matrix[line]) {
-        if (it.m_value.m_col == col) {
-            if (value == m_baseValue) {
-                m_matrix[line].erase(it);
-            } else {
-                it.m_value.m_value = value;
-            }
-            return;
+    uint64_t next = index;
+    while (true) {
+        next = (next + 1) & m_mask;
+        m_stats.visit();
+        if (m_slots[next].m_key == m_empty)
+            break;
+        uint64_t home = hash(m_slots[next].m_key) & m_mask;
+        if (((next - home) & m_mask) >= ((next - index) & m_mask)) {
+            m_slots[index] = std::move(m_slots[next]);
+            index = next;
         }
     }
+    m_slots[index].m_key = m_empty;
+    m_slots[index].m_value = m_baseValue;
+    m_size--;
+}
+
+template <typename T>
+void SparceMatrix<T>::rehash(uint64_t capacity)
+{
+    m_Slot* old = m_slots;
+    uint64_t old_capacity = m_mask + 1;
+
+    m_slots = new m_Slot[capacity];
+    m_stats.resize();
+    m_stats.allocation();
+    m_stats.deallocation();
+    m_mask = capacity - 1;
+    for (uint64_t i = 0; i < capacity; i++)
+        m_slots[i].m_key = m_empty;
+
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old[i].m_key != m_empty)
+            m_slots[find(old[i].m_key)] = std::move(old[i]);
+    }
+    delete[] old;
+}
+
+template <typename T>
+void SparceMatrix<T>::insert(const unsigned int& line, const unsigned int& col, T value)
+{
+    auto timer = m_stats.time(Operation::Insert);
+    if (line >= m_lines)
+        throw std::invalid_argument("line out of bounds");
+    if (col >= (m_bounded ? m_cols : ~0u))
+        throw std::invalid_argument("col out of bounds");
+
+    uint64_t index = find(key(line, col));
+    if (m_slots[index].m_key != m_empty) {
+        if (value == m_baseValue)
+            remove_at(index);
+        else
+            m_slots[index].m_value = value;
+        return;
+    }
 
     if (value == m_baseValue)
         return;
 
-    m_matrix[line].push_front({ value, col });
+    // Keep the load factor under 3/4 so probe runs stay short.
+    if ((m_size + 1) * 4 > (m_mask + 1) * 3) {
+        rehash((m_mask + 1) * 2);
+        index = find(key(line, col));
+    }
+    m_slots[index] = { key(line, col), value };
+    m_size++;
+    if (!m_bounded && col >= m_cols)
+        m_cols = col + 1;
 }
 
 template <typename T>
 auto SparceMatrix<T>::get(const unsigned int& line, const unsigned int& col) -> T
 {
-    for (auto it : m_matrix[line]) {
-        if (it.m_value.m_col == col)
-            return it.m_value.m_value;
+    auto timer = m_stats.time(Operation::Lookup);
+    if (line >= m_lines)
+        throw std::invalid_argument("line out of bounds");
+
+    uint64_t index = find(key(line, col));
+    if (m_slots[index].m_key == m_empty)
+        return m_baseValue;
+    return m_slots[index].m_value;
+}
+
+// Resets (line, col) to the base value, returns whether it held anything else.
+template <typename T>
+auto SparceMatrix<T>::erase(const unsigned int& line, const unsigned int& col) -> bool
+{
+    auto timer = m_stats.time(Operation::Remove);
+    if (line >= m_lines)
+        throw std::invalid_argument("line out of bounds");
+
+    uint64_t index = find(key(line, col));
+    if (m_slots[index].m_key == m_empty)
+        return false;
+    remove_at(index);
+    return true;
+}
+
+template <typename T>
+auto SparceMatrix<T>::memory_usage() const -> MemoryUsage
+{
+    MemoryUsage usage;
+    usage.m_elements = m_size;
+    usage.m_payload = m_size * sizeof(T);
+    usage.m_overhead = m_size * (sizeof(m_Slot) - sizeof(T)) + sizeof(*this);
+    usage.m_slack = (m_mask + 1 - m_size) * sizeof(m_Slot);
+    usage.allocations((m_mask + 1) * sizeof(m_Slot));
+    return usage;
+}
+
+template <typename T>
+template <typename Fn>
+void SparceMatrix<T>::for_each(Fn&& fn) const
+{
+    for (uint64_t i = 0; i <= m_mask; i++) {
+        if (m_slots[i].m_key != m_empty)
+            fn((unsigned int)(m_slots[i].m_key >> 32), (unsigned int)m_slots[i].m_key, m_slots[i].m_value);
     }
-    return m_baseValue;
 }
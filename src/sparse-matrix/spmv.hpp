@@ -0,0 +1,188 @@
+#pragma once
+#include "../thread-pool/thread-pool.hpp"
+#include "csr-matrix.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SPMV_AVX2 1
+#endif
+
+// y = A * x over compressed rows. The kernels work on the raw arrays so any
+// CSR layout, owned or mapped, can use them.
+
+// Plain loop, any T with + and *.
+template <typename T>
+void spmv_rows_scalar(const uint64_t* pointers, const unsigned int* indices, const T* values,
+    const T* x, T* y, unsigned int first, unsigned int last)
+{
+    for (unsigned int row = first; row < last; row++) {
+        T sum {};
+        for (uint64_t k = pointers[row]; k < pointers[row + 1]; k++)
+            sum += values[k] * x[indices[k]];
+        y[row] = sum;
+    }
+}
+
+#ifdef SPMV_AVX2
+// _mm256_i32gather_pd as the masked gather over zeros, the same instruction.
+// GCC 12 warns that the unmasked one reads an uninitialized source register.
+__attribute__((target("avx2"))) inline __m256d gather_pd(const double* x, __m128i index)
+{
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, index, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+
+// Gathers x four doubles or eight floats at a time. Two accumulators hide the
+// FMA latency on long rows, short rows fall through to the scalar tail.
+__attribute__((target("avx2,fma"))) inline void spmv_rows_avx2(const uint64_t* pointers,
+    const unsigned int* indices, const double* values, const double* x, double* y,
+    unsigned int first, unsigned int last)
+{
+    for (unsigned int row = first; row < last; row++) {
+        uint64_t k = pointers[row];
+        uint64_t end = pointers[row + 1];
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        for (; k + 8 <= end; k += 8) {
+            __m128i index0 = _mm_loadu_si128((const __m128i*)(indices + k));
+            __m128i index1 = _mm_loadu_si128((const __m128i*)(indices + k + 4));
+            sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), gather_pd(x, index0), sum0);
+            sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k + 4), gather_pd(x, index1), sum1);
+        }
+        if (k + 4 <= end) {
+            __m128i index = _mm_loadu_si128((const __m128i*)(indices + k));
+            sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), gather_pd(x, index), sum0);
+            k += 4;
+        }
+        sum0 = _mm256_add_pd(sum0, sum1);
+        __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+        double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+        for (; k < end; k++)
+            sum += values[k] * x[indices[k]];
+        y[row] = sum;
+    }
+}
+
+__attribute__((target("avx2,fma"))) inline void spmv_rows_avx2(const uint64_t* pointers,
+    const unsigned int* indices, const float* values, const float* x, float* y,
+    unsigned int first, unsigned int last)
+{
+    for (unsigned int row = first; row < last; row++) {
+        uint64_t k = pointers[row];
+        uint64_t end = pointers[row + 1];
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (; k + 16 <= end; k += 16) {
+            __m256i index0 = _mm256_loadu_si256((const __m256i*)(indices + k));
+            __m256i index1 = _mm256_loadu_si256((const __m256i*)(indices + k + 8));
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), _mm256_i32gather_ps(x, index0, 4), sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k + 8), _mm256_i32gather_ps(x, index1, 4), sum1);
+        }
+        if (k + 8 <= end) {
+            __m256i index = _mm256_loadu_si256((const __m256i*)(indices + k));
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), _mm256_i32gather_ps(x, index, 4), sum0);
+            k += 8;
+        }
+        sum0 = _mm256_add_ps(sum0, sum1);
+        __m128 quad = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+        quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        float sum = _mm_cvtss_f32(_mm_add_ss(quad, _mm_movehdup_ps(quad)));
+        for (; k < end; k++)
+            sum += values[k] * x[indices[k]];
+        y[row] = sum;
+    }
+}
+
+inline bool spmv_has_avx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+}
+#endif
+
+// Picks the AVX2 kernel for float and double when the CPU has it. Gather
+// indices are signed 32 bit, so wider matrices stay scalar.
+template <typename T>
+void spmv_rows(const uint64_t* pointers, const unsigned int* indices, const T* values,
+    const T* x, T* y, unsigned int first, unsigned int last, unsigned int cols)
+{
+#ifdef SPMV_AVX2
+    if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+        if (cols <= unsigned(INT_MAX) && spmv_has_avx2()) {
+            spmv_rows_avx2(pointers, indices, values, x, y, first, last);
+            return;
+        }
+    }
+#endif
+    spmv_rows_scalar(pointers, indices, values, x, y, first, last);
+}
+
+// Splits rows into parts of about equal work. A row costs its nonzeros plus
+// one, so runs of empty rows are not free either. Returns parts + 1 bounds.
+inline std::vector<unsigned int> nnz_partition(const uint64_t* pointers, unsigned int rows, unsigned int parts)
+{
+    std::vector<unsigned int> bounds(parts + 1, rows);
+    bounds[0] = 0;
+    uint64_t total = pointers[rows] + rows;
+    for (unsigned int part = 1; part < parts; part++) {
+        uint64_t target = total * part / parts;
+        unsigned int low = bounds[part - 1];
+        unsigned int high = rows;
+        while (low < high) {
+            unsigned int middle = low + (high - low) / 2;
+            if (pointers[middle] + middle < target)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        bounds[part] = low;
+    }
+    return bounds;
+}
+
+template <typename T>
+void spmv_check(const CSRView<T>& matrix)
+{
+    if (matrix.m_baseValue != T {})
+        throw std::invalid_argument("spmv needs a zero base value");
+}
+
+// x has cols elements and y has lines.
+template <typename T>
+void spmv(const CSRView<T>& matrix, const T* x, T* y)
+{
+    spmv_check(matrix);
+    spmv_rows(matrix.m_pointers, matrix.m_indices, matrix.m_values, x, y, 0, matrix.m_lines, matrix.m_cols);
+}
+
+// Four parts per worker leaves room for stealing when the nonzero count is
+// a poor estimate of the cost, e.g. rows whose columns miss the cache.
+template <typename T>
+void spmv(ThreadPool& pool, const CSRView<T>& matrix, const T* x, T* y)
+{
+    spmv_check(matrix);
+    std::vector<unsigned int> bounds = nnz_partition(matrix.m_pointers, matrix.m_lines, pool.size() * 4);
+    pool.parallel_for(0, bounds.size() - 1, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t part = begin; part < end; part++) {
+            spmv_rows(matrix.m_pointers, matrix.m_indices, matrix.m_values,
+                x, y, bounds[part], bounds[part + 1], matrix.m_cols);
+        }
+    });
+}
+
+template <typename T>
+void spmv(const CSRMatrix<T>& matrix, const T* x, T* y)
+{
+    spmv(matrix.view(), x, y);
+}
+
+template <typename T>
+void spmv(ThreadPool& pool, const CSRMatrix<T>& matrix, const T* x, T* y)
+{
+    spmv(pool, matrix.view(), x, y);
+}
@@ -1,11 +1,514 @@
-#include <cstdlib>
-#include <iostream>
-
+#include "coo-builder.hpp"
+#include "csr-matrix.hpp"
+#include "csr-ops.hpp"
+#include "matrix-io.hpp"
 #include "sparse-matrix.hpp"
+#include "spmv.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <utility>
+
+TEST(SparceMatrix, InsertGet)
+{
+    SparceMatrix<int> matrix(0, 10);
+
+    EXPECT_EQ(matrix.get(3, 7), 0);
+    matrix.insert(3, 7, 42);
+    matrix.insert(3, 8, 43);
+    matrix.insert(4, 7, 44);
+    EXPECT_EQ(matrix.get(3, 7), 42);
+    EXPECT_EQ(matrix.get(3, 8), 43);
+    EXPECT_EQ(matrix.get(4, 7), 44);
+    EXPECT_EQ(matrix.nonzeros(), 3);
+
+    matrix.insert(3, 7, 50);
+    EXPECT_EQ(matrix.get(3, 7), 50);
+    EXPECT_EQ(matrix.nonzeros(), 3);
+
+    EXPECT_THROW(matrix.insert(10, 0, 1), std::invalid_argument);
+    EXPECT_THROW(matrix.get(10, 0), std::invalid_argument);
+}
+
+TEST(SparceMatrix, BaseValueErases)
+{
+    SparceMatrix<int> matrix(-1, 4);
+
+    matrix.insert(0, 0, -1);
+    EXPECT_EQ(matrix.nonzeros(), 0);
+
+    matrix.insert(1, 2, 5);
+    matrix.insert(1, 2, -1);
+    EXPECT_EQ(matrix.get(1, 2), -1);
+    EXPECT_EQ(matrix.nonzeros(), 0);
+
+    matrix.insert(2, 3, 6);
+    EXPECT_TRUE(matrix.erase(2, 3));
+    EXPECT_FALSE(matrix.erase(2, 3));
+    EXPECT_EQ(matrix.get(2, 3), -1);
+}
+
+// Random inserts and erases against std::map, through several rehashes and
+// enough collisions to exercise backward shift deletion.
+TEST(SparceMatrix, Random)
+{
+    SparceMatrix<int> matrix(0, 64);
+    std::map<std::pair<unsigned int, unsigned int>, int> reference;
+    std::mt19937 random(42);
+
+    for (int i = 0; i < 100000; i++) {
+        unsigned int line = random() % 64;
+        unsigned int col = random() % 256;
+        int value = random() % 4;
+        if (random() % 3 == 0) {
+            EXPECT_EQ(matrix.erase(line, col), reference.erase({ line, col }) == 1);
+            continue;
+        }
+        matrix.insert(line, col, value);
+        if (value == 0)
+            reference.erase({ line, col });
+        else
+            reference[{ line, col }] = value;
+    }
+
+    EXPECT_EQ(matrix.nonzeros(), reference.size());
+    for (unsigned int line = 0; line < 64; line++) {
+        for (unsigned int col = 0; col < 256; col++) {
+            auto it = reference.find({ line, col });
+            ASSERT_EQ(matrix.get(line, col), it == reference.end() ? 0 : it->second);
+        }
+    }
+}
+
+TEST(SparceMatrix, Cols)
+{
+    SparceMatrix<int> bounded(0, 4, 8);
+    EXPECT_EQ(bounded.cols(), 8);
+    EXPECT_THROW(bounded.insert(0, 8, 1), std::invalid_argument);
+
+    SparceMatrix<int> unbounded(0, 4);
+    EXPECT_EQ(unbounded.cols(), 0);
+    unbounded.insert(1, 41, 1);
+    unbounded.insert(2, 3, 1);
+    EXPECT_EQ(unbounded.cols(), 42);
+}
+
+TEST(CompressedMatrix, ToCsr)
+{
+    SparceMatrix<int> matrix(0, 3, 4);
+    matrix.insert(0, 3, 1);
+    matrix.insert(0, 1, 2);
+    matrix.insert(2, 2, 3);
+    matrix.insert(2, 0, 4);
+    matrix.insert(2, 1, 5);
+
+    CSRMatrix<int> csr = to_csr(matrix);
+    EXPECT_EQ(csr.nonzeros(), 5);
+    EXPECT_EQ(csr.pointers(), (std::vector<uint64_t> { 0, 2, 2, 5 }));
+    EXPECT_EQ(csr.indices(), (std::vector<unsigned int> { 1, 3, 0, 1, 2 }));
+    EXPECT_EQ(csr.values(), (std::vector<int> { 2, 1, 4, 5, 3 }));
+    EXPECT_EQ(csr.get(2, 1), 5);
+    EXPECT_EQ(csr.get(1, 1), 0);
+    EXPECT_THROW(csr.get(3, 0), std::invalid_argument);
+
+    CSCMatrix<int> csc = to_csc(matrix);
+    EXPECT_EQ(csc.pointers(), (std::vector<uint64_t> { 0, 1, 3, 4, 5 }));
+    EXPECT_EQ(csc.indices(), (std::vector<unsigned int> { 2, 0, 2, 2, 0 }));
+    EXPECT_EQ(csc.values(), (std::vector<int> { 4, 2, 5, 3, 1 }));
 
-using namespace std;
+    EXPECT_EQ(to_csc(csr).indices(), csc.indices());
+    EXPECT_EQ(to_csr(csc).values(), csr.values());
 
-int main(void)
+    EXPECT_THROW(CSRMatrix<int>(0, 2, 2, { 0, 1 }, { 0 }, { 1 }), std::invalid_argument);
+}
+
+TEST(CompressedMatrix, RoundTrip)
+{
+    SparceMatrix<double> matrix(0.0, 200, 300);
+    std::mt19937 random(7);
+    for (int i = 0; i < 5000; i++)
+        matrix.insert(random() % 200, random() % 300, random() % 100);
+
+    CSRMatrix<double> csr = to_csr(matrix);
+    CSCMatrix<double> csc = to_csc(matrix);
+    EXPECT_EQ(csr.nonzeros(), matrix.nonzeros());
+    EXPECT_EQ(csc.nonzeros(), matrix.nonzeros());
+    for (unsigned int line = 0; line < 200; line++) {
+        EXPECT_TRUE(std::is_sorted(csr.indices().begin() + csr.pointers()[line],
+            csr.indices().begin() + csr.pointers()[line + 1]));
+        for (unsigned int col = 0; col < 300; col++) {
+            ASSERT_EQ(csr.get(line, col), matrix.get(line, col));
+            ASSERT_EQ(csc.get(line, col), matrix.get(line, col));
+        }
+    }
+
+    SparceMatrix<double> back = to_sparce(csc);
+    EXPECT_EQ(back.nonzeros(), matrix.nonzeros());
+    matrix.for_each([&](unsigned int line, unsigned int col, double value) {
+        EXPECT_EQ(back.get(line, col), value);
+    });
+}
+
+// Lines of 0 to 40 nonzeros so both the gather loops and the tails run.
+template <typename T>
+static void check_spmv(ThreadPool* pool)
+{
+    const unsigned int lines = 300, cols = 500;
+    SparceMatrix<T> matrix(0, lines, cols);
+    std::mt19937 random(11);
+    for (unsigned int line = 0; line < lines; line++) {
+        unsigned int count = random() % 41;
+        for (unsigned int i = 0; i < count; i++)
+            matrix.insert(line, random() % cols, T(random() % 7 + 1));
+    }
+    std::vector<T> x(cols);
+    for (auto& value : x)
+        value = T(random() % 5);
+
+    std::vector<T> expected(lines, T {});
+    matrix.for_each([&](unsigned int line, unsigned int col, T value) {
+        expected[line] += value * x[col];
+    });
+
+    std::vector<T> y(lines, T(-1));
+    CSRMatrix<T> csr = to_csr(matrix);
+    if (pool != nullptr)
+        spmv(*pool, csr, x.data(), y.data());
+    else
+        spmv(csr, x.data(), y.data());
+    EXPECT_EQ(y, expected);
+}
+
+TEST(Spmv, Serial)
+{
+    check_spmv<double>(nullptr);
+    check_spmv<float>(nullptr);
+    check_spmv<int>(nullptr);
+}
+
+TEST(Spmv, Parallel)
 {
-    SparceMatrix<int> list(0, 10);
+    ThreadPool pool(4);
+    check_spmv<double>(&pool);
+    check_spmv<float>(&pool);
+    check_spmv<int>(&pool);
+}
+
+TEST(Spmv, Partition)
+{
+    // One heavy line between runs of empty ones.
+    std::vector<uint64_t> pointers = { 0, 0, 0, 100, 100, 101, 102, 103, 104 };
+    std::vector<unsigned int> bounds = nnz_partition(pointers.data(), 8, 4);
+    EXPECT_EQ(bounds, (std::vector<unsigned int> { 0, 3, 3, 3, 8 }));
+
+    CSRMatrix<double> ones(1.0, 2, 2);
+    double x[2] = { 1, 1 }, y[2];
+    EXPECT_THROW(spmv(ones, x, y), std::invalid_argument);
+}
+
+static CSRMatrix<long> random_matrix(unsigned int lines, unsigned int cols, int count, unsigned int seed, long base = 0)
+{
+    SparceMatrix<long> matrix(base, lines, cols);
+    std::mt19937 random(seed);
+    for (int i = 0; i < count; i++)
+        matrix.insert(random() % lines, random() % cols, long(random() % 9) - 4);
+    return to_csr(matrix);
+}
+
+static void expect_sorted(const CSRMatrix<long>& matrix)
+{
+    for (unsigned int line = 0; line < matrix.lines(); line++) {
+        EXPECT_TRUE(std::is_sorted(matrix.indices().begin() + matrix.pointers()[line],
+            matrix.indices().begin() + matrix.pointers()[line + 1]));
+    }
+}
+
+TEST(CsrOps, Multiply)
+{
+    CSRMatrix<long> a = random_matrix(40, 30, 300, 1);
+    CSRMatrix<long> b = random_matrix(30, 50, 300, 2);
+    ThreadPool pool(4);
+    CSRMatrix<long> serial = multiply(a, b);
+    CSRMatrix<long> parallel = multiply(pool, a, b);
+    expect_sorted(serial);
+    EXPECT_EQ(serial.indices(), parallel.indices());
+    EXPECT_EQ(serial.values(), parallel.values());
+
+    for (unsigned int line = 0; line < 40; line++) {
+        for (unsigned int col = 0; col < 50; col++) {
+            long expected = 0;
+            for (unsigned int k = 0; k < 30; k++)
+                expected += a.get(line, k) * b.get(k, col);
+            ASSERT_EQ(serial.get(line, col), expected);
+        }
+    }
+
+    EXPECT_THROW(multiply(a, a), std::invalid_argument);
+}
+
+TEST(CsrOps, Add)
+{
+    CSRMatrix<long> a = random_matrix(40, 30, 200, 3, 1);
+    CSRMatrix<long> b = random_matrix(40, 30, 200, 4, 2);
+    ThreadPool pool(4);
+    CSRMatrix<long> sum = add(pool, a, b);
+    expect_sorted(sum);
+    EXPECT_EQ(sum.base_value(), 3);
+    EXPECT_EQ(sum.values(), add(a, b).values());
+    for (unsigned int line = 0; line < 40; line++) {
+        for (unsigned int col = 0; col < 30; col++)
+            ASSERT_EQ(sum.get(line, col), a.get(line, col) + b.get(line, col));
+    }
+
+    EXPECT_THROW(add(a, transpose(a)), std::invalid_argument);
+}
+
+TEST(CsrOps, Transpose)
+{
+    CSRMatrix<long> a = random_matrix(40, 70, 500, 5);
+    ThreadPool pool(4);
+    CSRMatrix<long> t = transpose(pool, a);
+    EXPECT_EQ(t.lines(), 70);
+    EXPECT_EQ(t.cols(), 40);
+    expect_sorted(t);
+    EXPECT_EQ(t.indices(), transpose(a).indices());
+    EXPECT_EQ(t.indices(), to_csc(a).indices());
+    for (unsigned int line = 0; line < 40; line++) {
+        for (unsigned int col = 0; col < 70; col++)
+            ASSERT_EQ(t.get(col, line), a.get(line, col));
+    }
+}
+
+static std::string write_file(const std::string& name, const std::string& contents)
+{
+    std::string path = "/tmp/sparse-matrix-test-" + std::to_string(getpid()) + "-" + name;
+    std::ofstream(path) << contents;
+    return path;
+}
+
+TEST(MatrixIO, MatrixMarket)
+{
+    // Unsorted lines, a duplicate where the later entry wins, comments and
+    // no trailing newline.
+    std::string path = write_file("general.mtx",
+        "%%MatrixMarket matrix coordinate real general\n"
+        "% comment\n"
+        "3 4 6\n"
+        "1 4 1.5\n"
+        "1 2 2\n"
+        "3 1 -3e2\n"
+        "\n"
+        "1 4 7\n"
+        "3 3 4\n"
+        "2 2 5");
+    CSRMatrix<double> matrix = read_matrix_market<double>(path);
+    EXPECT_EQ(matrix.lines(), 3);
+    EXPECT_EQ(matrix.cols(), 4);
+    EXPECT_EQ(matrix.pointers(), (std::vector<uint64_t> { 0, 2, 3, 5 }));
+    EXPECT_EQ(matrix.indices(), (std::vector<unsigned int> { 1, 3, 1, 0, 2 }));
+    EXPECT_EQ(matrix.values(), (std::vector<double> { 2, 7, 5, -300, 4 }));
+    unlink(path.c_str());
+
+    path = write_file("symmetric.mtx",
+        "%%MatrixMarket matrix coordinate pattern symmetric\n"
+        "3 3 3\n"
+        "1 1\n"
+        "3 1\n"
+        "3 2\n");
+    CSRMatrix<int> pattern = read_matrix_market<int>(path);
+    EXPECT_EQ(pattern.nonzeros(), 5);
+    EXPECT_EQ(pattern.get(0, 2), 1);
+    EXPECT_EQ(pattern.get(2, 0), 1);
+    EXPECT_EQ(pattern.get(1, 2), 1);
+    EXPECT_EQ(pattern.get(1, 1), 0);
+    unlink(path.c_str());
+
+    path = write_file("bad.mtx",
+        "%%MatrixMarket matrix coordinate integer general\n"
+        "2 2 1\n"
+        "3 1 1\n");
+    EXPECT_THROW(read_matrix_market<int>(path), std::runtime_error);
+    unlink(path.c_str());
+    EXPECT_THROW(read_matrix_market<int>(path), std::runtime_error);
+
+    // Real values into an integer type, by banner or by entry, and junk
+    // after the last field.
+    path = write_file("real.mtx",
+        "%%MatrixMarket matrix coordinate real general\n"
+        "2 2 1\n"
+        "1 1 2\n");
+    EXPECT_THROW(read_matrix_market<int>(path), std::runtime_error);
+    EXPECT_EQ(read_matrix_market<double>(path).get(0, 0), 2);
+    unlink(path.c_str());
+    path = write_file("fraction.mtx",
+        "%%MatrixMarket matrix coordinate integer general\n"
+        "2 2 1\n"
+        "1 1 1.5\n");
+    EXPECT_THROW(read_matrix_market<int>(path), std::runtime_error);
+    unlink(path.c_str());
+    path = write_file("junk.mtx",
+        "%%MatrixMarket matrix coordinate integer general\n"
+        "2 2 1\n"
+        "1 1 3 4\n");
+    EXPECT_THROW(read_matrix_market<int>(path), std::runtime_error);
+    unlink(path.c_str());
+}
+
+// Lines longer than the read buffer make it grow.
+TEST(MatrixIO, LineReader)
+{
+    std::string line(3000, 'x');
+    std::string path = write_file("lines.txt", "a\n" + line + "\nb\n");
+    LineReader reader(path, 64);
+    const char *begin, *end;
+    ASSERT_TRUE(reader.next(begin, end));
+    EXPECT_EQ(std::string(begin, end), "a");
+    ASSERT_TRUE(reader.next(begin, end));
+    EXPECT_EQ(std::string(begin, end), line);
+    ASSERT_TRUE(reader.next(begin, end));
+    EXPECT_EQ(std::string(begin, end), "b");
+    EXPECT_FALSE(reader.next(begin, end));
+    unlink(path.c_str());
+}
+
+// Overwrites size bytes of the file at offset.
+static void patch(const std::string& path, long offset, const void* data, size_t size)
+{
+    FILE* file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, offset, SEEK_SET);
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+TEST(MatrixIO, Binary)
+{
+    CSRMatrix<long> matrix = random_matrix(50, 60, 400, 9);
+    CSRMatrix<double> doubles(0.0, 50, 60, matrix.pointers(), matrix.indices(),
+        std::vector<double>(matrix.values().begin(), matrix.values().end()));
+    std::string path = "/tmp/sparse-matrix-test-" + std::to_string(getpid()) + ".csr";
+    write_binary(doubles, path);
+
+    MappedCSR<double> mapped(path);
+    EXPECT_EQ(mapped.view().m_nonzeros, doubles.nonzeros());
+    CSRMatrix<double> loaded = mapped.load();
+    EXPECT_EQ(loaded.indices(), doubles.indices());
+    EXPECT_EQ(loaded.values(), doubles.values());
+
+    std::vector<double> x(60, 1.0), expected(50), y(50);
+    spmv(doubles, x.data(), expected.data());
+    spmv(mapped.view(), x.data(), y.data());
+    EXPECT_EQ(y, expected);
+
+    EXPECT_THROW(MappedCSR<float>(path).view(), std::runtime_error);
+
+    // A row pointer running backwards, then a column index past the last
+    // column, with the header left intact.
+    uint64_t pointer = doubles.pointers()[10] + 1;
+    uint64_t pointers_at = sizeof(BinaryCSRHeader);
+    patch(path, pointers_at + 9 * sizeof(uint64_t), &pointer, sizeof(pointer));
+    EXPECT_THROW(MappedCSR<double>(path).view(), std::runtime_error);
+    write_binary(doubles, path);
+    unsigned int index = 60;
+    patch(path, pointers_at + 51 * sizeof(uint64_t) + 7 * sizeof(unsigned int), &index, sizeof(index));
+    EXPECT_THROW(MappedCSR<double>(path).view(), std::runtime_error);
+
+    // A nonzero count whose array sizes wrap around to the real ones, with
+    // the last row pointer matching it. Zero values keep the index scan from
+    // stopping early on them.
+    write_binary(CSRMatrix<double>(0.0, 50, 60, doubles.pointers(), doubles.indices(),
+                     std::vector<double>(doubles.nonzeros(), 0.0)),
+        path);
+    uint64_t nonzeros = (uint64_t(1) << 62) + doubles.nonzeros();
+    patch(path, offsetof(BinaryCSRHeader, m_nonzeros), &nonzeros, sizeof(nonzeros));
+    patch(path, pointers_at + 50 * sizeof(uint64_t), &nonzeros, sizeof(nonzeros));
+    EXPECT_THROW(MappedCSR<double>(path).view(), std::runtime_error);
+
+    truncate(path.c_str(), 100);
+    EXPECT_THROW(MappedCSR<double>(path).view(), std::runtime_error);
+    unlink(path.c_str());
+}
+
+TEST(COOBuilder, LastWins)
+{
+    COOBuilder<int> builder(0, 3, 5);
+    builder.add(2, 4, 1);
+    builder.add(0, 3, 2);
+    builder.add(2, 4, 3);
+    builder.add(1, 1, 4);
+    builder.add(1, 1, 0);
+    builder.add(0, 0, 5);
+    EXPECT_THROW(builder.add(3, 0, 1), std::invalid_argument);
+
+    CSRMatrix<int> matrix = builder.build_csr();
+    EXPECT_EQ(matrix.pointers(), (std::vector<uint64_t> { 0, 2, 2, 3 }));
+    EXPECT_EQ(matrix.indices(), (std::vector<unsigned int> { 0, 3, 4 }));
+    EXPECT_EQ(matrix.values(), (std::vector<int> { 5, 2, 3 }));
+    EXPECT_EQ(builder.size(), 0);
+}
+
+TEST(COOBuilder, Random)
+{
+    const unsigned int lines = 1000, cols = 3000;
+    SparceMatrix<int> reference(0, lines, cols);
+    COOBuilder<int> serial(0, lines, cols);
+    COOBuilder<int> parallel(0, lines, cols);
+    COOBuilder<int> unconverted(0, lines, cols);
+    std::mt19937 random(13);
+    for (int i = 0; i < 200000; i++) {
+        unsigned int line = random() % lines, col = random() % cols;
+        int value = random() % 5;
+        reference.insert(line, col, value);
+        serial.add(line, col, value);
+        parallel.add(line, col, value);
+        unconverted.add(line, col, value);
+    }
+
+    ThreadPool pool(4);
+    CSRMatrix<int> expected = to_csr(reference);
+    CSRMatrix<int> built = serial.build_csr();
+    EXPECT_EQ(built.pointers(), expected.pointers());
+    EXPECT_EQ(built.indices(), expected.indices());
+    EXPECT_EQ(built.values(), expected.values());
+    CSRMatrix<int> parallel_built = parallel.build_csr(pool);
+    EXPECT_EQ(parallel_built.indices(), expected.indices());
+    EXPECT_EQ(parallel_built.values(), expected.values());
+
+    SparseTensor<int, 2> tensor = unconverted.build(pool);
+    CSRMatrix<int> copied = to_csr(tensor);
+    EXPECT_EQ(copied.values(), expected.values());
+
+    // Converting an rvalue takes the values over and empties the tensor.
+    CSRMatrix<int> moved = to_csr(std::move(tensor));
+    EXPECT_EQ(moved.indices(), expected.indices());
+    EXPECT_EQ(moved.values(), expected.values());
+    EXPECT_EQ(tensor.nonzeros(), 0);
+    EXPECT_TRUE(tensor.keys().empty());
+}
+
+TEST(SparseTensor, ThreeDimensions)
+{
+    COOBuilder<double, 3> builder(0.0, { 4, 1000, 7 });
+    builder.add({ 3, 999, 6 }, 1.5);
+    builder.add({ 0, 5, 2 }, 2.5);
+    builder.add({ 3, 0, 0 }, 3.5);
+    builder.add({ 0, 5, 1 }, 4.5);
+    EXPECT_THROW(builder.add({ 0, 0, 7 }, 1.0), std::invalid_argument);
+
+    ThreadPool pool(2);
+    SparseTensor<double, 3> tensor = builder.build(pool);
+    EXPECT_EQ(tensor.nonzeros(), 4);
+    EXPECT_EQ(tensor.get({ 3, 999, 6 }), 1.5);
+    EXPECT_EQ(tensor.get({ 0, 5, 2 }), 2.5);
+    EXPECT_EQ(tensor.get({ 1, 5, 2 }), 0.0);
+
+    std::vector<std::array<unsigned int, 3>> order;
+    tensor.for_each([&](const std::array<unsigned int, 3>& coords, double) { order.push_back(coords); });
+    EXPECT_EQ(order, (std::vector<std::array<unsigned int, 3>> { { 0, 5, 1 }, { 0, 5, 2 }, { 3, 0, 0 }, { 3, 999, 6 } }));
+
+    using Wide = SparseTensor<int, 3>;
+    EXPECT_THROW(Wide(0, { ~0u, ~0u, 2 }), std::invalid_argument);
 }
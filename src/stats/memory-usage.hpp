@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Bytes a container holds, split three ways:
+//
+//   payload    sizeof(T) for every element stored
+//   overhead   what the layout adds per element and per container: links,
+//              node heights, hash keys, shared_ptr control blocks, index
+//              arrays and the container object itself
+//   slack      capacity reserved but unused, plus what the allocator adds
+//              to every block (see allocated_bytes)
+//
+// Memory owned by the elements themselves, the characters of a
+// std::string, is not followed. The figures are computed from the layout,
+// not measured, so they hold for a glibc heap on a 64 bit target.
+struct MemoryUsage {
+    uint64_t m_elements = 0;
+    uint64_t m_payload = 0;
+    uint64_t m_overhead = 0;
+    uint64_t m_slack = 0;
+
+    uint64_t total() const
+    {
+        return m_payload + m_overhead + m_slack;
+    }
+
+    double bytes_per_element() const
+    {
+        return m_elements == 0 ? 0 : double(total()) / m_elements;
+    }
+
+    MemoryUsage& operator+=(const MemoryUsage& other)
+    {
+        m_elements += other.m_elements;
+        m_payload += other.m_payload;
+        m_overhead += other.m_overhead;
+        m_slack += other.m_slack;
+        return *this;
+    }
+
+    // Accounts the allocator side of count heap blocks of bytes each, the
+    // bytes themselves go to payload or overhead by the caller.
+    void allocations(uint64_t bytes, uint64_t count = 1);
+};
+
+// Heap bytes taken by a malloc or operator new of bytes. glibc puts an
+// 8 byte size header in front of every chunk, rounds chunks to 16 bytes and
+// never hands out less than 32.
+inline uint64_t allocated_bytes(uint64_t bytes)
+{
+    return std::max<uint64_t>(32, (bytes + 8 + 15) & ~uint64_t(15));
+}
+
+inline void MemoryUsage::allocations(uint64_t bytes, uint64_t count)
+{
+    m_slack += count * (allocated_bytes(bytes) - bytes);
+}
+
+// Spare capacity of a std::vector plus the allocator's share of its block.
+template <typename V>
+uint64_t vector_slack(const V& vector)
+{
+    uint64_t bytes = vector.capacity() * sizeof(typename V::value_type);
+    uint64_t spare = (vector.capacity() - vector.size()) * sizeof(typename V::value_type);
+    return bytes == 0 ? 0 : spare + allocated_bytes(bytes) - bytes;
+}
+
+// std::make_shared puts the object right after its control block, which in
+// libstdc++ is a vtable pointer and the use and weak counts.
+inline constexpr uint64_t SHARED_CONTROL_BLOCK = sizeof(void*) + 2 * sizeof(int);
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Operation counters and latency histograms for the containers, compiled in
+// only on request:
+//
+//   -DDS_ENABLE_STATS     counts allocations, rotations, comparisons, node
+//                         visits and resizes per container instance
+//   -DDS_ENABLE_LATENCY   also times every operation into a histogram,
+//                         implies DS_ENABLE_STATS
+//
+// Without them every hook is an empty inline function on an empty member,
+// so the containers compile to the same code and keep their size. The
+// counters are plain integers, like the containers they are not thread safe.
+// Define the macros the same way in every translation unit of a program.
+
+#if defined(DS_ENABLE_LATENCY) && !defined(DS_ENABLE_STATS)
+#define DS_ENABLE_STATS
+#endif
+
+// Log-linear histogram in the style of HdrHistogram. Values below 32 get a
+// bucket each, above that every power of two is split into 16 buckets, so
+// any recorded value is known to within 1/16 of itself. 976 buckets cover
+// the whole uint64_t range.
+class LatencyHistogram {
+private:
+    static constexpr unsigned int SUB_BITS = 5;
+    static constexpr uint64_t SUB_COUNT = 1 << SUB_BITS;
+    static constexpr uint64_t HALF_COUNT = SUB_COUNT / 2;
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+    uint64_t m_sum = 0;
+
+public:
+    static constexpr uint64_t BUCKETS = SUB_COUNT + (64 - SUB_BITS) * HALF_COUNT;
+
+    static uint64_t bucket(uint64_t value)
+    {
+        if (value < SUB_COUNT)
+            return value;
+        unsigned int shift = 64 - __builtin_clzll(value) - SUB_BITS;
+        return SUB_COUNT + (shift - 1) * HALF_COUNT + ((value >> shift) - HALF_COUNT);
+    }
+
+    // Smallest and largest value falling into a bucket.
+    static uint64_t lowest(uint64_t bucket)
+    {
+        if (bucket < SUB_COUNT)
+            return bucket;
+        unsigned int shift = (bucket - SUB_COUNT) / HALF_COUNT + 1;
+        return ((bucket - SUB_COUNT) % HALF_COUNT + HALF_COUNT) << shift;
+    }
+
+    static uint64_t highest(uint64_t bucket)
+    {
+        return bucket + 1 == BUCKETS ? UINT64_MAX : lowest(bucket + 1) - 1;
+    }
+
+    void record(uint64_t value)
+    {
+        if (m_counts.empty())
+            m_counts.resize(BUCKETS, 0);
+        m_counts[bucket(value)]++;
+        m_total++;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+        m_sum += value;
+    }
+
+    uint64_t count() const { return m_total; }
+    uint64_t min() const { return m_total == 0 ? 0 : m_min; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_total == 0 ? 0 : double(m_sum) / m_total; }
+
+    // Value at or below which the fraction p of the records lie, reported as
+    // the top of its bucket and never above the largest record.
+    uint64_t percentile(double p) const
+    {
+        if (m_total == 0)
+            return 0;
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(p * m_total + 0.5));
+        uint64_t seen = 0;
+        for (uint64_t i = 0; i < BUCKETS; i++) {
+            seen += m_counts[i];
+            if (seen >= rank)
+                return std::min(highest(i), m_max);
+        }
+        return m_max;
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        if (other.m_total == 0)
+            return;
+        if (m_counts.empty())
+            m_counts.resize(BUCKETS, 0);
+        for (uint64_t i = 0; i < BUCKETS; i++)
+            m_counts[i] += other.m_counts[i];
+        m_total += other.m_total;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+        m_sum += other.m_sum;
+    }
+};
+
+enum class Operation {
+    Insert,
+    Remove,
+    Lookup,
+};
+
+// What a container reports. Counters that do not apply to it stay zero, the
+// histograms stay empty unless DS_ENABLE_LATENCY is defined.
+struct ContainerStats {
+    uint64_t m_allocations = 0;
+    uint64_t m_deallocations = 0;
+    uint64_t m_rotations = 0;
+    uint64_t m_comparisons = 0;
+    uint64_t m_visits = 0;
+    uint64_t m_resizes = 0;
+    LatencyHistogram m_insert;
+    LatencyHistogram m_remove;
+    LatencyHistogram m_lookup;
+
+    // Adds the allocation and resize counts of a container used as storage,
+    // e.g. the MyArray under a heap.
+    void add_storage(const ContainerStats& storage)
+    {
+        m_allocations += storage.m_allocations;
+        m_deallocations += storage.m_deallocations;
+        m_resizes += storage.m_resizes;
+    }
+
+    LatencyHistogram& latency(Operation operation)
+    {
+        switch (operation) {
+        case Operation::Insert:
+            return m_insert;
+        case Operation::Remove:
+            return m_remove;
+        default:
+            return m_lookup;
+        }
+    }
+};
+
+#ifdef DS_ENABLE_STATS
+
+// Times the enclosing scope into one of the histograms. Operations built on
+// other public ones, push_back on an empty list calling push_front, nest
+// their timers, only the outermost one records.
+class ScopedLatency {
+private:
+#ifdef DS_ENABLE_LATENCY
+    LatencyHistogram* m_histogram;
+    unsigned int& m_depth;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    ScopedLatency(LatencyHistogram& histogram, unsigned int& depth)
+        : m_histogram(depth == 0 ? &histogram : nullptr)
+        , m_depth(depth)
+    {
+        m_depth++;
+        if (m_histogram != nullptr)
+            m_start = std::chrono::steady_clock::now();
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+
+    ~ScopedLatency()
+    {
+        m_depth--;
+        if (m_histogram == nullptr)
+            return;
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+#else
+public:
+    ScopedLatency(LatencyHistogram&, unsigned int&) { }
+    ~ScopedLatency() { }
+#endif
+};
+
+class StatsRecorder {
+private:
+    ContainerStats m_stats;
+    unsigned int m_depth = 0;
+
+public:
+    static constexpr bool enabled = true;
+
+    void allocation(uint64_t count = 1) { m_stats.m_allocations += count; }
+    void deallocation(uint64_t count = 1) { m_stats.m_deallocations += count; }
+    void rotation() { m_stats.m_rotations++; }
+    void comparison(uint64_t count = 1) { m_stats.m_comparisons += count; }
+    void visit(uint64_t count = 1) { m_stats.m_visits += count; }
+    void resize() { m_stats.m_resizes++; }
+
+    ScopedLatency time(Operation operation) { return ScopedLatency(m_stats.latency(operation), m_depth); }
+
+    const ContainerStats& stats() const { return m_stats; }
+    void reset() { m_stats = ContainerStats(); }
+};
+
+#else
+
+class ScopedLatency {
+public:
+    ~ScopedLatency() { }
+};
+
+class StatsRecorder {
+public:
+    static constexpr bool enabled = false;
+
+    void allocation(uint64_t = 1) { }
+    void deallocation(uint64_t = 1) { }
+    void rotation() { }
+    void comparison(uint64_t = 1) { }
+    void visit(uint64_t = 1) { }
+    void resize() { }
+
+    ScopedLatency time(Operation) { return {}; }
+
+    ContainerStats stats() const { return {}; }
+    void reset() { }
+};
+
+#endif
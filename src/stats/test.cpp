@@ -0,0 +1,274 @@
+#define DS_ENABLE_LATENCY
+#include "../array/array.hpp"
+#include "../avl-tree/avl-tree.hpp"
+#include "../binary-search-tree/binary-search-tree.hpp"
+#include "../intrusive-list/intrusive-list.hpp"
+#include "../queue/queue-arr.hpp"
+#include "../queue/queue-deque.hpp"
+#include "../queue/queue-mpmc.hpp"
+#include "../sparse-matrix/coo-builder.hpp"
+#include "../heap/heap.hpp"
+#include "../linked-list/linked-list.hpp"
+#include "../sparse-matrix/sparse-matrix.hpp"
+#include "memory-usage.hpp"
+#include "stats.hpp"
+#include <gtest/gtest.h>
+
+TEST(LatencyHistogram, Buckets)
+{
+    for (uint64_t value = 0; value < 32; value++) {
+        EXPECT_EQ(LatencyHistogram::bucket(value), value);
+    }
+    uint64_t previous = 0;
+    for (uint64_t value : { 32ull, 33ull, 63ull, 64ull, 1000ull, 123456789ull, 1ull << 40, ~0ull }) {
+        uint64_t bucket = LatencyHistogram::bucket(value);
+        ASSERT_LT(bucket, LatencyHistogram::BUCKETS);
+        EXPECT_GE(bucket, previous);
+        EXPECT_LE(LatencyHistogram::lowest(bucket), value);
+        EXPECT_GE(LatencyHistogram::highest(bucket), value);
+        EXPECT_LE(LatencyHistogram::highest(bucket) - LatencyHistogram::lowest(bucket), value / 16);
+        previous = bucket;
+    }
+    EXPECT_EQ(LatencyHistogram::bucket(~0ull), LatencyHistogram::BUCKETS - 1);
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5), 0);
+    for (uint64_t value = 1; value <= 1000; value++) {
+        histogram.record(value * 100);
+    }
+    EXPECT_EQ(histogram.count(), 1000);
+    EXPECT_EQ(histogram.min(), 100);
+    EXPECT_EQ(histogram.max(), 100000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 50050);
+    EXPECT_NEAR(histogram.percentile(0.5), 50000, 50000 / 16);
+    EXPECT_NEAR(histogram.percentile(0.99), 99000, 99000 / 16);
+    EXPECT_EQ(histogram.percentile(1), 100000);
+
+    LatencyHistogram other;
+    other.record(7);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.count(), 1001);
+    EXPECT_EQ(histogram.min(), 7);
+    EXPECT_EQ(histogram.percentile(0), 7);
+}
+
+TEST(ContainerStats, MyArray)
+{
+    MyArray<int> array;
+    for (int i = 0; i < 100; i++) {
+        array.push(i);
+    }
+    ContainerStats stats = array.stats();
+    // Capacity doubles from 1 when it fills up: 2, 4, ..., 128.
+    EXPECT_EQ(stats.m_resizes, 7);
+    EXPECT_EQ(stats.m_allocations, 8);
+    EXPECT_EQ(stats.m_insert.count(), 100);
+
+    array.reset_stats();
+    EXPECT_EQ(array.find(41), 41);
+    EXPECT_EQ(array.stats().m_comparisons, 42);
+    EXPECT_EQ(array.stats().m_lookup.count(), 1);
+    EXPECT_EQ(array.stats().m_resizes, 0);
+}
+
+TEST(ContainerStats, LinkedList)
+{
+    LinkedList<int> list;
+    for (int i = 0; i < 10; i++) {
+        list.push_back(i);
+    }
+    EXPECT_EQ(list.stats().m_allocations, 10);
+    // push_back on the empty list goes through push_front, timed once.
+    EXPECT_EQ(list.stats().m_insert.count(), 10);
+
+    list.value_at(6);
+    EXPECT_EQ(list.stats().m_visits, 6);
+    EXPECT_EQ(list.stats().m_lookup.count(), 1);
+
+    list.sort([](int left, int right) { return left > right; });
+    EXPECT_GT(list.stats().m_comparisons, 0);
+    EXPECT_EQ(list.front(), 9);
+
+    list.pop_back();
+    list.remove_value(4);
+    EXPECT_EQ(list.stats().m_deallocations, 2);
+    EXPECT_EQ(list.stats().m_remove.count(), 2);
+}
+
+TEST(ContainerStats, Trees)
+{
+    AVLTree<int> avl;
+    BinarySTree<int> bst;
+    for (int i = 0; i < 127; i++) {
+        avl.insert(i);
+        bst.insert(i);
+    }
+    // Sorted keys make every insert past the second one rotate once.
+    EXPECT_EQ(avl.stats().m_rotations, 120);
+    EXPECT_EQ(avl.stats().m_allocations, 2 * 127);
+    EXPECT_EQ(bst.stats().m_rotations, 0);
+    EXPECT_EQ(bst.stats().m_visits, 127 * 126 / 2);
+
+    avl.resetStats();
+    bst.resetStats();
+    EXPECT_TRUE(avl.contains(126));
+    EXPECT_TRUE(bst.contains(126));
+    // The AVL tree is perfect, the other one a list.
+    EXPECT_EQ(avl.stats().m_visits, 7);
+    EXPECT_EQ(bst.stats().m_visits, 127);
+    EXPECT_EQ(avl.stats().m_comparisons, 14);
+    EXPECT_EQ(avl.stats().m_lookup.count(), 1);
+
+    avl.remove(0);
+    EXPECT_EQ(avl.stats().m_deallocations, 2);
+    EXPECT_EQ(avl.stats().m_remove.count(), 1);
+}
+
+TEST(ContainerStats, Heap)
+{
+    DaryHeap<int, 2> heap;
+    for (int i = 0; i < 15; i++) {
+        heap.push(i);
+    }
+    ContainerStats stats = heap.stats();
+    EXPECT_GT(stats.m_comparisons, 0);
+    EXPECT_EQ(stats.m_resizes, 4);
+    EXPECT_EQ(stats.m_insert.count(), 15);
+
+    heap.reset_stats();
+    heap.pop();
+    EXPECT_EQ(heap.stats().m_resizes, 0);
+    EXPECT_EQ(heap.stats().m_remove.count(), 1);
+
+    AddressableHeap<int> addressable;
+    int handle = addressable.push(5);
+    addressable.push(3);
+    addressable.decrease_key(handle, 1);
+    EXPECT_EQ(addressable.top(), 1);
+    EXPECT_GE(addressable.stats().m_comparisons, 2);
+    EXPECT_GT(addressable.stats().m_allocations, 0);
+}
+
+TEST(ContainerStats, SparceMatrix)
+{
+    SparceMatrix<int> matrix(0, 100, 100);
+    for (unsigned int i = 0; i < 100; i++) {
+        matrix.insert(i, i, 1);
+    }
+    ContainerStats stats = matrix.stats();
+    // 16 slots to start with, doubled whenever more than 3/4 full.
+    EXPECT_EQ(stats.m_resizes, 4);
+    EXPECT_EQ(stats.m_allocations, 5);
+    EXPECT_GE(stats.m_visits, 100);
+    EXPECT_EQ(stats.m_insert.count(), 100);
+
+    matrix.reset_stats();
+    matrix.get(5, 5);
+    matrix.erase(5, 5);
+    EXPECT_EQ(matrix.stats().m_lookup.count(), 1);
+    EXPECT_EQ(matrix.stats().m_remove.count(), 1);
+    EXPECT_GE(matrix.stats().m_visits, 2);
+}
+
+TEST(MemoryUsage, Allocator)
+{
+    EXPECT_EQ(allocated_bytes(1), 32);
+    EXPECT_EQ(allocated_bytes(24), 32);
+    EXPECT_EQ(allocated_bytes(25), 48);
+    EXPECT_EQ(allocated_bytes(4096), 4112);
+}
+
+TEST(MemoryUsage, MyArray)
+{
+    MyArray<int> array;
+    for (int i = 0; i < 100; i++) {
+        array.push(i);
+    }
+    MemoryUsage usage = array.memory_usage();
+    EXPECT_EQ(usage.m_elements, 100);
+    EXPECT_EQ(usage.m_payload, 400);
+    EXPECT_EQ(usage.m_overhead, sizeof(array));
+    // 28 unused ints of the 128 and the chunk header rounded to 16.
+    EXPECT_EQ(usage.m_slack, 28 * 4 + 16);
+    EXPECT_EQ(usage.total(), 400 + sizeof(array) + 128);
+}
+
+TEST(MemoryUsage, Nodes)
+{
+    LinkedList<int> list;
+    AVLTree<int> tree;
+    for (int i = 0; i < 10; i++) {
+        list.push_back(i);
+        tree.insert(i);
+    }
+    MemoryUsage usage = list.memory_usage();
+    EXPECT_EQ(usage.m_elements, 10);
+    EXPECT_EQ(usage.m_payload, 40);
+    // int and two pointers in a 24 byte node, a 32 byte chunk each.
+    EXPECT_EQ(usage.m_overhead, 10 * 20 + sizeof(list));
+    EXPECT_EQ(usage.m_slack, 10 * 8);
+
+    usage = tree.memoryUsage();
+    EXPECT_EQ(usage.m_elements, 10);
+    EXPECT_EQ(usage.m_payload, 40);
+    EXPECT_GT(usage.bytes_per_element(), 100);
+    tree.remove(3);
+    EXPECT_EQ(tree.memoryUsage().m_elements, 9);
+
+    struct Item {
+        ListHook m_hook;
+        int m_value;
+    };
+    Item items[3];
+    IntrusiveList<Item, offsetof(Item, m_hook)> intrusive;
+    for (Item& item : items) {
+        intrusive.push_back(item);
+    }
+    usage = intrusive.memory_usage();
+    EXPECT_EQ(usage.m_elements, 3);
+    EXPECT_EQ(usage.m_payload, 0);
+    EXPECT_EQ(usage.m_overhead, 4 * sizeof(ListHook));
+    intrusive.clear();
+}
+
+TEST(MemoryUsage, Queues)
+{
+    ArrQueue<int> ring(16);
+    MPMCQueue<int> bounded(16);
+    BlockDeque<int> deque;
+    for (int i = 0; i < 5; i++) {
+        ring.enqueue(i);
+        bounded.try_enqueue(i);
+        deque.push_back(i);
+    }
+    EXPECT_EQ(ring.memory_usage().m_elements, 5);
+    EXPECT_EQ(ring.memory_usage().m_slack, 11 * 4 + 16);
+    EXPECT_EQ(bounded.memory_usage().m_elements, 5);
+    EXPECT_EQ(bounded.memory_usage().m_payload, 20);
+    EXPECT_EQ(deque.memory_usage().m_elements, 5);
+    EXPECT_GE(deque.memory_usage().m_slack, 4096 - 20);
+}
+
+TEST(MemoryUsage, SparseLayouts)
+{
+    SparceMatrix<double> matrix(0, 100, 100);
+    COOBuilder<double> builder(0, 100, 100);
+    for (unsigned int i = 0; i < 100; i++) {
+        matrix.insert(i, (i * 7) % 100, 1);
+        builder.add(i, (i * 7) % 100, 1);
+    }
+    MemoryUsage hash = matrix.memory_usage();
+    MemoryUsage csr = to_csr(matrix).memory_usage();
+    MemoryUsage coo = builder.build().memory_usage();
+    for (const MemoryUsage& usage : { hash, csr, coo }) {
+        EXPECT_EQ(usage.m_elements, 100);
+        EXPECT_EQ(usage.m_payload, 800);
+    }
+    // 256 slots of key and value, a third of them empty.
+    EXPECT_EQ(hash.m_slack, 156 * 16 + 16);
+    EXPECT_LT(csr.total(), hash.total());
+    EXPECT_LT(coo.total(), hash.total());
+}
@@ -0,0 +1,71 @@
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+
+// Pool sizes 1, 2, 4, ... up to the core count.
+static void pool_sizes(benchmark::internal::Benchmark* bench)
+{
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads < cores; threads *= 2) {
+        bench->Arg(threads);
+    }
+    bench->Arg(cores);
+}
+
+static int64_t fib(ThreadPool& pool, int n)
+{
+    if (n < 20) {
+        return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2);
+    }
+    int64_t left, right;
+    pool.invoke([&]() { left = fib(pool, n - 1); }, [&]() { right = fib(pool, n - 2); });
+    return left + right;
+}
+
+static void fill(MyArray<int>& array, int count)
+{
+    std::mt19937 random(42);
+    while (!array.is_empty()) {
+        array.pop();
+    }
+    for (int i = 0; i < count; i++) {
+        array.push(random());
+    }
+}
+
+// Fork-join overhead: every level above the cutoff is an invoke.
+static void BM_Fib(benchmark::State& state)
+{
+    ThreadPool pool(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fib(pool, 30));
+    }
+}
+BENCHMARK(BM_Fib)->Apply(pool_sizes)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Reduce(benchmark::State& state)
+{
+    ThreadPool pool(state.range(0));
+    MyArray<int> array;
+    fill(array, 1 << 22);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parallel_reduce(pool, array, int64_t(0), std::plus<int64_t>()));
+    }
+    state.SetBytesProcessed(state.iterations() * array.size() * sizeof(int));
+}
+BENCHMARK(BM_Reduce)->Apply(pool_sizes)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Sort(benchmark::State& state)
+{
+    ThreadPool pool(state.range(0));
+    MyArray<int> array;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill(array, 1 << 20);
+        state.ResumeTiming();
+        parallel_sort(pool, array);
+    }
+    state.SetItemsProcessed(state.iterations() * array.size());
+}
+BENCHMARK(BM_Sort)->Apply(pool_sizes)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,70 @@
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+class ThreadPoolTest : public ::testing::Test {
+protected:
+    ThreadPool pool { 4 };
+};
+
+static int64_t fib(ThreadPool& pool, int n)
+{
+    if (n < 2)
+        return n;
+    int64_t left, right;
+    pool.invoke([&]() { left = fib(pool, n - 1); }, [&]() { right = fib(pool, n - 2); });
+    return left + right;
+}
+
+TEST_F(ThreadPoolTest, Invoke)
+{
+    EXPECT_EQ(pool.size(), 4);
+    EXPECT_EQ(fib(pool, 20), 6765);
+}
+
+TEST_F(ThreadPoolTest, ParallelFor)
+{
+    std::vector<std::atomic<int>> hits(100000);
+    pool.parallel_for(0, hits.size(), 1000, [&](int64_t begin, int64_t end) {
+        EXPECT_LE(end - begin, 1000);
+        for (int64_t i = begin; i < end; i++) {
+            hits[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (auto& hit : hits) {
+        ASSERT_EQ(hit.load(), 1);
+    }
+}
+
+TEST_F(ThreadPoolTest, ForEachAndReduce)
+{
+    MyArray<int64_t> array;
+    for (int i = 0; i < 100000; i++) {
+        array.push(i);
+    }
+
+    parallel_for_each(pool, array, [](int64_t& value) { value *= 2; }, 1000);
+    int64_t sum = parallel_reduce(pool, array, int64_t(0), [](int64_t a, int64_t b) { return a + b; }, 1000);
+    EXPECT_EQ(sum, int64_t(99999) * 100000);
+    EXPECT_EQ(array[500], 1000);
+}
+
+TEST_F(ThreadPoolTest, Sort)
+{
+    MyArray<int> array;
+    std::vector<int> expected;
+    std::mt19937 random(3);
+    for (int i = 0; i < 200000; i++) {
+        int value = random() % 5000;
+        array.push(value);
+        expected.push_back(value);
+    }
+
+    parallel_sort(pool, array, std::less<int>(), 512);
+    std::sort(expected.begin(), expected.end());
+    for (int i = 0; i < array.size(); i++) {
+        ASSERT_EQ(array[i], expected[i]);
+    }
+}
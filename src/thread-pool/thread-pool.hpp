@@ -0,0 +1,293 @@
+#pragma once
+
+#include "../array/array.hpp"
+#include "../queue/queue-deque.hpp"
+#include "../queue/queue-work-stealing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fork-join thread pool. Every worker owns a WorkStealingDeque: tasks it
+// forks go to the bottom of its own deque and are popped back LIFO, while
+// idle workers steal the oldest (and usually biggest) tasks from the top of
+// the others. Tasks forked from threads outside the pool go through a
+// shared injection queue.
+//
+// A task is a function pointer plus the state around it; fork-join tasks
+// live on the stack of the thread that forks them, which waits for them
+// before returning, so forking allocates nothing.
+class ThreadPool {
+public:
+    struct Task {
+        void (*m_run)(Task*);
+        std::atomic<bool> m_done;
+
+        Task(void (*run)(Task*))
+            : m_run(run)
+            , m_done(false) {};
+    };
+
+    ThreadPool(unsigned int threads = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    unsigned int size() { return m_workers.size(); }
+
+    // Queues the task; the caller keeps it alive until it is done.
+    void submit(Task* task);
+
+    // Runs other tasks until task is done.
+    void wait(Task* task);
+
+    // Runs left and right, possibly in parallel, and returns when both
+    // finished.
+    template <typename Left, typename Right>
+    void invoke(Left&& left, Right&& right);
+
+    // Calls fn(begin, end) on chunks of at most grain indices covering
+    // [first, last), splitting the range in halves.
+    template <typename Fn>
+    void parallel_for(int64_t first, int64_t last, int64_t grain, Fn&& fn);
+
+private:
+    struct alignas(64) Worker {
+        WorkStealingDeque<Task*> m_deque;
+        std::thread m_thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_injection_mutex;
+    BlockDeque<Task*> m_injection;
+    std::atomic<size_t> m_injected;
+    std::atomic<bool> m_stop;
+
+    // Idle workers sleep on m_epoch, which every submit bumps.
+    std::atomic<uint32_t> m_epoch;
+    std::atomic<int> m_sleepers;
+
+    static Worker*& current()
+    {
+        thread_local Worker* worker = nullptr;
+        return worker;
+    }
+
+    static void run(Task* task)
+    {
+        task->m_run(task);
+        task->m_done.store(true, std::memory_order_release);
+    }
+
+    Task* find_task(Worker* self, unsigned int& seed);
+    void work(Worker* self, unsigned int index);
+};
+
+inline ThreadPool::ThreadPool(unsigned int threads)
+    : m_injected(0)
+    , m_stop(false)
+    , m_epoch(0)
+    , m_sleepers(0)
+{
+    threads = std::max(threads, 1u);
+    for (unsigned int i = 0; i < threads; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        Worker* worker = m_workers[i].get();
+        worker->m_thread = std::thread([this, worker, i]() { work(worker, i); });
+    }
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    m_stop.store(true, std::memory_order_seq_cst);
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    m_epoch.notify_all();
+    for (auto& worker : m_workers) {
+        worker->m_thread.join();
+    }
+}
+
+inline void ThreadPool::submit(Task* task)
+{
+    Worker* self = current();
+    if (self != nullptr) {
+        self->m_deque.push(task);
+    } else {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        m_injection.push_back(task);
+        m_injected.fetch_add(1, std::memory_order_release);
+    }
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0)
+        m_epoch.notify_one();
+}
+
+// Own deque first, then the injection queue, then a steal attempt on every
+// other worker starting from a random one.
+inline ThreadPool::Task* ThreadPool::find_task(Worker* self, unsigned int& seed)
+{
+    Task* task;
+    if (self != nullptr && self->m_deque.pop(task))
+        return task;
+
+    if (m_injected.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        if (!m_injection.empty()) {
+            task = m_injection.front();
+            m_injection.pop_front();
+            m_injected.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    seed = seed * 1103515245 + 12345;
+    const size_t count = m_workers.size();
+    const size_t start = (seed >> 16) % count;
+    for (size_t i = 0; i < count; i++) {
+        Worker* victim = m_workers[(start + i) % count].get();
+        if (victim != self && victim->m_deque.steal(task))
+            return task;
+    }
+    return nullptr;
+}
+
+inline void ThreadPool::work(Worker* self, unsigned int index)
+{
+    current() = self;
+    unsigned int seed = index + 1;
+    int idle = 0;
+    while (!m_stop.load(std::memory_order_acquire)) {
+        Task* task = find_task(self, seed);
+        if (task != nullptr) {
+            run(task);
+            idle = 0;
+            continue;
+        }
+        if (++idle < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint32_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        task = find_task(self, seed);
+        if (task == nullptr && !m_stop.load(std::memory_order_seq_cst))
+            m_epoch.wait(epoch, std::memory_order_seq_cst);
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (task != nullptr)
+            run(task);
+        idle = 0;
+    }
+}
+
+inline void ThreadPool::wait(Task* task)
+{
+    Worker* self = current();
+    unsigned int seed = reinterpret_cast<uintptr_t>(task) >> 4;
+    while (!task->m_done.load(std::memory_order_acquire)) {
+        Task* other = find_task(self, seed);
+        if (other != nullptr)
+            run(other);
+        else
+            std::this_thread::yield();
+    }
+}
+
+template <typename Left, typename Right>
+void ThreadPool::invoke(Left&& left, Right&& right)
+{
+    struct Closure : Task {
+        Right* m_fn;
+
+        Closure(Right* fn)
+            : Task([](Task* task) { (*static_cast<Closure*>(task)->m_fn)(); })
+            , m_fn(fn) {};
+    };
+
+    Closure task(&right);
+    submit(&task);
+    left();
+    wait(&task);
+}
+
+template <typename Fn>
+void ThreadPool::parallel_for(int64_t first, int64_t last, int64_t grain, Fn&& fn)
+{
+    if (last - first <= std::max<int64_t>(grain, 1)) {
+        if (first < last)
+            fn(first, last);
+        return;
+    }
+    int64_t middle = first + (last - first) / 2;
+    invoke([&]() { parallel_for(first, middle, grain, fn); },
+        [&]() { parallel_for(middle, last, grain, fn); });
+}
+
+// MyArray algorithms running on a ThreadPool.
+
+// Calls fn on every element.
+template <typename T, typename Fn>
+void parallel_for_each(ThreadPool& pool, MyArray<T>& array, Fn fn, int grain = 4096)
+{
+    T* data = array.data();
+    pool.parallel_for(0, array.size(), grain, [&](int64_t begin, int64_t end) {
+        std::for_each(data + begin, data + end, fn);
+    });
+}
+
+// Folds the elements with op, which must be associative.
+template <typename T, typename R, typename Op>
+R parallel_reduce(ThreadPool& pool, const T* data, int64_t first, int64_t last, R init, Op op, int64_t grain)
+{
+    if (last - first <= grain) {
+        R result = init;
+        for (int64_t i = first; i < last; i++) {
+            result = op(result, data[i]);
+        }
+        return result;
+    }
+    int64_t middle = first + (last - first) / 2;
+    R left, right;
+    pool.invoke([&]() { left = parallel_reduce(pool, data, first, middle, init, op, grain); },
+        [&]() { right = parallel_reduce(pool, data, middle, last, init, op, grain); });
+    return op(left, right);
+}
+
+template <typename T, typename R, typename Op>
+R parallel_reduce(ThreadPool& pool, MyArray<T>& array, R init, Op op, int grain = 4096)
+{
+    return parallel_reduce(pool, array.data(), 0, array.size(), init, op, grain);
+}
+
+// Sorts with a fork-join quicksort: both sides of every partition are
+// sorted in parallel until they are small enough for std::sort.
+template <typename T, typename Compare>
+void parallel_sort(ThreadPool& pool, T* first, T* last, Compare compare, int64_t grain)
+{
+    if (last - first <= grain) {
+        std::sort(first, last, compare);
+        return;
+    }
+
+    // Median of three, then a three way partition so runs of equal keys
+    // never get split again.
+    T* middle = first + (last - first) / 2;
+    T pivot = std::max(std::min(*first, *middle, compare), std::min(std::max(*first, *middle, compare), *(last - 1), compare), compare);
+    T* low = std::partition(first, last, [&](const T& value) { return compare(value, pivot); });
+    T* high = std::partition(low, last, [&](const T& value) { return !compare(pivot, value); });
+    pool.invoke([&]() { parallel_sort(pool, first, low, compare, grain); },
+        [&]() { parallel_sort(pool, high, last, compare, grain); });
+}
+
+template <typename T, typename Compare = std::less<T>>
+void parallel_sort(ThreadPool& pool, MyArray<T>& array, Compare compare = Compare(), int grain = 4096)
+{
+    parallel_sort(pool, array.data(), array.data() + array.size(), compare, grain);
+}